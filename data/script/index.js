@@ -2,7 +2,7 @@
 Quinton Nelson
 3/15/2024
 this file contains JQuery for the index page
-Contains functions to update the time on the page, fetch remaining ring times, and fetch server messages
+Contains functions to update the time on the page, and fetch remaining ring times and server messages in one request
 */
 
 
@@ -65,41 +65,55 @@ $(document).ready(function() {
     }
     
 
+    var messageCount = 0; // Number of the newest message shown, only newer ones are sent again
+
     /**
-     * The function fetches today's remaining ring times, filters out past times, and initiates a countdown
-     * to the next ring time if available.
-     * @returns The `fetchTodayRemainingRingTimes` function makes an AJAX request to the server to get the
-     * remaining ring times for today. The response is expected to be a comma-separated list of times in
-     * the format "HH:MM,HH:MM,...". The function then filters out past times, sorts the remaining times,
-     * and starts a countdown to the next ring time if there are any remaining times. If
+     * The function `fetchState` gets everything the page shows in one request: the remaining ring times
+     * of today and the system messages the page has not shown yet.
      */
-    function fetchTodayRemainingRingTimes() {
+    function fetchState() {
         $.ajax({
-            url: '/getTodayRemainingRingTimes',
+            url: '/api/state',
             type: 'GET',
-            success: function(response) {
-                // Response is a comma-separated list of times "HH:MM,HH:MM,..."
-                var times = response.split(',');
-                // Filter out past times and sort
-                var now = new Date();
-                times = times.filter(function(timeStr) {
-                    var todayStr = now.toISOString().split('T')[0]; // "YYYY-MM-DD"
-                    var timeDate = new Date(todayStr + 'T' + timeStr + ':00');
-                    return now < timeDate;
-                });
-
-                if (times.length > 0) {
-                    updateCountdown(times[0]); // Start countdown to the next ring time
-                } else {
-                    $('#countdown').text("No more rings today");
-                }
+            data: { since: messageCount },
+            dataType: 'json',
+            success: function(state) {
+                showRemainingRingTimes(state.rings);
+                showServerMessages(state.messages, state.messageCount);
             },
             error: function(xhr, status, error) {
-                console.error("Failed to fetch remaining ring times:", error);
+                console.error("Failed to fetch device state:", error);
+                if (messageCount === 0) {
+                    $('#messageList').empty() // Clear the list
+                                    .append($('<li class="list-group-item bg-dark text-white"></li>').text("Failed to load system messages."));
+                }
             }
         });
     }
 
+    /**
+     * The function `showRemainingRingTimes` filters out past ring times and starts a countdown to the
+     * next one if there is any.
+     * @param rings - Today's remaining ring times as minutes of the day.
+     */
+    function showRemainingRingTimes(rings) {
+        // Convert the minutes to "HH:MM" and filter out past times
+        var now = new Date();
+        var todayStr = now.toISOString().split('T')[0]; // "YYYY-MM-DD"
+        var times = rings.map(function(minute) {
+            return String(Math.floor(minute / 60)).padStart(2, '0') + ':' + String(minute % 60).padStart(2, '0');
+        }).filter(function(timeStr) {
+            var timeDate = new Date(todayStr + 'T' + timeStr + ':00');
+            return now < timeDate;
+        });
+
+        if (times.length > 0) {
+            updateCountdown(times[0]); // Start countdown to the next ring time
+        } else {
+            $('#countdown').text("No more rings today");
+        }
+    }
+
     /**
      * The function `updateCountdown` sets up a countdown interval to display the time remaining until a
      * specified next ring time.
@@ -127,7 +141,7 @@ $(document).ready(function() {
 
             if (distance < 0) {
                 clearInterval(window.countdownInterval);
-                fetchTodayRemainingRingTimes(); // Fetch new times and update countdown
+                fetchState(); // Fetch new times and messages and update countdown
                 return;
             }
 
@@ -140,33 +154,24 @@ $(document).ready(function() {
     }
 
     /**
-     * The function `fetchServerMessages` makes an AJAX request to fetch server messages and displays them
-     * in a list on the webpage, handling errors appropriately.
+     * The function `showServerMessages` adds the new server messages to the list on the webpage.
+     * @param messages - Messages added since the last request.
+     * @param count - Number of the newest message.
      */
-    function fetchServerMessages() {
-        $.ajax({
-            url: '/getServerMessages',
-            type: 'GET',
-            dataType: 'json',
-            success: function(messages) { // Directly receive the array of messages
-                var messageList = $('#messageList');
-                messageList.empty(); // Clear the list before adding new messages
-    
-                messages.forEach(function(message) {
-                    var listItem = $('<li class="list-group-item bg-dark text-white"></li>').text(message);
-                    messageList.append(listItem);
-                });
-            },
-            error: function(xhr, status, error) {
-                console.error("Failed to fetch server messages:", error);
-                $('#messageList').empty() // Clear the list
-                                .append($('<li class="list-group-item bg-dark text-white"></li>').text("Failed to load system messages."));
-            }
+    function showServerMessages(messages, count) {
+        var messageList = $('#messageList');
+        if (messageCount === 0) {
+            messageList.empty(); // Clear the list before adding the first messages
+        }
+
+        messages.forEach(function(message) {
+            var listItem = $('<li class="list-group-item bg-dark text-white"></li>').text(message);
+            messageList.append(listItem);
         });
+        messageCount = count;
     }
 
     updateTime(); // Update the time on the page
-    fetchServerMessages(); // Fetch server messages when the page loads
-    fetchTodayRemainingRingTimes(); // Fetch remaining ring times when the page loads
+    fetchState(); // Fetch ring times and server messages when the page loads
 
 });
\ No newline at end of file
@@ -63,6 +63,11 @@ $(document).ready(function() {
             scheduleData[day] = times;
         });
 
+        // Recurring rules are not editable on this page, send them back unchanged
+        if (globalScheduleData.rules) {
+            scheduleData.rules = globalScheduleData.rules;
+        }
+
         
         checkServerTokenMatch(function(tokenMatches) {
             if (!tokenMatches) {
@@ -123,6 +128,7 @@ $(document).ready(function() {
             daysOfWeek.forEach(day => clearDaySchedule(day));
     
             const scheduleData = JSON.parse(e.target.result);
+            globalScheduleData.rules = scheduleData.rules;
             populateScheduleForm(scheduleData);
         };
         reader.readAsText(file);
@@ -179,8 +185,9 @@ $(document).ready(function() {
     }
     
     function populateScheduleForm(scheduleData) {
-        Object.keys(scheduleData).forEach(day => {
-            const times = scheduleData[day];
+        // Only the day lists are shown, recurring rules are kept in globalScheduleData
+        daysOfWeek.forEach(day => {
+            const times = scheduleData[day] || [];
             times.forEach(time => {
                 addRingTime(day, time);
             });
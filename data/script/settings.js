@@ -5,6 +5,10 @@ this file contains JQuery for the settings page
 */
 
 $(document).ready(function() {
+    // Select the saved LAN sync mode
+    $('#lanSync').val($('#lanSync').data('value'));
+    $('#lowPower').val($('#lowPower').data('value'));
+
     // Get the MAC address from the server
     $('#macAddress').click(function() {
         checkServerTokenMatch(function(tokenMatches) {
@@ -36,10 +40,20 @@ $(document).ready(function() {
         $('#deviceNameError').text('');
         $('#ringDurationError').text('');
         $('#uniqueURLError').text('');
+        $('#timezoneError').text('');
+        $('#ntpServerError').text('');
+        $('#syncURLError').text('');
+        $('#syncIntervalError').text('');
 
         var deviceName = $('#deviceName').val();
         var ringDuration = $('#ringDuration').val();
         var uniqueURL = $('#uniqueURL').val();
+        var timezone = $('#timezone').val();
+        var ntpServer = $('#ntpServer').val();
+        var syncURL = $('#syncURL').val();
+        var syncInterval = parseInt($('#syncInterval').val() || '0', 10);
+        var lanSync = $('#lanSync').val();
+        var lowPower = $('#lowPower').val() == 'on';
 
         // Validate Device Name (alphanumeric and hyphens/underscores only)
         if(!/^[a-zA-Z0-9-_]+$/.test(uniqueURL)) {
@@ -53,6 +67,30 @@ $(document).ready(function() {
             return; // Stop submission
         }
 
+        // Validate Time Zone (POSIX TZ strings start with the zone name, e.g. CST6CDT)
+        if(!/^(<[^>]+>|[a-zA-Z]{3,})/.test(timezone)) {
+            $('#timezoneError').text('Time zone must be a POSIX TZ string.');
+            return; // Stop submission
+        }
+
+        // Validate NTP Server (host name or IP address)
+        if(!/^[a-zA-Z0-9.-]+$/.test(ntpServer)) {
+            $('#ntpServerError').text('NTP server must be a host name or IP address.');
+            return; // Stop submission
+        }
+
+        // Validate Config Server URL (plain http, optional)
+        if(syncURL.length > 0 && (!/^http:\/\/[^\s\/]+(\/\S*)?$/.test(syncURL) || syncURL.length > 99)) {
+            $('#syncURLError').text('Config server URL must start with http:// and be at most 99 characters.');
+            return; // Stop submission
+        }
+
+        // Validate Poll Interval
+        if(isNaN(syncInterval) || syncInterval < 0 || syncInterval > 1440) {
+            $('#syncIntervalError').text('Poll interval must be between 0 and 1440 minutes.');
+            return; // Stop submission
+        }
+
         checkServerTokenMatch(function(tokenMatches) {
             if (!tokenMatches) {
                 showLoginModal();
@@ -71,16 +109,21 @@ $(document).ready(function() {
                 data: JSON.stringify({
                     uniqueURL: uniqueURL,
                     deviceName: deviceName,
-                    ringDuration: ringDuration
+                    ringDuration: ringDuration,
+                    timezone: timezone,
+                    ntpServer: ntpServer,
+                    syncURL: syncURL,
+                    syncInterval: syncInterval,
+                    lanSync: lanSync,
+                    lowPower: lowPower
                 }),
                 success: function(response) {
-                    if (response == "URL saved successfully, device will restart to apply changes") {
-                        alert("Settings updated successfully! Device will restart to apply changes. \n" +
-                                "Your new URL will be: " + uniqueURL + ".local \n" + 
-                                "Redirecting to new url in 10 seconds...");
-                        setTimeout(function() {
-                            window.location.href = "http://" + uniqueURL + ".local";
-                        }, 10000);
+                    if (response == "URL saved successfully, new URL is active") {
+                        alert("Settings updated successfully! \n" +
+                                "Your new URL is: " + uniqueURL + ".local \n" +
+                                "Redirecting to the new URL...");
+                        window.location.href = "http://" + uniqueURL + ".local";
+                        return;
                     }
                     alert("Settings updated successfully!");
                 },
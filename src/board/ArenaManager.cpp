@@ -0,0 +1,127 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the request arena. Memory is handed out by moving an offset forward and is given back
+all at once when the request is answered, so there is nothing to fragment.
+*/
+
+#include "ArenaManager.h"
+
+ArenaManager::ArenaManager() : used(0), lastOffset(0), peakUse(0), active(false), requestCount(0), heapAllocations(0),
+                               heapGrowthCount(0), freeHeapAtStart(0), lastHeapDelta(0) {}
+
+/**
+ * The function `beginRequest` empties the arena for a new request and notes the free heap, so heap that
+ * the request keeps after it was answered can be reported.
+ */
+void ArenaManager::beginRequest() {
+    used = 0;
+    lastOffset = 0;
+    active = true;
+    freeHeapAtStart = ESP.getFreeHeap();
+}
+
+/**
+ * The function `endRequest` gives back everything the request allocated in the arena. Documents of the
+ * request must not be used afterwards.
+ */
+void ArenaManager::endRequest() {
+    if (!active) {
+        return;
+    }
+
+    active = false;
+    used = 0;
+    lastOffset = 0;
+    requestCount++;
+
+    lastHeapDelta = (int32_t)ESP.getFreeHeap() - (int32_t)freeHeapAtStart;
+    if (lastHeapDelta < 0) {
+        heapGrowthCount++;
+    }
+}
+
+/**
+ * The function `allocate` hands out memory from the arena. Outside of a request, or when the arena is
+ * full, the memory comes from the heap instead; during a request that is counted, it means the arena is
+ * too small for what the request needs.
+ *
+ * @param size Number of bytes.
+ *
+ * @return The memory, 4 byte aligned, or nullptr if neither the arena nor the heap has room.
+ */
+void* ArenaManager::allocate(size_t size) {
+    size_t aligned = (size + 3) & ~(size_t)3;
+    if (active && aligned <= ARENA_SIZE - used) {
+        lastOffset = used;
+        used += aligned;
+        if (used > peakUse) {
+            peakUse = used;
+        }
+        return buffer + lastOffset;
+    }
+
+    if (active) {
+        heapAllocations++;
+    }
+    return malloc(size);
+}
+
+/**
+ * The function `reallocate` resizes memory from `allocate`. The most recent arena allocation grows or
+ * shrinks in place, older ones can only shrink.
+ *
+ * @return The resized memory, or nullptr if it could not be resized (the old memory is then unchanged).
+ */
+void* ArenaManager::reallocate(void* pointer, size_t size) {
+    if (!owns(pointer)) {
+        return realloc(pointer, size);
+    }
+
+    size_t offset = (uint8_t*)pointer - buffer;
+    size_t aligned = (size + 3) & ~(size_t)3;
+    if (offset == lastOffset && aligned <= ARENA_SIZE - offset) {
+        used = offset + aligned;
+        if (used > peakUse) {
+            peakUse = used;
+        }
+        return pointer;
+    }
+    return offset + aligned <= used ? pointer : nullptr;
+}
+
+/**
+ * The function `release` gives back memory from `allocate`. Arena memory is only given back when the
+ * request ends, heap memory is freed right away.
+ */
+void ArenaManager::release(void* pointer) {
+    if (!owns(pointer)) {
+        free(pointer);
+    }
+}
+
+uint32_t ArenaManager::getRequestCount() {
+    return requestCount;
+}
+
+size_t ArenaManager::getPeakUse() {
+    return peakUse;
+}
+
+uint32_t ArenaManager::getHeapAllocationCount() {
+    return heapAllocations;
+}
+
+uint32_t ArenaManager::getHeapGrowthCount() {
+    return heapGrowthCount;
+}
+
+int32_t ArenaManager::getLastHeapDelta() {
+    return lastHeapDelta;
+}
+
+/****************PRIVATE******************/
+
+bool ArenaManager::owns(const void* pointer) const {
+    return pointer >= buffer && pointer < buffer + ARENA_SIZE;
+}
@@ -0,0 +1,66 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the request arena, a fixed block of memory the web handlers build their JSON documents
+in. It is emptied after every request, so answering requests no longer allocates and frees heap blocks of
+changing sizes, which fragmented the heap of a long running board until large allocations failed.
+*/
+
+#ifndef ArenaManager_h
+#define ArenaManager_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+class ArenaManager {
+public:
+    static constexpr size_t ARENA_SIZE = 6144; // Fits the largest document of a request (the schedule)
+
+    ArenaManager();
+    void beginRequest();
+    void endRequest();
+    void* allocate(size_t size);
+    void* reallocate(void* pointer, size_t size);
+    void release(void* pointer);
+
+    uint32_t getRequestCount();
+    size_t getPeakUse();
+    uint32_t getHeapAllocationCount();
+    uint32_t getHeapGrowthCount();
+    int32_t getLastHeapDelta();
+private:
+    bool owns(const void* pointer) const;
+
+    alignas(8) uint8_t buffer[ARENA_SIZE];
+    size_t used; // Bytes handed out since the request started
+    size_t lastOffset; // Offset of the most recent allocation, it may grow in place
+    size_t peakUse;
+    bool active; // A request is being answered
+    uint32_t requestCount;
+    uint32_t heapAllocations; // Allocations of a request that did not fit and went to the heap
+    uint32_t heapGrowthCount; // Requests after which less heap was free than before
+    uint32_t freeHeapAtStart;
+    int32_t lastHeapDelta; // Free heap after the last request minus before it (bytes)
+};
+
+extern ArenaManager arenaManager;
+
+// ArduinoJson allocator that takes its memory from the request arena
+struct ArenaAllocator {
+    void* allocate(size_t size) {
+        return arenaManager.allocate(size);
+    }
+
+    void deallocate(void* pointer) {
+        arenaManager.release(pointer);
+    }
+
+    void* reallocate(void* pointer, size_t size) {
+        return arenaManager.reallocate(pointer, size);
+    }
+};
+
+// A JSON document in the request arena, outside of a request it is on the heap like DynamicJsonDocument
+typedef BasicJsonDocument<ArenaAllocator> ArenaJsonDocument;
+
+#endif
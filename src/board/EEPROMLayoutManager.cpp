@@ -8,14 +8,40 @@ Start address for each data type is defined as a constant, and methods are provi
 
 
 #include "EEPROMLayoutManager.h"
+#include "schedule/RingGuardManager.h"
 
-EEPROMLayoutManager::EEPROMLayoutManager() {}
+extern EEPROMLayoutManager eepromManager;
+
+EEPROMLayoutManager::EEPROMLayoutManager() : messageCount(0) {}
 
 bool EEPROMLayoutManager::begin(size_t size) {
     EEPROM.begin(size);
     return true;
 }
 
+/**
+ * The function `commit` writes the changed EEPROM bytes to flash. Erasing the flash sector stops the CPU,
+ * so close to a ring the commit is put off until the ring guard window closes. The new values are read
+ * back from RAM meanwhile, only a power loss before the commit would lose them.
+ * 
+ * @return `true` if the commit was put off, otherwise the result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::commit() {
+    if (ringGuardManager.defer(commitDeferred)) {
+        return true;
+    }
+    return EEPROM.commit();
+}
+
+/**
+ * The function `commitDeferred` runs a commit that was put off by `commit`.
+ */
+void EEPROMLayoutManager::commitDeferred() {
+    if (!EEPROM.commit()) {
+        eepromManager.addSystemMessage("Deferred EEPROM commit failed.");
+    }
+}
+
 /****************************System messages****************************/
 
 /**
@@ -38,6 +64,16 @@ void EEPROMLayoutManager::addSystemMessage(const char* message) {
 
     // Add the new message
     messagesArray.add(message);
+    messageCount++;
+}
+
+/**
+ * The function `getMessageCount` returns the number of messages added since power on. The last message
+ * in the array is message number `getMessageCount()`, so a client that remembers the count only needs
+ * the messages after it.
+ */
+uint32_t EEPROMLayoutManager::getMessageCount() {
+    return messageCount;
 }
 
 
@@ -73,6 +109,66 @@ String EEPROMLayoutManager::loadRingSchedule() {
     }
 }
 
+/**
+ * The function `saveCompactSchedule` saves the binary schedule blob to the schedule area of the EEPROM.
+ * 
+ * @param data Pointer to the compact schedule blob.
+ * @param length Length of the blob in bytes, at most 3000.
+ * 
+ * @return The function returns `false` if the blob does not fit in the schedule area, otherwise the
+ * result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::saveCompactSchedule(const uint8_t* data, size_t length) {
+    if (length > 3000) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        EEPROM.write(scheduleStartAddr + i, data[i]);
+    }
+    return commit();
+}
+
+/**
+ * The function `loadCompactSchedule` copies the raw bytes of the schedule area into a buffer. The
+ * caller is responsible for checking the blob header, a legacy JSON schedule or an empty area is
+ * returned as is.
+ * 
+ * @param buffer Buffer to copy the schedule area into.
+ * @param maxLength Size of the buffer.
+ * 
+ * @return The number of bytes copied.
+ */
+size_t EEPROMLayoutManager::loadCompactSchedule(uint8_t* buffer, size_t maxLength) {
+    size_t length = maxLength < 3000 ? maxLength : 3000;
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = EEPROM.read(scheduleStartAddr + i);
+    }
+    return length;
+}
+
+/**
+ * The function `saveActiveProfile` saves the manually selected schedule profile. Only this single
+ * byte is written when switching profiles, the ring lists are left alone.
+ * 
+ * @param profile Index of the profile, or 0xFF to select the profile by date.
+ * 
+ * @return The result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::saveActiveProfile(uint8_t profile) {
+    EEPROM.write(activeProfileAddr, profile);
+    return commit();
+}
+
+/**
+ * The function `loadActiveProfile` loads the manually selected schedule profile. An erased EEPROM
+ * reads back as 0xFF, which means the profile is selected by date.
+ * 
+ * @return The index of the selected profile, or 0xFF if none is selected.
+ */
+uint8_t EEPROMLayoutManager::loadActiveProfile() {
+    return EEPROM.read(activeProfileAddr);
+}
+
 /****************************Ring duration****************************/
 /**
  * The function `saveRingDuration` saves an integer value representing ring duration to EEPROM memory.
@@ -165,6 +261,223 @@ bool EEPROMLayoutManager::saveUniqueURL(const String& url) {
     return saveString(url, uniqueURLAddr);
 }
 
+/*****************************Time zone******************************/
+/**
+ * The function `saveTimezone` saves the POSIX TZ string to EEPROM memory.
+ * 
+ * @param posix A POSIX TZ string such as "CST6CDT,M3.2.0,M11.1.0", at most 59 characters.
+ * 
+ * @return The function `saveTimezone` is returning the result of calling the `saveString` function
+ * with the `posix` parameter and the `timezoneAddr` address.
+ */
+bool EEPROMLayoutManager::saveTimezone(const String& posix) {
+    return saveString(posix, timezoneAddr);
+}
+
+/**
+ * The function `loadTimezone` loads the POSIX TZ string from EEPROM, returning Central time if no time
+ * zone was saved yet.
+ * 
+ * @return The saved POSIX TZ string, or "CST6CDT,M3.2.0,M11.1.0" if the EEPROM is empty.
+ */
+String EEPROMLayoutManager::loadTimezone() {
+    String posix = loadString(timezoneAddr, 60);
+    if (posix.length() == 0 || posix[0] == char(0xFF)) {
+        return "CST6CDT,M3.2.0,M11.1.0"; // Return the default time zone
+    } else {
+        return posix; // Return the loaded time zone
+    }
+}
+
+/*****************************NTP server******************************/
+/**
+ * The function `saveNtpServer` saves the NTP server host name or IP address to EEPROM memory.
+ * 
+ * @param server Host name or IP address of the NTP server, at most 59 characters.
+ * 
+ * @return The function `saveNtpServer` is returning the result of calling the `saveString` function
+ * with the `server` parameter and the `ntpServerAddr` address.
+ */
+bool EEPROMLayoutManager::saveNtpServer(const String& server) {
+    return saveString(server, ntpServerAddr);
+}
+
+/**
+ * The function `loadNtpServer` loads the NTP server from EEPROM, returning "pool.ntp.org" if no server
+ * was saved yet.
+ * 
+ * @return The saved NTP server, or "pool.ntp.org" if the EEPROM is empty.
+ */
+String EEPROMLayoutManager::loadNtpServer() {
+    String server = loadString(ntpServerAddr, 60);
+    if (server.length() == 0 || server[0] == char(0xFF)) {
+        return "pool.ntp.org"; // Return the default NTP server
+    } else {
+        return server; // Return the loaded NTP server
+    }
+}
+
+/*****************************WiFi cache******************************/
+/**
+ * The function `saveWifiCache` saves the access point (channel and BSSID) of the last good connection,
+ * used to reconnect without scanning. Only changed bytes are written and the flash is only committed if
+ * something changed, since this is called on every connection.
+ * 
+ * @param data The cache record, at most 40 bytes.
+ * @param length Length of the record.
+ * 
+ * @return `false` if the record is too large or the commit failed.
+ */
+bool EEPROMLayoutManager::saveWifiCache(const uint8_t* data, size_t length) {
+    if (length > 40) {
+        return false;
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < length; i++) {
+        if (EEPROM.read(wifiCacheAddr + i) != data[i]) {
+            EEPROM.write(wifiCacheAddr + i, data[i]);
+            changed = true;
+        }
+    }
+    return !changed || commit();
+}
+
+/**
+ * The function `loadWifiCache` copies the saved connection cache record into a buffer. The caller is
+ * responsible for checking that the record is valid.
+ * 
+ * @param buffer Buffer to copy the record into.
+ * @param length Length of the record, at most 40 bytes.
+ * 
+ * @return `false` if the record is too large.
+ */
+bool EEPROMLayoutManager::loadWifiCache(uint8_t* buffer, size_t length) {
+    if (length > 40) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = EEPROM.read(wifiCacheAddr + i);
+    }
+    return true;
+}
+
+/*****************************Config sync******************************/
+/**
+ * The function `saveSyncUrl` saves the URL of the config server the schedule and settings are pulled from.
+ * 
+ * @param url The URL, at most 99 characters, or an empty string.
+ * 
+ * @return The result of calling the `saveString` function with the `url` parameter and `syncUrlAddr`.
+ */
+bool EEPROMLayoutManager::saveSyncUrl(const String& url) {
+    return saveString(url, syncUrlAddr);
+}
+
+/**
+ * The function `loadSyncUrl` loads the config server URL, returning an empty string if none was saved.
+ * 
+ * @return The saved URL, or an empty string if the EEPROM is empty.
+ */
+String EEPROMLayoutManager::loadSyncUrl() {
+    String url = loadString(syncUrlAddr, 100);
+    if (url.length() > 0 && url[0] == char(0xFF)) {
+        return "";
+    }
+    return url;
+}
+
+/**
+ * The function `saveSyncInterval` saves the minutes between polls of the config server.
+ * 
+ * @param minutes Minutes between polls, 0 disables pulling.
+ * 
+ * @return The result of calling the `saveInt` function with the `minutes` parameter and `syncIntervalAddr`.
+ */
+bool EEPROMLayoutManager::saveSyncInterval(int minutes) {
+    return saveInt(minutes, syncIntervalAddr);
+}
+
+/**
+ * The function `loadSyncInterval` loads the minutes between polls of the config server, with a default
+ * of 0 (disabled) if the value is outside the range of 0 to 1440.
+ * 
+ * @return The saved interval in minutes, or 0.
+ */
+int EEPROMLayoutManager::loadSyncInterval() {
+    int minutes = loadInt(syncIntervalAddr);
+    if (minutes < 0 || minutes > 1440) {
+        return 0;
+    }
+    return minutes;
+}
+
+/**
+ * The function `saveSyncHash` saves the hash of the config document applied last, so an unchanged
+ * document is not applied again after a restart.
+ * 
+ * @param hash FNV-1a hash of the document.
+ * 
+ * @return The result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::saveSyncHash(uint32_t hash) {
+    EEPROM.put(syncHashAddr, hash);
+    return commit();
+}
+
+/**
+ * The function `loadSyncHash` loads the hash of the config document applied last.
+ * 
+ * @return The saved hash, 0xFFFFFFFF if none was saved.
+ */
+uint32_t EEPROMLayoutManager::loadSyncHash() {
+    uint32_t hash;
+    EEPROM.get(syncHashAddr, hash);
+    return hash;
+}
+
+/*****************************LAN sync******************************/
+/**
+ * The function `saveLanSyncMode` saves the LAN sync mode.
+ * 
+ * @param mode 0 = off, 1 = leader, 2 = follower.
+ * 
+ * @return The result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::saveLanSyncMode(uint8_t mode) {
+    EEPROM.write(lanSyncModeAddr, mode);
+    return commit();
+}
+
+/**
+ * The function `loadLanSyncMode` loads the LAN sync mode. An erased EEPROM reads back as 0xFF, which
+ * the caller treats as off.
+ * 
+ * @return The saved mode.
+ */
+uint8_t EEPROMLayoutManager::loadLanSyncMode() {
+    return EEPROM.read(lanSyncModeAddr);
+}
+
+/*****************************Low power******************************/
+/**
+ * The function `saveLowPower` saves if the low power mode is on.
+ * 
+ * @return The result of `EEPROM.commit()`.
+ */
+bool EEPROMLayoutManager::saveLowPower(bool enabled) {
+    EEPROM.write(lowPowerAddr, enabled ? 1 : 0);
+    return commit();
+}
+
+/**
+ * The function `loadLowPower` loads if the low power mode is on. An erased EEPROM reads back as 0xFF,
+ * the mode is only on if it was turned on.
+ */
+bool EEPROMLayoutManager::loadLowPower() {
+    return EEPROM.read(lowPowerAddr) == 1;
+}
+
 /*****************************Password******************************/
 /**
  * The function `savePassword` saves a password string to EEPROM memory.
@@ -267,7 +580,7 @@ bool EEPROMLayoutManager::saveString(const String& data, int startAddr) {
         EEPROM.write(startAddr + i, data[i]);
     }
     EEPROM.write(startAddr + i, '\0'); // Null-terminate the string
-    return EEPROM.commit();
+    return commit();
 }
 
 /**
@@ -307,7 +620,7 @@ String EEPROMLayoutManager::loadString(int startAddr, int maxLen) {
  */
 bool EEPROMLayoutManager::saveInt(int value, int startAddr) {
     EEPROM.put(startAddr, value);
-    return EEPROM.commit();
+    return commit();
 }
 
 /**
@@ -16,11 +16,16 @@ extern DynamicJsonDocument systemMessages;
 class EEPROMLayoutManager {
 public:
     void addSystemMessage(const char* message);
+    uint32_t getMessageCount();
 
     EEPROMLayoutManager();
     bool begin(size_t size);
     bool saveRingSchedule(const String& schedule);
     String loadRingSchedule();
+    bool saveCompactSchedule(const uint8_t* data, size_t length);
+    size_t loadCompactSchedule(uint8_t* buffer, size_t maxLength);
+    bool saveActiveProfile(uint8_t profile);
+    uint8_t loadActiveProfile();
 
     bool saveRingDuration(int duration);
     int loadRingDuration();
@@ -43,7 +48,33 @@ public:
     bool saveUniqueURL(const String& url);
     String loadUniqueURL();
 
+    bool saveTimezone(const String& posix);
+    String loadTimezone();
+
+    bool saveNtpServer(const String& server);
+    String loadNtpServer();
+
+    bool saveWifiCache(const uint8_t* data, size_t length);
+    bool loadWifiCache(uint8_t* buffer, size_t length);
+
+    bool saveSyncUrl(const String& url);
+    String loadSyncUrl();
+    bool saveSyncInterval(int minutes);
+    int loadSyncInterval();
+    bool saveSyncHash(uint32_t hash);
+    uint32_t loadSyncHash();
+
+    bool saveLanSyncMode(uint8_t mode);
+    uint8_t loadLanSyncMode();
+
+    bool saveLowPower(bool enabled);
+    bool loadLowPower();
+
 private:
+    uint32_t messageCount; // Messages added since power on, numbers the messages for clients that poll them
+
+    bool commit();
+    static void commitDeferred();
     bool saveString(const String& data, int startAddr);
     String loadString(int startAddr, int maxLen);
     bool saveInt(int value, int startAddr);
@@ -55,6 +86,15 @@ private:
     const int passwordAddr = 400;
     const int saltAddr = 500;
     const bool initializedAddr = 600;
+    const int activeProfileAddr = 650;
+    const int timezoneAddr = 660;
+    const int ntpServerAddr = 720;
+    const int wifiCacheAddr = 780;
+    const int syncUrlAddr = 820;
+    const int syncIntervalAddr = 920;
+    const int syncHashAddr = 924;
+    const int lanSyncModeAddr = 930;
+    const int lowPowerAddr = 940;
     const int scheduleStartAddr = 1000;
 };
 
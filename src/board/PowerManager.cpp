@@ -0,0 +1,178 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the low power mode, the Wi-Fi sleep mode and the naps of the main loop.
+*/
+
+#include "PowerManager.h"
+
+#include <coredecls.h>
+
+#include "board/ArenaManager.h"
+#include "board/TaskManager.h"
+#include "network/LanSyncManager.h"
+#include "network/NetworkManager.h"
+#include "schedule/NTPManager.h"
+#include "schedule/RingGuardManager.h"
+#include "schedule/scheduleManager.h"
+#include "schedule/TimeManager.h"
+#include "web/WebServerManager.h"
+
+extern WebServerManager server;
+extern NetworkManager networkManager;
+extern NTPManager ntpManager;
+extern LanSyncManager lanSyncManager;
+extern ScheduleManager scheduleManager;
+extern TimeManager timeManager;
+
+PowerManager::PowerManager() : enabled(false), lightSleep(false), state("off"), lastRequestCount(0), lastRequestAt(0),
+                               sleepMillis(0), napCount(0), earlyWakeCount(0) {}
+
+/**
+ * The `begin` function loads the setting saved in EEPROM. The first naps wait `IDLE_AFTER` after setup,
+ * someone may be about to open the web pages of a unit that was just powered on.
+ */
+void PowerManager::begin() {
+    enabled = eepromManager.loadLowPower();
+    lastRequestAt = millis();
+}
+
+/**
+ * The `update` function is the last task of each pass of the main loop. If nothing needs the loop it
+ * naps, the Wi-Fi driver puts the chip in light sleep meanwhile and wakes it for the access point's
+ * beacons and any traffic they announce. The nap ends after its time, or as soon as a client connects.
+ */
+void PowerManager::update() {
+    applySleepMode();
+
+    uint32_t nap = napLength();
+    if (nap == 0) {
+        return;
+    }
+
+    unsigned long start = millis();
+    esp_delay(nap, []() { return !server.hasPendingClient(); }, CHECK_INTERVAL);
+    uint32_t slept = millis() - start;
+
+    sleepMillis += slept;
+    napCount++;
+    if (slept < nap) {
+        earlyWakeCount++;
+    }
+    taskManager.wake();
+}
+
+/**
+ * The function `setEnabled` turns the low power mode on or off and saves the setting.
+ *
+ * @return The result of `EEPROM.commit()`.
+ */
+bool PowerManager::setEnabled(bool enable) {
+    enabled = enable;
+    applySleepMode();
+    return eepromManager.saveLowPower(enable);
+}
+
+bool PowerManager::isEnabled() {
+    return enabled;
+}
+
+/**
+ * The function `getState` tells what the loop did on the last pass: "napping", or why it could not nap
+ * ("off", "lanSync", "wifi", "clock", "ntp", "client" or "ring").
+ */
+const char* PowerManager::getState() {
+    return state;
+}
+
+/**
+ * The sleep metrics are the time spent napping, the naps, and the naps a connecting client cut short.
+ */
+uint64_t PowerManager::getSleepMillis() {
+    return sleepMillis;
+}
+
+uint32_t PowerManager::getNapCount() {
+    return napCount;
+}
+
+uint32_t PowerManager::getEarlyWakeCount() {
+    return earlyWakeCount;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `napLength` decides if the loop may nap and for how long. It may not while LAN sync is
+ * on (every broadcast has to be heard), the clock is not set, an NTP poll is waiting for its replies (the
+ * timestamps would be off by the nap), a client used the web pages recently or still has a connection
+ * open, or the next ring is less than `WAKE_LEAD` away. The nap always ends `WAKE_LEAD` before the ring,
+ * the seconds to the ring are rounded down, so one more second is kept.
+ *
+ * @return The nap length (ms), 0 if the loop has to stay awake.
+ */
+uint32_t PowerManager::napLength() {
+    uint32_t requests = arenaManager.getRequestCount();
+    if (requests != lastRequestCount) {
+        lastRequestCount = requests;
+        lastRequestAt = millis();
+    }
+
+    if (!enabled) {
+        state = "off";
+        return 0;
+    }
+    if (lanSyncManager.isActive()) {
+        state = "lanSync";
+        return 0;
+    }
+    if (!networkManager.isConnected()) {
+        state = "wifi";
+        return 0;
+    }
+    if (!timeManager.isTimeValid()) {
+        state = "clock";
+        return 0;
+    }
+    if (ntpManager.isPolling()) {
+        state = "ntp";
+        return 0;
+    }
+    if (millis() - lastRequestAt < IDLE_AFTER || server.isClientConnected()) {
+        state = "client";
+        return 0;
+    }
+
+    // Without a ring ahead in the loaded days, tomorrow's rings are read at midnight
+    uint32_t toRing = scheduleManager.getSecondsToNextRing();
+    if (toRing == ScheduleManager::NO_RING_SECONDS) {
+        toRing = (1440 - timeManager.getMinuteOfDay()) * 60 - timeManager.getEpoch() % 60;
+    }
+    if (ringGuardManager.isOpen() || toRing <= WAKE_LEAD + 1) {
+        state = "ring";
+        return 0;
+    }
+
+    state = "napping";
+    return min<uint32_t>(MAX_NAP, (toRing - WAKE_LEAD - 1) * 1000);
+}
+
+/**
+ * The function `applySleepMode` sets the Wi-Fi sleep mode when the setting or the LAN sync mode changed.
+ * Automatic light sleep follows the beacons the access point announces buffered traffic in (DTIM), so a
+ * request waits at most one beacon interval for the radio. LAN sync keeps the radio awake, it switched
+ * sleep off when it started.
+ */
+void PowerManager::applySleepMode() {
+    bool wanted = enabled && !lanSyncManager.isActive();
+    if (wanted == lightSleep) {
+        return;
+    }
+
+    if (wanted) {
+        WiFi.setSleepMode(WIFI_LIGHT_SLEEP);
+    } else {
+        WiFi.setSleepMode(lanSyncManager.isActive() ? WIFI_NONE_SLEEP : WIFI_MODEM_SLEEP);
+    }
+    lightSleep = wanted;
+}
@@ -0,0 +1,53 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the low power mode. Most of the day the next ring is minutes away and nobody is using
+the web pages, yet the main loop spins and the radio stays awake. With the mode on, Wi-Fi uses automatic
+light sleep and the loop naps while it is idle, so the chip sleeps between the access point's beacons.
+A nap ends on a timer well before the next ring, or early when a client connects.
+*/
+
+#ifndef PowerManager_h
+#define PowerManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "board/EEPROMLayoutManager.h"
+
+extern EEPROMLayoutManager eepromManager;
+
+class PowerManager {
+public:
+    static constexpr uint32_t WAKE_LEAD = 15; // The loop stays awake from this long before a ring (s)
+    static constexpr uint32_t IDLE_AFTER = 30000; // No naps until this long after the last request (ms)
+    static constexpr uint32_t MAX_NAP = 500; // Longest nap, the other tasks run in between (ms)
+    static constexpr uint32_t CHECK_INTERVAL = 100; // Time between checks for a new connection during a nap (ms)
+
+    PowerManager();
+    void begin();
+    void update();
+    bool setEnabled(bool enabled);
+    bool isEnabled();
+    const char* getState();
+    uint64_t getSleepMillis();
+    uint32_t getNapCount();
+    uint32_t getEarlyWakeCount();
+
+private:
+    uint32_t napLength();
+    void applySleepMode();
+
+    bool enabled; // Saved in EEPROM
+    bool lightSleep; // Wi-Fi is set to automatic light sleep
+    const char* state; // Why the last pass did not nap, or "napping"
+    uint32_t lastRequestCount; // Requests served when the last one was seen
+    unsigned long lastRequestAt; // millis() when the last request was seen
+    uint64_t sleepMillis; // Time spent napping
+    uint32_t napCount;
+    uint32_t earlyWakeCount; // Naps ended by a client connecting
+};
+
+extern PowerManager powerManager;
+
+#endif
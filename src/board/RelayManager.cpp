@@ -2,19 +2,72 @@
 Quinton Nelson
 3/13/2024
 This file handles relay activation
+The relay is switched off (and pre-armed rings switched on) by Ticker timers, so the main loop never waits for a ring
 */
 
 #include "RelayManager.h"
 
+// The timers live outside the class since the global RelayManager is reassigned in setup()
+static Ticker armTicker; // Closes the relay at a pre-armed instant
+static Ticker offTicker; // Opens the relay after ringDuration
+static volatile bool armed = false; // A ring is pre-armed and has not fired yet
+static uint32_t armedMinute = 0; // UTC minute (minutes since 1970) of the last pre-armed ring
+static uint32_t scheduledMinute = 0; // UTC minute of the last ring of the schedule
+
 // Constructor for the RelayManager class
 RelayManager::RelayManager(int pin) : relayPin(pin) {
     pinMode(relayPin, OUTPUT);
 }
 
-// This method activates the relay for a given duration, then deactivates it
+// This method activates the relay for a given duration, then deactivates it from a timer
 // Duration pulled from global variable ringDuration
 void RelayManager::activateRelay() {
-    digitalWrite(relayPin, HIGH);
-    delay(ringDuration * 1000);
-    digitalWrite(relayPin, LOW);
+    int pin = relayPin;
+    digitalWrite(pin, HIGH);
+    offTicker.once_ms(ringDuration * 1000, [pin]() {
+        digitalWrite(pin, LOW);
+    });
+}
+
+/**
+ * The function `activateScheduledRelay` activates the relay for a ring of the schedule, unless that
+ * same ring was pre-armed or has already rung. Other rings, manual ones included, do not suppress it.
+ * 
+ * @param ringMinute UTC minute of the scheduled ring, in minutes since 1970.
+ */
+void RelayManager::activateScheduledRelay(uint32_t ringMinute) {
+    if (ringMinute == armedMinute || ringMinute == scheduledMinute) {
+        return;
+    }
+    scheduledMinute = ringMinute;
+    activateRelay();
+}
+
+/**
+ * The function `armRelay` pre-arms the relay to close at an exact instant. The relay is closed by a
+ * Ticker, a software timer run by the SDK between loop iterations, so it does not wait for the ring task
+ * and several units close their relays within a few milliseconds of each other.
+ * 
+ * @param delayMillis Time from now until the relay closes.
+ * @param ringMinute UTC minute the ring belongs to, in minutes since 1970. The schedule's own ring in
+ * that minute is skipped.
+ * 
+ * @return `false` if a ring is already armed.
+ */
+bool RelayManager::armRelay(uint32_t delayMillis, uint32_t ringMinute) {
+    if (armed) {
+        return false;
+    }
+
+    armed = true;
+    armedMinute = ringMinute;
+    armTicker.once_ms(delayMillis, [this]() {
+        armed = false;
+        activateRelay();
+    });
+    return true;
+}
+
+bool RelayManager::isArmed() {
+    return armed;
 }
@@ -8,6 +8,7 @@ This file handles relay activation
 #define RelayManager_h
 
 #include <Arduino.h>
+#include <Ticker.h>
 
 // Global variable initialized in main.cpp
 extern int ringDuration;
@@ -16,6 +17,9 @@ class RelayManager {
 public:
     RelayManager(int pin);
     void activateRelay();
+    void activateScheduledRelay(uint32_t ringMinute);
+    bool armRelay(uint32_t delayMillis, uint32_t ringMinute);
+    bool isArmed();
 private:
     int relayPin;
 };
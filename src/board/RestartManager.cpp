@@ -0,0 +1,216 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles planned restarts. A CRC checked snapshot is written to RTC memory right before
+restarting and consumed on the next boot; a cold start or a bad checksum falls back to EEPROM.
+*/
+
+#include "RestartManager.h"
+#include <coredecls.h>
+
+#include "schedule/scheduleManager.h"
+#include "schedule/RingGuardManager.h"
+#include "web/AuthManager.h"
+
+extern RestartManager restartManager;
+
+RestartManager::RestartManager() : position(0), length(0), warmBoot(false) {}
+
+/**
+ * The function `restoreSnapshot` restores the settings, authentication state and ring state from RTC
+ * memory if the board was restarted by `restart`. The snapshot is consumed, any later reset loads the
+ * settings from EEPROM again.
+ * 
+ * @return `true` if the snapshot was valid and restored. If `false` is returned nothing was changed and
+ * the caller has to load everything from EEPROM.
+ */
+bool RestartManager::restoreSnapshot() {
+    if (!ESP.rtcUserMemoryRead(SNAPSHOT_BLOCK, buffer, sizeof(buffer))) {
+        return false;
+    }
+    invalidateSnapshot();
+
+    uint8_t* bytes = (uint8_t*)buffer;
+    uint32_t magic, crc;
+    uint16_t snapshotLength;
+    memcpy(&magic, bytes, 4);
+    memcpy(&crc, bytes + 4, 4);
+    memcpy(&snapshotLength, bytes + 8, 2);
+    if (magic != SNAPSHOT_MAGIC || snapshotLength < HEADER_SIZE || snapshotLength > SNAPSHOT_SIZE) {
+        return false;
+    }
+    if (crc != crc32(bytes + 8, snapshotLength - 8)) {
+        return false;
+    }
+
+    // Read every field before applying any of them
+    length = snapshotLength;
+    position = HEADER_SIZE;
+    uint8_t duration, manual;
+    uint16_t lastDay, lastMinute;
+    uint32_t tokenRemaining;
+    String name, url, salt, hash, token;
+    if (!getBytes(&duration, 1) || !getBytes(&manual, 1) || !getBytes((uint8_t*)&lastDay, 2) || !getBytes((uint8_t*)&lastMinute, 2) ||
+        !getString(name) || !getString(url) || !getString(salt) || !getHex(hash) || !getHex(token) ||
+        !getBytes((uint8_t*)&tokenRemaining, 4) || position != length) {
+        return false;
+    }
+
+    ringDuration = duration;
+    deviceName = name;
+    uniqueURL = url;
+    authManager.restoreState(hash, salt, token, tokenRemaining);
+    scheduleManager.restoreState(manual, lastDay, lastMinute);
+
+    warmBoot = true;
+    return true;
+}
+
+/**
+ * The function `restart` saves the snapshot and restarts the board. Use it instead of `ESP.restart()`
+ * whenever the settings in EEPROM are up to date. Close to a ring the restart is put off until the ring
+ * guard window closes, after the EEPROM commits that were put off before it.
+ */
+void RestartManager::restart() {
+    if (ringGuardManager.defer(restartDeferred)) {
+        return;
+    }
+    ringGuardManager.update(); // Commits put off during the window that just closed
+
+    if (!saveSnapshot()) {
+        eepromManager.addSystemMessage("Restart snapshot failed, restarting from EEPROM.");
+    }
+    ESP.restart();
+}
+
+/**
+ * The function `restartDeferred` runs a restart that was put off by `restart`.
+ */
+void RestartManager::restartDeferred() {
+    restartManager.restart();
+}
+
+/**
+ * The function `isWarmBoot` tells if the last boot was restored from the snapshot.
+ */
+bool RestartManager::isWarmBoot() {
+    return warmBoot;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `saveSnapshot` writes the snapshot to RTC memory. The schedule is not included, it is
+ * read from LittleFS on every boot.
+ * 
+ * @return `false` if even the settings did not fit or the write failed.
+ */
+bool RestartManager::saveSnapshot() {
+    uint8_t duration = ringDuration;
+    uint8_t manual = scheduleManager.getManualProfile();
+    uint16_t lastDay, lastMinute;
+    scheduleManager.getLastCheck(lastDay, lastMinute);
+    uint32_t tokenRemaining = authManager.getTokenRemaining();
+    String token = authManager.getToken();
+
+    memset(buffer, 0, sizeof(buffer));
+    position = HEADER_SIZE;
+    if (!putBytes(&duration, 1) || !putBytes(&manual, 1) || !putBytes((uint8_t*)&lastDay, 2) || !putBytes((uint8_t*)&lastMinute, 2) ||
+        !putString(deviceName) || !putString(uniqueURL) || !putString(authManager.getSalt()) ||
+        !putHex(authManager.getPasswordHash()) || !putHex(token.length() == HASH_SIZE * 2 ? token : String()) ||
+        !putBytes((uint8_t*)&tokenRemaining, 4)) {
+        return false;
+    }
+
+    uint8_t* bytes = (uint8_t*)buffer;
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint16_t snapshotLength = position;
+    memcpy(bytes, &magic, 4);
+    memcpy(bytes + 8, &snapshotLength, 2);
+    uint32_t crc = crc32(bytes + 8, snapshotLength - 8);
+    memcpy(bytes + 4, &crc, 4);
+
+    // Only the blocks in use are written
+    return ESP.rtcUserMemoryWrite(SNAPSHOT_BLOCK, buffer, (snapshotLength + 3) & ~3);
+}
+
+/**
+ * The function `invalidateSnapshot` clears the magic number so a snapshot is only restored once.
+ */
+void RestartManager::invalidateSnapshot() {
+    uint32_t magic = 0;
+    ESP.rtcUserMemoryWrite(SNAPSHOT_BLOCK, &magic, sizeof(magic));
+}
+
+/**
+ * The put and get helpers write and read the snapshot fields at `position`. Strings are stored with a
+ * one byte length, hex strings (SHA-256 hashes) as their 32 raw bytes, all zero for an empty string.
+ * 
+ * @return `false` if the field does not fit into the snapshot, or is not stored in it.
+ */
+bool RestartManager::putBytes(const uint8_t* data, size_t count) {
+    if (position + count > SNAPSHOT_SIZE) {
+        return false;
+    }
+    memcpy((uint8_t*)buffer + position, data, count);
+    position += count;
+    return true;
+}
+
+bool RestartManager::putString(const String& value) {
+    if (value.length() > 255) {
+        return false;
+    }
+    uint8_t count = value.length();
+    return putBytes(&count, 1) && putBytes((const uint8_t*)value.c_str(), count);
+}
+
+bool RestartManager::putHex(const String& hex) {
+    uint8_t raw[HASH_SIZE] = {0};
+    if (hex.length() != 0 && hex.length() != HASH_SIZE * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < hex.length() / 2; i++) {
+        raw[i] = strtoul(hex.substring(i * 2, i * 2 + 2).c_str(), nullptr, 16);
+    }
+    return putBytes(raw, HASH_SIZE);
+}
+
+bool RestartManager::getBytes(uint8_t* data, size_t count) {
+    if (position + count > length) {
+        return false;
+    }
+    memcpy(data, (uint8_t*)buffer + position, count);
+    position += count;
+    return true;
+}
+
+bool RestartManager::getString(String& value) {
+    uint8_t count;
+    if (!getBytes(&count, 1) || position + count > length) {
+        return false;
+    }
+    value = String();
+    value.concat((const char*)buffer + position, count);
+    position += count;
+    return true;
+}
+
+bool RestartManager::getHex(String& hex) {
+    uint8_t raw[HASH_SIZE];
+    if (!getBytes(raw, HASH_SIZE)) {
+        return false;
+    }
+    hex = String();
+    uint8_t empty[HASH_SIZE] = {0};
+    if (memcmp(raw, empty, HASH_SIZE) == 0) {
+        return true;
+    }
+
+    char digits[HASH_SIZE * 2 + 1];
+    for (size_t i = 0; i < HASH_SIZE; i++) {
+        snprintf(digits + i * 2, 3, "%02x", raw[i]);
+    }
+    hex = digits;
+    return true;
+}
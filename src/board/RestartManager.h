@@ -0,0 +1,64 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles planned restarts. The settings, authentication state and ring state are kept in RTC
+memory across the restart, so the board returns to service without loading them from EEPROM.
+*/
+
+#ifndef RestartManager_h
+#define RestartManager_h
+
+#include <Arduino.h>
+
+#include "board/EEPROMLayoutManager.h"
+
+class AuthManager;
+class ScheduleManager;
+
+extern EEPROMLayoutManager eepromManager;
+extern AuthManager authManager;
+extern ScheduleManager scheduleManager;
+extern String deviceName;
+extern String uniqueURL;
+extern int ringDuration;
+
+class RestartManager {
+public:
+    RestartManager();
+    bool restoreSnapshot();
+    void restart();
+    bool isWarmBoot();
+private:
+    static void restartDeferred();
+
+    /*
+    RTC user memory is 512 bytes: blocks 0 - 31 are used by OTA, blocks 32 - 37 hold the clock
+    checkpoint of TimeManager, and the snapshot uses the rest.
+    Snapshot layout: magic u32, crc32 u32 (of everything after it), length u16, then
+      ringDuration u8, manual profile u8, last checked day u16, last checked minute u16,
+      device name, unique URL, salt (length prefixed strings), password hash (32 bytes),
+      token (32 bytes, zero if none), token validity left u32 (ms)
+    The schedule is not part of the snapshot, it is read from LittleFS.
+    */
+    static constexpr uint32_t SNAPSHOT_BLOCK = 38;
+    static constexpr size_t SNAPSHOT_SIZE = 512 - SNAPSHOT_BLOCK * 4;
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x424C534E; // "BLSN"
+    static constexpr size_t HEADER_SIZE = 10;
+    static constexpr size_t HASH_SIZE = 32;
+
+    bool saveSnapshot();
+    void invalidateSnapshot();
+    bool putBytes(const uint8_t* data, size_t length);
+    bool putString(const String& value);
+    bool putHex(const String& hex);
+    bool getBytes(uint8_t* data, size_t length);
+    bool getString(String& value);
+    bool getHex(String& hex);
+
+    uint32_t buffer[SNAPSHOT_SIZE / 4]; // Word aligned, RTC memory is accessed in 4 byte blocks
+    size_t position; // Read or write position in buffer
+    size_t length; // Bytes of buffer in use
+    bool warmBoot; // The last boot restored the snapshot
+};
+
+#endif
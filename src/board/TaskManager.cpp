@@ -0,0 +1,176 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the cooperative task scheduler. Tasks are never interrupted, each returns when it has
+done a short piece of work. The scheduler decides which one goes next, measures how long each waited
+and ran, and holds back background tasks that ran over their budget.
+*/
+
+#include "TaskManager.h"
+
+TaskManager::TaskManager() : taskCount(0), current(nullptr) {}
+
+/**
+ * The function `add` registers a task. Tasks are kept in priority order, a task added later runs after
+ * the ones of the same priority added before it.
+ *
+ * @param name Name the task is reported under, a string literal.
+ * @param function Does one short piece of the task's work and returns.
+ * @param priority Order of the tasks on each pass, see `TaskPriority`.
+ * @param period Time between runs (ms), 0 to run on every pass.
+ * @param deadline Longest acceptable wait after the task is due (ms), a later start counts as a miss.
+ * @param budget Longest acceptable run time (us), a longer run counts as over budget. A background task
+ * then skips its next run.
+ *
+ * @return `false` if there are already `MAX_TASKS` tasks.
+ */
+bool TaskManager::add(const char* name, TaskFunction function, TaskPriority priority, uint32_t period, uint32_t deadline, uint32_t budget) {
+    if (taskCount >= MAX_TASKS) {
+        return false;
+    }
+
+    uint8_t position = taskCount;
+    while (position > 0 && tasks[position - 1].priority < priority) {
+        tasks[position] = tasks[position - 1];
+        position--;
+    }
+
+    Task& task = tasks[position];
+    memset(&task, 0, sizeof(task));
+    task.name = name;
+    task.function = function;
+    task.priority = priority;
+    task.period = period;
+    task.deadline = deadline;
+    task.budget = budget;
+    task.dueAt = millis();
+    taskCount++;
+    return true;
+}
+
+/**
+ * The `run` function is called from the main loop. Every due task runs once, highest priority first, and
+ * after each task that is not time critical the time critical tasks that became due meanwhile run again.
+ */
+void TaskManager::run() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if ((long)(millis() - task.dueAt) < 0) {
+            continue;
+        }
+
+        runTask(task);
+        if (task.priority < PRIORITY_TIMING) {
+            runAbove(task.priority, PRIORITY_TIMING);
+        }
+    }
+}
+
+/**
+ * The function `preempt` is called by long running work, e.g. between the pieces of a large web response.
+ * The time critical tasks of a higher priority than the running task that are due run before it goes on,
+ * so a ring is not held up until the response is sent. Tasks of a lower priority wait for the next pass.
+ */
+void TaskManager::preempt() {
+    if (current != nullptr) {
+        runAbove(current->priority, PRIORITY_TIMING);
+    }
+}
+
+/**
+ * The function `wake` is called after the loop slept on purpose, see `PowerManager`. The tasks that fell
+ * due meanwhile are due from now, the sleep does not count against their deadlines.
+ */
+void TaskManager::wake() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if ((long)(now - tasks[i].dueAt) > 0) {
+            tasks[i].dueAt = now;
+        }
+    }
+}
+
+uint8_t TaskManager::getTaskCount() {
+    return taskCount;
+}
+
+const Task& TaskManager::getTask(uint8_t task) {
+    return tasks[task];
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `runAbove` runs the due tasks with a priority above one priority and at least another.
+ *
+ * @param priority Only tasks of a higher priority run.
+ * @param lowest Only tasks of this priority or higher run.
+ */
+void TaskManager::runAbove(TaskPriority priority, TaskPriority lowest) {
+    for (uint8_t i = 0; i < taskCount && tasks[i].priority > priority; i++) {
+        Task& task = tasks[i];
+        if (task.priority >= lowest && (long)(millis() - task.dueAt) >= 0) {
+            runTask(task);
+        }
+    }
+}
+
+/**
+ * The function `runTask` runs a task once and measures it. A task that is already running (it called
+ * `preempt` itself) is not run again. A background task whose last run was over budget is not run this
+ * time, it is only scheduled again, so one slow web request does not also hold up the next pass.
+ */
+void TaskManager::runTask(Task& task) {
+    if (task.running) {
+        return;
+    }
+    if (task.skipNext) {
+        task.skipNext = false;
+        task.skippedRuns++;
+        scheduleNext(task);
+        return;
+    }
+
+    unsigned long start = millis();
+    uint32_t lateness = start - task.dueAt;
+    task.maxLateness = max(task.maxLateness, lateness);
+    if (lateness > task.deadline) {
+        task.missedDeadlines++;
+    }
+
+    Task* previous = current;
+    current = &task;
+    task.running = true;
+    uint32_t startMicros = micros();
+    task.function();
+    uint32_t elapsed = micros() - startMicros;
+    task.running = false;
+    current = previous;
+
+    task.runs++;
+    task.lastMicros = elapsed;
+    task.maxMicros = max(task.maxMicros, elapsed);
+    task.totalMicros += elapsed;
+    if (elapsed > task.budget) {
+        task.overBudget++;
+        task.skipNext = task.priority == PRIORITY_BACKGROUND;
+    }
+
+    scheduleNext(task);
+}
+
+/**
+ * The function `scheduleNext` sets when a task is due again. A periodic task is due again one period
+ * after it was due, or one period from now if it fell further behind, and a task without a period is due
+ * again right away, so its lateness is the time the other tasks kept it waiting.
+ */
+void TaskManager::scheduleNext(Task& task) {
+    if (task.period == 0) {
+        task.dueAt = millis();
+    } else {
+        task.dueAt += task.period;
+        if ((long)(millis() - task.dueAt) >= 0) {
+            task.dueAt = millis() + task.period;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the cooperative task scheduler. Every subsystem the main loop used to call in a fixed
+order is a task with a priority, a period, a deadline and a time budget. The ring task runs first on every
+pass, and long running work can let the time critical tasks run in between, so ring timing does not
+depend on web and network load. A background task that runs over its budget skips its next run, so the
+other tasks get a pass first. Deadlines are only measured, a late task still runs.
+*/
+
+#ifndef TaskManager_h
+#define TaskManager_h
+
+#include <Arduino.h>
+
+// Task priorities, higher runs first. Tasks from PRIORITY_TIMING up are time critical, see `preempt`.
+enum TaskPriority : uint8_t {
+    PRIORITY_BACKGROUND, // Web server and other work that may wait
+    PRIORITY_NETWORK, // Wi-Fi, mDNS and config sync
+    PRIORITY_TIMING, // Clock and LAN sync, their timestamps suffer from waiting
+    PRIORITY_RING // The ring check
+};
+
+typedef void (*TaskFunction)();
+
+struct Task {
+    const char* name;
+    TaskFunction function;
+    TaskPriority priority;
+    uint32_t period; // Time between runs (ms), 0 to run on every pass
+    uint32_t deadline; // Longest acceptable wait after the task is due (ms), only measured
+    uint32_t budget; // Longest acceptable run time (us), a background task over it skips its next run
+    unsigned long dueAt; // millis() when the task is due next
+    bool running;
+    bool skipNext; // The last run was over budget, the next one is skipped
+
+    // Measured on every run
+    uint32_t runs;
+    uint32_t lastMicros;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+    uint32_t maxLateness; // Longest wait after the task was due (ms)
+    uint32_t overBudget; // Runs that took longer than the budget
+    uint32_t skippedRuns; // Runs skipped after a run over budget
+    uint32_t missedDeadlines; // Runs that started later than the deadline
+};
+
+class TaskManager {
+public:
+    static constexpr uint8_t MAX_TASKS = 10;
+
+    TaskManager();
+    bool add(const char* name, TaskFunction function, TaskPriority priority, uint32_t period, uint32_t deadline, uint32_t budget);
+    void run();
+    void preempt();
+    void wake();
+    uint8_t getTaskCount();
+    const Task& getTask(uint8_t task);
+
+private:
+    void runAbove(TaskPriority priority, TaskPriority lowest);
+    void runTask(Task& task);
+    void scheduleNext(Task& task);
+
+    Task tasks[MAX_TASKS]; // Sorted by priority, highest first
+    uint8_t taskCount;
+    Task* current; // The task running, or nullptr between tasks
+};
+
+extern TaskManager taskManager;
+
+#endif
@@ -16,10 +16,21 @@ This file handles the main loop and setup of the program. It initializes the glo
 
 #include "board/EEPROMLayoutManager.h"
 #include "schedule/TimeManager.h"
+#include "schedule/NTPManager.h"
 #include "schedule/scheduleManager.h"
+#include "schedule/RingGuardManager.h"
 #include "board/RelayManager.h"
+#include "board/ArenaManager.h"
+#include "board/TaskManager.h"
+#include "board/PowerManager.h"
 #include "web/Endpoints.h"
 #include "web/AuthManager.h"
+#include "web/AssetManager.h"
+#include "web/WebServerManager.h"
+#include "network/NetworkManager.h"
+#include "board/RestartManager.h"
+#include "network/ConfigSyncManager.h"
+#include "network/LanSyncManager.h"
 
 // Pins used for reset trigger and ground
 #define RESET_TRIGGER_PIN 14 // Reset trigger pin (D5, GPIO 14)
@@ -29,11 +40,21 @@ This file handles the main loop and setup of the program. It initializes the glo
 // Global objects
 EEPROMLayoutManager eepromManager; // EEPROM manager object
 const int relayPin = 5; // Pin for the relay module (D1, GPIO 5) 
-ESP8266WebServer server(80); // HTTP server object
+WebServerManager server; // HTTP and HTTPS servers
 RelayManager relayManager(relayPin); // Relay manager object
 TimeManager timeManager; // Time manager object
+NTPManager ntpManager; // NTP synchronization object
 ScheduleManager scheduleManager; // Schedule manager object
 AuthManager authManager; // Authentication manager object
+AssetManager assetManager; // Web files compiled into the firmware
+ArenaManager arenaManager; // Memory for the JSON documents of a web request, emptied after each request
+NetworkManager networkManager; // Wi-Fi, mDNS and HTTP server bring up
+RestartManager restartManager; // Planned restarts with the state kept in RTC memory
+ConfigSyncManager configSyncManager; // Pulls the schedule and settings from a config server
+LanSyncManager lanSyncManager; // Synchronized ringing with the other units on the LAN
+TaskManager taskManager; // Runs the subsystems below in priority order
+RingGuardManager ringGuardManager; // Puts off work that blocks the CPU while a ring is close
+PowerManager powerManager; // Light sleep while the loop is idle and no ring is close
 
 String deviceName; // Device name
 String uniqueURL; // Unique URL for the device
@@ -41,6 +62,74 @@ int ringDuration; // Ring duration in seconds
 unsigned long lastRingTime = 0; // Last time the bell rang
 const long checkInterval = 6000; // Interval to check if the bell should ring (1 minute)
 DynamicJsonDocument systemMessages(1024); // Array to store system messages
+unsigned long bootMillis = 0; // Time from power on until setup finished
+
+/********************************************************************************
+ * Tasks of the main loop, each does a short piece of work and returns
+********************************************************************************/
+
+// Check if the bell should ring, the clock is updated first
+static void ringTask() {
+    if (timeManager.update()) {
+        scheduleManager.handleRing();
+    }
+}
+
+// ezTime time zone events
+static void clockTask() {
+    events();
+}
+
+// Bring up the network and listen for mDNS queries
+static void networkTask() {
+    networkManager.update();
+}
+
+static void ntpTask() {
+    ntpManager.update();
+}
+
+static void configSyncTask() {
+    configSyncManager.update();
+}
+
+static void lanSyncTask() {
+    lanSyncManager.update();
+}
+
+// Handle incoming client requests, new HTTPS connections wait while a ring is close
+static void webTask() {
+    server.handleClient(!ringGuardManager.isOpen());
+    updateEndpoints();
+}
+
+// Run the work that was put off for a ring once it has rung
+static void ringGuardTask() {
+    ringGuardManager.update();
+}
+
+// Nap until the next pass if nothing needs the loop
+static void powerTask() {
+    powerManager.update();
+}
+
+/**
+ * The function `setupTasks` registers the tasks. The ring check runs first on every pass and between the
+ * other tasks, NTP and LAN sync next because their timestamps are taken when they run, the web server
+ * after them and the power task last, its nap ends the pass. Deadlines and budgets do not limit a task,
+ * they are what a run is measured against.
+ */
+static void setupTasks() {
+    taskManager.add("ring", ringTask, PRIORITY_RING, 0, 20, 5000);
+    taskManager.add("lanSync", lanSyncTask, PRIORITY_TIMING, 0, 20, 2000);
+    taskManager.add("ntp", ntpTask, PRIORITY_TIMING, 0, 20, 2000);
+    taskManager.add("network", networkTask, PRIORITY_NETWORK, 0, 100, 10000);
+    taskManager.add("configSync", configSyncTask, PRIORITY_NETWORK, 50, 1000, 20000);
+    taskManager.add("clock", clockTask, PRIORITY_BACKGROUND, 0, 500, 2000);
+    taskManager.add("web", webTask, PRIORITY_BACKGROUND, 0, 500, 50000);
+    taskManager.add("ringGuard", ringGuardTask, PRIORITY_BACKGROUND, 100, 1000, 50000);
+    taskManager.add("power", powerTask, PRIORITY_BACKGROUND, 0, 500, (PowerManager::MAX_NAP + 50) * 1000);
+}
 
 
 
@@ -51,7 +140,10 @@ void setup() {
     systemMessages.to<JsonArray>();
 
     // Add a small delay to allow for any conditions to stabilize
-    delay(DEBOUNCE_DELAY);
+    // A software restart cannot come from the reset button, so it skips the delay
+    if (ESP.getResetInfoPtr()->reason != REASON_SOFT_RESTART) {
+        delay(DEBOUNCE_DELAY);
+    }
 
     // Check if the reset condition is met
     // To reset the password to default, and clear WiFi credentials short GPIO 14 to ground WHILE pressing the reset button and hold 
@@ -61,6 +153,7 @@ void setup() {
         eepromManager.saveDeviceName("bellsystem"); // Reset the device name to default
         eepromManager.saveUniqueURL("bellsystem"); // Reset the unique URL to default
         eepromManager.saveRingDuration(2); // Reset the ring duration to default
+        eepromManager.saveTimezone("CST6CDT,M3.2.0,M11.1.0"); // Reset the time zone to default
 
         // Now perform the restart
         ESP.restart();
@@ -78,70 +171,50 @@ void setup() {
     }
 
 
-    // Initialize schedule manager, authentication manager, and relay manager objects
-    scheduleManager = ScheduleManager();
-    authManager.initialize();
+    // After a planned restart the settings, authentication state and schedule are restored from RTC memory,
+    // otherwise initialize the authentication manager and load settings from EEPROM. The schedule manager
+    // loads its own state in begin() below
+    if (restartManager.restoreSnapshot()) {
+        eepromManager.addSystemMessage("Warm restart, settings restored from RTC memory");
+    } else {
+        authManager.initialize();
+
+        deviceName = eepromManager.loadDeviceName();
+        uniqueURL = eepromManager.loadUniqueURL();
+        ringDuration = eepromManager.loadRingDuration();
+    }
     relayManager = RelayManager(relayPin);
 
-    // Load settings from EEPROM
-    deviceName = eepromManager.loadDeviceName();
-    uniqueURL = eepromManager.loadUniqueURL();
-    ringDuration = eepromManager.loadRingDuration();
+    setupTasks();
 
+    // Restore the clock if the board was only reset, so the bells ring before the network is up
+    timeManager.begin();
+
+    // Index the web files compiled into the firmware, they are served from flash and not from LittleFS
+    assetManager.begin();
 
-    // Initialize LittleFS file system and check if it was successful
+    // Initialize LittleFS file system and check if it was successful. Without it there is no schedule,
+    // but the clock, the network and the web pages still come up, so the failure can be seen and fixed
     if (!LittleFS.begin()) {
         eepromManager.addSystemMessage("LittleFS initialization failed.");
-        return;
     } else {
         eepromManager.addSystemMessage("LittleFS mounted successfully");
-    }
-
-    // Setup WiFi manager and connect to WiFi network if not already connected
-    WiFiManager wifiManager;
-
-    wifiManager.setConnectTimeout(30); // Set the connection timeout to 30 seconds
-    if (!wifiManager.autoConnect("BellSystemSetupAP")) {
-        ESP.restart();
-        delay(1000);
-    }
 
-    // Setup mDNS responder and check if it was successful
-    // Set the unique URL to the device name set by the user (default is bellsystem)
-    if (!MDNS.begin(uniqueURL)) { 
-        char buffer[100];
-        snprintf(buffer, sizeof(buffer), "MDNS responder failed to start. IP: %s", WiFi.localIP().toString().c_str());
-        systemMessages.add(buffer);
-    } else {
-        char buffer[100]; // Adjust size as needed
-        snprintf(buffer, sizeof(buffer), "MDNS started with URL: %s.local", uniqueURL.c_str());
-        systemMessages.add(buffer);
-        MDNS.addService("http", "tcp", 80);
+        // Open the schedule store, only today's and tomorrow's rings are kept in RAM
+        scheduleManager.begin();
     }
 
-    // Setup the time manager and begin the NTP client
-    timeManager.begin();
-
-    // Setup endpoints for the HTTP server
-    setupEndpoints();
+    // Connect to WiFi and start mDNS, NTP and the HTTP server in the background
+    networkManager.begin();
+    configSyncManager.begin();
+    lanSyncManager.begin();
+    powerManager.begin();
 
-    server.begin(); // Start the HTTP server
+    bootMillis = millis();
 }
 
 void loop() {
-    // Keep the time updated
-    events();
-
-    // Listen for incoming connections
-    MDNS.update();
-
-    // Check if the bell should ring, every minute
-    if (minuteChanged()) {
-        scheduleManager.handleRing();
-    }
-
-    // Handle incoming client requests
-    server.handleClient();
+    taskManager.run();
 }
 
 
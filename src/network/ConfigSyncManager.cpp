@@ -0,0 +1,364 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles pulling the schedule and settings from a config server on the LAN.
+The served document looks like {"schedule": {...}, "settings": {...}}, both parts are optional. The
+schedule is anything `/updateSchedule` accepts and goes through the same validation, the settings
+use the keys of `/saveSettings` except uniqueURL, which has to stay different on every device.
+Requests carry If-None-Match with the ETag the server sent, or the FNV-1a hash of the applied document
+(as "xxxxxxxx" in hex) so a server can answer 304 without keeping any state.
+*/
+
+#include "ConfigSyncManager.h"
+#include "schedule/scheduleManager.h"
+#include "schedule/NTPManager.h"
+#include "schedule/RingGuardManager.h"
+
+extern ScheduleManager scheduleManager;
+extern NTPManager ntpManager;
+extern String deviceName;
+extern int ringDuration;
+
+ConfigSyncManager::ConfigSyncManager() : intervalMinutes(0), port(80), state(IDLE), requestSentAt(0), nextPollAt(0), lastPollAt(0),
+                                         appliedHash(0), appliedCount(0) {}
+
+/**
+ * The `begin` function loads the config server URL and poll interval from EEPROM and schedules the
+ * first poll right away.
+ */
+void ConfigSyncManager::begin() {
+    url = eepromManager.loadSyncUrl();
+    intervalMinutes = eepromManager.loadSyncInterval();
+    appliedHash = eepromManager.loadSyncHash();
+    lastResult = intervalMinutes > 0 && parseUrl() ? "Waiting" : "Disabled";
+    nextPollAt = millis();
+}
+
+/**
+ * The `update` function drives the poll. A poll only starts while Wi-Fi is up and well away from the
+ * minute change, and the response is read a piece at a time from later calls, so neither the ring
+ * check nor `handleClient` waits for the config server.
+ */
+void ConfigSyncManager::update() {
+    if (intervalMinutes <= 0 || host.length() == 0) {
+        return;
+    }
+
+    if (state == IDLE) {
+        if ((long)(millis() - nextPollAt) < 0 || WiFi.status() != WL_CONNECTED || !timeManager.isTimeValid()) {
+            return;
+        }
+        uint8_t second = timeManager.getEpoch() % 60;
+        if (second < EARLIEST_SECOND || second > LATEST_SECOND) {
+            return;
+        }
+        startPoll();
+        return;
+    }
+
+    // Read whatever arrived since the last call
+    while (client.available() > 0 && response.length() < MAX_RESPONSE) {
+        char buffer[256];
+        size_t count = client.readBytes(buffer, min((size_t)client.available(), sizeof(buffer)));
+        response.concat(buffer, count);
+    }
+
+    if (!client.connected() && client.available() == 0) {
+        finishPoll();
+    } else if (response.length() >= MAX_RESPONSE) {
+        client.stop();
+        lastResult = "Response too large";
+        state = IDLE;
+        nextPollAt = millis() + RETRY_INTERVAL;
+    } else if (millis() - requestSentAt >= RESPONSE_TIMEOUT) {
+        client.stop();
+        lastResult = "Timed out";
+        state = IDLE;
+        nextPollAt = millis() + RETRY_INTERVAL;
+    }
+}
+
+/**
+ * The function `setSource` changes and saves the config server URL and poll interval.
+ * 
+ * @param newUrl URL of the config document, e.g. "http://192.168.1.10:8080/bells.json". Only plain
+ * http is supported, an IP address avoids a DNS lookup on every poll.
+ * @param newInterval Minutes between polls, 0 disables pulling.
+ * 
+ * @return `false` if the URL cannot be parsed or is too long, or the interval is out of range.
+ */
+bool ConfigSyncManager::setSource(const String& newUrl, int newInterval) {
+    if (newUrl.length() > 99 || newInterval < 0 || newInterval > 1440) {
+        return false;
+    }
+
+    String previousUrl = url;
+    url = newUrl;
+    if (newUrl.length() > 0 && !parseUrl()) {
+        url = previousUrl;
+        parseUrl();
+        return false;
+    }
+    if (newUrl.length() == 0) {
+        host = "";
+    }
+
+    intervalMinutes = newInterval;
+    if (state == RECEIVING) {
+        client.stop();
+        state = IDLE;
+    }
+    lastResult = intervalMinutes > 0 && host.length() > 0 ? "Waiting" : "Disabled";
+    nextPollAt = millis();
+    return eepromManager.saveSyncUrl(url) && eepromManager.saveSyncInterval(intervalMinutes);
+}
+
+String ConfigSyncManager::getUrl() {
+    return url;
+}
+
+int ConfigSyncManager::getIntervalMinutes() {
+    return intervalMinutes;
+}
+
+String ConfigSyncManager::getLastResult() {
+    return lastResult;
+}
+
+unsigned long ConfigSyncManager::getLastPollMillis() {
+    return lastPollAt;
+}
+
+uint32_t ConfigSyncManager::getAppliedCount() {
+    return appliedCount;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `parseUrl` splits the URL into host, port and path.
+ * 
+ * @return `false` if the URL is not an http:// URL.
+ */
+bool ConfigSyncManager::parseUrl() {
+    host = "";
+    if (!url.startsWith("http://")) {
+        return false;
+    }
+
+    int hostStart = 7;
+    int pathStart = url.indexOf('/', hostStart);
+    String authority = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+    path = pathStart < 0 ? String("/") : url.substring(pathStart);
+
+    int colon = authority.indexOf(':');
+    port = colon < 0 ? 80 : authority.substring(colon + 1).toInt();
+    host = colon < 0 ? authority : authority.substring(0, colon);
+    if (host.length() == 0 || port == 0) {
+        host = "";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The function `startPoll` connects to the config server and sends the conditional GET. Connecting and
+ * resolving the host are the only steps that can hold the loop, both are capped at CONNECT_TIMEOUT. The
+ * request is HTTP/1.0, so the server cannot answer with a chunked body.
+ */
+void ConfigSyncManager::startPoll() {
+    nextPollAt = millis() + (unsigned long)intervalMinutes * 60000;
+
+    IPAddress address;
+    if (!address.fromString(host) && !WiFi.hostByName(host.c_str(), address, CONNECT_TIMEOUT)) {
+        lastResult = "Cannot resolve " + host;
+        nextPollAt = millis() + RETRY_INTERVAL;
+        return;
+    }
+
+    client.setTimeout(CONNECT_TIMEOUT);
+    if (!client.connect(address, port)) {
+        lastResult = "Cannot connect to " + host;
+        nextPollAt = millis() + RETRY_INTERVAL;
+        return;
+    }
+
+    char hash[11];
+    snprintf(hash, sizeof(hash), "\"%08x\"", appliedHash);
+    String request = "GET " + path + " HTTP/1.0\r\n"
+                     "Host: " + host + "\r\n"
+                     "If-None-Match: " + (etag.length() > 0 ? etag : String(hash)) + "\r\n"
+                     "Connection: close\r\n\r\n";
+    client.print(request);
+
+    response = "";
+    requestSentAt = millis();
+    state = RECEIVING;
+}
+
+/**
+ * The function `finishPoll` handles a complete response: 304 leaves everything alone, 200 is applied
+ * unless its hash matches the document applied last. Applying writes flash, so a changed document that
+ * arrives while a ring is close is dropped and fetched again once the ring guard window has closed.
+ */
+void ConfigSyncManager::finishPoll() {
+    client.stop();
+    state = IDLE;
+    lastPollAt = millis();
+
+    int headerEnd = response.indexOf("\r\n\r\n");
+    if (!response.startsWith("HTTP/") || headerEnd < 0) {
+        lastResult = "Malformed response";
+        nextPollAt = millis() + RETRY_INTERVAL;
+        return;
+    }
+    int status = response.substring(response.indexOf(' ') + 1).toInt();
+
+    if (status == 304) {
+        lastResult = "Not modified";
+        response = "";
+        return;
+    }
+    if (status != 200) {
+        lastResult = "HTTP " + String(status);
+        nextPollAt = millis() + RETRY_INTERVAL;
+        response = "";
+        return;
+    }
+
+    // Remember the ETag the server sent, header names are case insensitive
+    String headers = response.substring(0, headerEnd);
+    String lowerHeaders = headers;
+    lowerHeaders.toLowerCase();
+    int etagStart = lowerHeaders.indexOf("\r\netag:");
+    String newEtag;
+    if (etagStart >= 0) {
+        int valueStart = etagStart + 7;
+        int valueEnd = headers.indexOf("\r\n", valueStart);
+        newEtag = headers.substring(valueStart, valueEnd < 0 ? headers.length() : valueEnd);
+        newEtag.trim();
+    }
+
+    String body = response.substring(headerEnd + 4);
+    response = "";
+    uint32_t bodyHash = hashBody(body);
+    if (bodyHash == appliedHash) {
+        etag = newEtag;
+        lastResult = "Unchanged";
+        return;
+    }
+
+    if (ringGuardManager.isOpen()) {
+        lastResult = "Put off for a ring";
+        nextPollAt = millis() + ringGuardManager.getRetryAfter() * 1000;
+        return;
+    }
+
+    if (!applyDocument(body)) {
+        nextPollAt = millis() + RETRY_INTERVAL;
+        return;
+    }
+
+    appliedHash = bodyHash;
+    etag = newEtag;
+    appliedCount++;
+    eepromManager.saveSyncHash(appliedHash);
+    lastResult = "Applied";
+    eepromManager.addSystemMessage("Schedule and settings updated from the config server.");
+}
+
+/**
+ * The function `applyDocument` applies the schedule and settings of a config document, all or nothing.
+ * The settings are checked first, then the schedule goes through `ScheduleManager::updateSchedule`, so
+ * an invalid schedule is rejected as a whole and the current one keeps ringing, and the settings are
+ * only applied once the schedule was. A rejected document leaves the device as it was, and is fetched
+ * and rejected again on every retry without writing anything.
+ * 
+ * @param body The config document.
+ * 
+ * @return `false` if the document could not be parsed or a part of it was rejected.
+ */
+bool ConfigSyncManager::applyDocument(const String& body) {
+    DynamicJsonDocument doc(6144);
+    if (deserializeJson(doc, body)) {
+        lastResult = "Error parsing JSON";
+        return false;
+    }
+
+    JsonObject settings = doc["settings"].as<JsonObject>();
+    if (doc.containsKey("settings") && !validateSettings(settings)) {
+        return false;
+    }
+
+    if (doc.containsKey("schedule")) {
+        if (!scheduleManager.updateSchedule(doc["schedule"].as<JsonObject>())) {
+            lastResult = "Invalid schedule";
+            return false;
+        }
+    }
+
+    if (doc.containsKey("settings")) {
+        applySettings(settings);
+    }
+    return true;
+}
+
+/**
+ * The function `validateSettings` checks the settings of a config document without applying them.
+ * 
+ * @param settings Object with any of deviceName, ringDuration, timezone and ntpServer.
+ * 
+ * @return `false` if a setting would be rejected, `lastResult` then tells which.
+ */
+bool ConfigSyncManager::validateSettings(JsonObject settings) {
+    if (settings.containsKey("ringDuration") && settings["ringDuration"].as<int>() <= 0) {
+        lastResult = "Invalid ring duration";
+        return false;
+    }
+    if (settings.containsKey("timezone") && !TimeManager::isValidTimezone(settings["timezone"].as<String>())) {
+        lastResult = "Invalid time zone";
+        return false;
+    }
+    if (settings.containsKey("ntpServer") && !NTPManager::isValidServer(settings["ntpServer"].as<String>())) {
+        lastResult = "Invalid NTP server";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * The function `applySettings` applies the settings of a config document, writing only the ones that
+ * changed. They were checked by `validateSettings`.
+ * 
+ * @param settings Object with any of deviceName, ringDuration, timezone and ntpServer.
+ */
+void ConfigSyncManager::applySettings(JsonObject settings) {
+    if (settings.containsKey("deviceName") && settings["deviceName"].as<String>() != deviceName) {
+        deviceName = settings["deviceName"].as<String>();
+        eepromManager.saveDeviceName(deviceName);
+    }
+
+    if (settings.containsKey("ringDuration") && settings["ringDuration"].as<int>() != ringDuration) {
+        ringDuration = settings["ringDuration"];
+        eepromManager.saveRingDuration(ringDuration);
+    }
+
+    if (settings.containsKey("timezone") && settings["timezone"].as<String>() != timeManager.getTimezone()) {
+        timeManager.setTimezone(settings["timezone"].as<String>());
+    }
+
+    if (settings.containsKey("ntpServer") && settings["ntpServer"].as<String>() != ntpManager.getServer()) {
+        ntpManager.setServer(settings["ntpServer"].as<String>());
+    }
+}
+
+/**
+ * The function `hashBody` returns the 32 bit FNV-1a hash of a config document.
+ */
+uint32_t ConfigSyncManager::hashBody(const String& body) {
+    uint32_t result = 2166136261UL;
+    for (size_t i = 0; i < body.length(); i++) {
+        result = (result ^ (uint8_t)body[i]) * 16777619UL;
+    }
+    return result;
+}
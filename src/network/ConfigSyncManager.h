@@ -0,0 +1,65 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles pulling the schedule and settings from a config server on the LAN. The device polls
+the configured URL with a conditional GET and only applies the document when it changed.
+*/
+
+#ifndef ConfigSyncManager_h
+#define ConfigSyncManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ArduinoJson.h>
+
+#include "board/EEPROMLayoutManager.h"
+
+extern EEPROMLayoutManager eepromManager;
+
+class ConfigSyncManager {
+public:
+    ConfigSyncManager();
+    void begin();
+    void update();
+    bool setSource(const String& url, int intervalMinutes);
+    String getUrl();
+    int getIntervalMinutes();
+    String getLastResult();
+    unsigned long getLastPollMillis();
+    uint32_t getAppliedCount();
+private:
+    static constexpr uint32_t CONNECT_TIMEOUT = 300; // Longest the loop can be held while connecting or resolving (ms)
+    static constexpr uint32_t RESPONSE_TIMEOUT = 5000; // Time allowed for the whole response (ms)
+    static constexpr uint32_t RETRY_INTERVAL = 60000; // Time before polling again after a failure (ms)
+    static constexpr size_t MAX_RESPONSE = 6144; // Largest response accepted, headers included
+    static constexpr uint8_t EARLIEST_SECOND = 5; // Polls start between these seconds of the minute,
+    static constexpr uint8_t LATEST_SECOND = 50;  // so they never overlap the ring check at the minute change
+
+    enum State { IDLE, RECEIVING };
+
+    bool parseUrl();
+    void startPoll();
+    void finishPoll();
+    bool applyDocument(const String& body);
+    bool validateSettings(JsonObject settings);
+    void applySettings(JsonObject settings);
+    static uint32_t hashBody(const String& body);
+
+    String url; // http://host[:port]/path, saved in EEPROM
+    int intervalMinutes; // Time between polls, 0 disables pulling
+    String host;
+    uint16_t port;
+    String path;
+    WiFiClient client;
+    State state;
+    String response; // Raw response received so far
+    unsigned long requestSentAt; // millis() when the request was sent
+    unsigned long nextPollAt; // millis() when the next poll is due
+    unsigned long lastPollAt; // millis() of the last completed poll
+    uint32_t appliedHash; // FNV-1a hash of the last applied document, saved in EEPROM
+    String etag; // ETag of the last applied document as sent by the server
+    String lastResult; // Outcome of the last poll, shown on the status page
+    uint32_t appliedCount; // Documents applied since boot
+};
+
+#endif
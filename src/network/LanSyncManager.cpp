@@ -0,0 +1,295 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles synchronized ringing of several units in one building.
+Packets are 24 byte UDP broadcasts on port 4210 (little endian):
+  "BSYN", version 1, type (1 = time beacon, 2 = ring announcement), sequence u16,
+  leader clock at sending (ms since 1970, i64), ring time (ms since 1970, i64, 0 for beacons)
+A broadcast can be held back by the access point, but never arrives early. A delay makes the
+(leader - local) difference smaller, so the follower keeps the largest difference of a window of beacons
+as the clock offset. Modem sleep is turned
+off in both modes because a sleeping station only receives broadcasts at DTIM beacons.
+*/
+
+#include "LanSyncManager.h"
+#include "board/RelayManager.h"
+#include "schedule/scheduleManager.h"
+#include "schedule/NTPManager.h"
+
+extern RelayManager relayManager;
+extern ScheduleManager scheduleManager;
+extern NTPManager ntpManager;
+
+LanSyncManager::LanSyncManager() : mode(OFF), started(false), sequence(0), lastBeaconAt(0), announcedRing(0), announceCopies(0),
+                                   lastAnnounceAt(0), locked(false), sampleCount(0), lastCorrection(0), beaconCount(0), armedRingCount(0) {}
+
+/**
+ * The `begin` function loads the mode saved in EEPROM. The socket is opened by `update` once Wi-Fi is up.
+ */
+void LanSyncManager::begin() {
+    uint8_t saved = eepromManager.loadLanSyncMode();
+    mode = saved <= FOLLOWER ? (Mode)saved : OFF;
+}
+
+/**
+ * The `update` function sends beacons and announcements as the leader, or reads them as a follower.
+ * It never waits, a packet is sent or read and the function returns.
+ */
+void LanSyncManager::update() {
+    if (mode == OFF || WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+    if (!started) {
+        udp.begin(PORT);
+        WiFi.setSleepMode(WIFI_NONE_SLEEP);
+        started = true;
+    }
+
+    if (mode == LEADER) {
+        leaderUpdate();
+    } else {
+        followerUpdate();
+    }
+}
+
+/**
+ * The function `setMode` changes and saves the mode.
+ * 
+ * @param newMode "off", "leader" or "follower".
+ * 
+ * @return `false` if the mode is unknown or could not be saved.
+ */
+bool LanSyncManager::setMode(const String& newMode) {
+    Mode parsed;
+    if (newMode == "off") {
+        parsed = OFF;
+    } else if (newMode == "leader") {
+        parsed = LEADER;
+    } else if (newMode == "follower") {
+        parsed = FOLLOWER;
+    } else {
+        return false;
+    }
+
+    mode = parsed;
+    locked = false;
+    sampleCount = 0;
+    announcedRing = 0;
+    ntpManager.setPaused(false);
+    if (mode == OFF && started) {
+        udp.stop();
+        started = false;
+    }
+    return eepromManager.saveLanSyncMode(mode);
+}
+
+String LanSyncManager::getModeString() {
+    return mode == LEADER ? "leader" : (mode == FOLLOWER ? "follower" : "off");
+}
+
+/**
+ * The function `isActive` tells if LAN sync is on, the unit then has to hear every broadcast.
+ */
+bool LanSyncManager::isActive() {
+    return mode != OFF;
+}
+
+/**
+ * The status getters tell if a follower is locked to a leader, which one, the last clock correction,
+ * the beacons sent or received and the rings pre-armed from announcements.
+ */
+bool LanSyncManager::isLocked() {
+    return locked;
+}
+
+IPAddress LanSyncManager::getLeader() {
+    return leader;
+}
+
+int32_t LanSyncManager::getLastCorrectionMillis() {
+    return lastCorrection;
+}
+
+uint32_t LanSyncManager::getBeaconCount() {
+    return beaconCount;
+}
+
+uint32_t LanSyncManager::getArmedRingCount() {
+    return armedRingCount;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `leaderUpdate` sends a time beacon every BEACON_INTERVAL and announces a ring in the
+ * next minute ANNOUNCE_LEAD before it is due, pre-arming its own relay for the same instant.
+ * Only rings of the current day are announced, a ring at midnight rings from the schedule on every unit.
+ */
+void LanSyncManager::leaderUpdate() {
+    if (!timeManager.isTimeValid()) {
+        return;
+    }
+    unsigned long now = millis();
+
+    if (now - lastBeaconAt >= BEACON_INTERVAL) {
+        lastBeaconAt = now;
+        beaconCount++;
+        sendPacket(TYPE_BEACON, 0);
+    }
+
+    int64_t nextMinute = timeManager.getMinuteStartMillis() + 60000;
+    if (nextMinute - timeManager.getEpochMillis() > (int64_t)ANNOUNCE_LEAD) {
+        return;
+    }
+    if (announcedRing != nextMinute) {
+        if (scheduleManager.getNextRingMinute() != timeManager.getMinuteOfDay() + 1) {
+            return;
+        }
+        announcedRing = nextMinute;
+        announceCopies = 0;
+        armRing(nextMinute);
+    }
+    if (announceCopies < ANNOUNCE_COPIES && (announceCopies == 0 || now - lastAnnounceAt >= ANNOUNCE_SPACING)) {
+        announceCopies++;
+        lastAnnounceAt = now;
+        sendPacket(TYPE_RING, announcedRing);
+    }
+}
+
+/**
+ * The function `followerUpdate` reads one packet, if one arrived, and hands the clock back to NTP when
+ * the leader has been silent for LEADER_TIMEOUT.
+ */
+void LanSyncManager::followerUpdate() {
+    if (locked && millis() - lastBeaconAt >= LEADER_TIMEOUT) {
+        locked = false;
+        sampleCount = 0;
+        ntpManager.setPaused(false);
+        eepromManager.addSystemMessage("LAN sync leader lost, using NTP.");
+    }
+
+    if (udp.parsePacket() != PACKET_SIZE) {
+        return;
+    }
+    int64_t receivedMillis = timeManager.getEpochMillis();
+    uint8_t packet[PACKET_SIZE];
+    udp.read(packet, sizeof(packet));
+    if (memcmp(packet, "BSYN", 4) != 0 || packet[4] != 1) {
+        return;
+    }
+
+    // Stay with one leader until it goes silent
+    IPAddress sender = udp.remoteIP();
+    if (locked && sender != leader) {
+        return;
+    }
+
+    int64_t leaderMillis, ringAt;
+    memcpy(&leaderMillis, packet + 8, 8);
+    memcpy(&ringAt, packet + 16, 8);
+    if (packet[5] == TYPE_BEACON) {
+        leader = sender;
+        handleBeacon(leaderMillis, receivedMillis);
+    } else if (packet[5] == TYPE_RING && locked) {
+        handleRing(ringAt);
+    }
+}
+
+/**
+ * The function `sendPacket` broadcasts one packet to the local subnet.
+ * 
+ * @param type TYPE_BEACON or TYPE_RING.
+ * @param ringAt Ring time for TYPE_RING, 0 for beacons.
+ */
+void LanSyncManager::sendPacket(uint8_t type, int64_t ringAt) {
+    uint8_t packet[PACKET_SIZE];
+    memcpy(packet, "BSYN", 4);
+    packet[4] = 1;
+    packet[5] = type;
+    memcpy(packet + 6, &sequence, 2);
+    sequence++;
+    int64_t leaderMillis = timeManager.getEpochMillis();
+    memcpy(packet + 8, &leaderMillis, 8);
+    memcpy(packet + 16, &ringAt, 8);
+
+    udp.beginPacket(WiFi.broadcastIP(), PORT);
+    udp.write(packet, sizeof(packet));
+    udp.endPacket();
+}
+
+/**
+ * The function `handleBeacon` collects the clock difference to the leader and corrects the clock once
+ * every WINDOW beacons. The difference is the offset minus the delay on the way, so the largest one is
+ * the least delayed. The first correction (or a large one) steps the clock, later ones are slewed.
+ * 
+ * @param leaderMillis Leader clock when the beacon was sent.
+ * @param receivedMillis Local clock when the beacon was read.
+ */
+void LanSyncManager::handleBeacon(int64_t leaderMillis, int64_t receivedMillis) {
+    lastBeaconAt = millis();
+    beaconCount++;
+
+    int64_t difference = leaderMillis - receivedMillis;
+    if (!timeManager.isTimeValid() || difference > STEP_THRESHOLD || difference < -STEP_THRESHOLD) {
+        // Far off (or never set), follow the leader right away and measure again
+        timeManager.stepClock(difference);
+        lastCorrection = constrain(difference, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+        sampleCount = 0;
+        return;
+    }
+
+    samples[sampleCount++] = difference;
+    if (sampleCount < WINDOW) {
+        return;
+    }
+
+    int32_t offset = samples[0];
+    for (uint8_t i = 1; i < WINDOW; i++) {
+        offset = max(offset, samples[i]);
+    }
+    sampleCount = 0;
+    lastCorrection = offset;
+    if (locked) {
+        timeManager.slewClock(offset, WINDOW * BEACON_INTERVAL);
+    } else {
+        timeManager.stepClock(offset); // Slewing the first offset of up to a second would take minutes
+    }
+
+    if (!locked) {
+        locked = true;
+        ntpManager.setPaused(true);
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "LAN sync locked to leader %s", leader.toString().c_str());
+        eepromManager.addSystemMessage(buffer);
+    }
+}
+
+/**
+ * The function `handleRing` pre-arms the relay for an announced ring. The copies of an announcement
+ * are ignored after the first one.
+ * 
+ * @param ringAt Ring time on the leader clock, which the follower clock follows.
+ */
+void LanSyncManager::handleRing(int64_t ringAt) {
+    if (ringAt == announcedRing) {
+        return;
+    }
+    announcedRing = ringAt;
+    armRing(ringAt);
+}
+
+/**
+ * The function `armRing` pre-arms the relay to close at `ringAt` on the local clock. The ring of the
+ * own schedule in that minute is then skipped by the relay manager.
+ * 
+ * @param ringAt Ring time in ms since 1970.
+ */
+void LanSyncManager::armRing(int64_t ringAt) {
+    int64_t leadMillis = ringAt - timeManager.getEpochMillis();
+    if (leadMillis < 0 || leadMillis > 10000) {
+        return; // Late or nonsense, the schedule rings on its own
+    }
+    if (relayManager.armRelay(leadMillis, ringAt / 60000)) {
+        armedRingCount++;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles synchronized ringing of several units in one building. One unit (the leader)
+broadcasts its clock and "ring at T" announcements on the LAN, the others (followers) discipline their
+clock to it and pre-arm their relay for the announced instant.
+*/
+
+#ifndef LanSyncManager_h
+#define LanSyncManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#include "board/EEPROMLayoutManager.h"
+
+extern EEPROMLayoutManager eepromManager;
+
+class LanSyncManager {
+public:
+    enum Mode { OFF = 0, LEADER = 1, FOLLOWER = 2 };
+
+    LanSyncManager();
+    void begin();
+    void update();
+    bool setMode(const String& mode);
+    String getModeString();
+    bool isActive();
+    bool isLocked();
+    IPAddress getLeader();
+    int32_t getLastCorrectionMillis();
+    uint32_t getBeaconCount();
+    uint32_t getArmedRingCount();
+private:
+    static constexpr uint16_t PORT = 4210;
+    static constexpr uint32_t BEACON_INTERVAL = 2000; // Time between leader time beacons (ms)
+    static constexpr uint8_t WINDOW = 8; // Beacons per clock correction
+    static constexpr uint32_t LEADER_TIMEOUT = 30000; // Leader considered lost after this long without a beacon (ms)
+    static constexpr int32_t STEP_THRESHOLD = 1000; // Offsets larger than this are stepped (ms)
+    static constexpr uint32_t ANNOUNCE_LEAD = 2000; // A ring is first announced this long before it is due (ms)
+    static constexpr uint8_t ANNOUNCE_COPIES = 3; // Announcements per ring, broadcasts can be lost
+    static constexpr uint32_t ANNOUNCE_SPACING = 400; // Time between the copies (ms)
+    static constexpr uint8_t PACKET_SIZE = 24;
+    static constexpr uint8_t TYPE_BEACON = 1;
+    static constexpr uint8_t TYPE_RING = 2;
+
+    void leaderUpdate();
+    void followerUpdate();
+    void sendPacket(uint8_t type, int64_t ringAt);
+    void handleBeacon(int64_t leaderMillis, int64_t receivedMillis);
+    void handleRing(int64_t ringAt);
+    void armRing(int64_t ringAt);
+
+    WiFiUDP udp;
+    Mode mode;
+    bool started; // The UDP port is open
+    uint16_t sequence;
+    unsigned long lastBeaconAt; // millis() the last beacon was sent or received
+    int64_t announcedRing; // Ring time announced (leader) or armed (follower) last
+    uint8_t announceCopies; // Copies of announcedRing sent so far
+    unsigned long lastAnnounceAt;
+    IPAddress leader; // Leader the follower is locked to
+    bool locked; // The follower clock follows the leader
+    int32_t samples[WINDOW]; // Leader clock - local clock at reception (ms)
+    uint8_t sampleCount;
+    int32_t lastCorrection; // Last correction applied to the follower clock (ms)
+    uint32_t beaconCount; // Beacons sent (leader) or received (follower)
+    uint32_t armedRingCount; // Rings pre-armed from announcements
+};
+
+#endif
@@ -0,0 +1,344 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles bringing up Wi-Fi, mDNS, NTP and the HTTP server. Nothing here blocks the main loop:
+the cached access point is tried first without scanning, then the saved network with a scan, then the
+WiFiManager setup AP is served from `update` until it times out and the saved network is tried again.
+Once connected, a lost link is reconnected with an increasing backoff instead of waiting for a power cycle.
+*/
+
+#include "NetworkManager.h"
+#include <coredecls.h>
+
+#include "schedule/NTPManager.h"
+#include "schedule/scheduleManager.h"
+#include "web/Endpoints.h"
+
+extern ScheduleManager scheduleManager;
+
+NetworkManager::NetworkManager() : cacheValid(false), state(IDLE), stateSince(0), attemptSince(0), retryAt(0), attemptActive(false),
+                                   attemptFast(false), backoff(MIN_BACKOFF), servicesStarted(false), linkLossCount(0),
+                                   reconnectCount(0), lastConnectMillis(0), lastConnectFast(false), httpService(nullptr),
+                                   lastSignature(0), lastBeaconCheck(0) {}
+
+/**
+ * The `begin` function loads the connection cache and starts connecting to the saved network, or opens
+ * the setup AP right away if no network was saved yet. It returns immediately.
+ */
+void NetworkManager::begin() {
+    wifiManager.setConfigPortalBlocking(false);
+    wifiManager.setConfigPortalTimeout(PORTAL_TIMEOUT);
+
+    eepromManager.loadWifiCache((uint8_t*)&cache, sizeof(cache));
+    cacheValid = cache.magic == CACHE_MAGIC && cache.crc == crc32(&cache, offsetof(WifiCache, crc));
+
+    // The supervisor reconnects itself, the SDK would retry with a scan every time
+    WiFi.setAutoReconnect(false);
+
+    if (WiFi.SSID().length() == 0) {
+        startPortal();
+    } else {
+        startConnecting();
+    }
+}
+
+/**
+ * The `update` function advances the connection state machine and serves mDNS. It is called on every
+ * loop iteration and only does work when a state changes or an attempt times out.
+ */
+void NetworkManager::update() {
+    unsigned long now = millis();
+
+    switch (state) {
+        case IDLE:
+            return;
+
+        case CONNECTING:
+            if (WiFi.status() == WL_CONNECTED) {
+                onConnected();
+            } else if (now - stateSince >= CONNECT_TIMEOUT) {
+                eepromManager.addSystemMessage("WiFi connection failed, setup AP opened.");
+                startPortal();
+            } else if (attemptFast && now - attemptSince >= FAST_CONNECT_TIMEOUT) {
+                startAttempt(false); // The cached access point did not answer, scan for the network
+            }
+            break;
+
+        case PORTAL:
+            if (wifiManager.process()) {
+                cacheValid = false; // New credentials, the cached access point may be another network
+                onConnected();
+            } else if (!wifiManager.getConfigPortalActive()) {
+                startConnecting(); // The setup AP timed out, try the saved network again
+            }
+            break;
+
+        case CONNECTED:
+            if (WiFi.status() != WL_CONNECTED) {
+                linkLossCount++;
+                eepromManager.addSystemMessage("WiFi connection lost, reconnecting.");
+                state = RECONNECTING;
+                stateSince = now;
+                backoff = MIN_BACKOFF;
+                startAttempt(cacheValid);
+            }
+            break;
+
+        case RECONNECTING:
+            if (WiFi.status() == WL_CONNECTED) {
+                reconnectCount++;
+                onConnected();
+            } else if (!attemptActive) {
+                if ((long)(now - retryAt) >= 0) {
+                    startAttempt(cacheValid);
+                }
+            } else if (attemptFast && now - attemptSince >= FAST_CONNECT_TIMEOUT) {
+                startAttempt(false);
+            } else if (now - attemptSince >= RECONNECT_TIMEOUT) {
+                // Give up on this attempt and wait, doubling the wait every time
+                WiFi.disconnect();
+                attemptActive = false;
+                retryAt = now + backoff;
+                backoff = min(backoff * 2, MAX_BACKOFF);
+            }
+            break;
+    }
+
+    if (servicesStarted) {
+        // Announce the TXT records again when a value other than uptime or free heap changed
+        if (httpService != nullptr && now - lastBeaconCheck >= BEACON_INTERVAL) {
+            lastBeaconCheck = now;
+            uint32_t signature = beaconSignature();
+            if (signature != lastSignature) {
+                lastSignature = signature;
+                MDNS.announce();
+            }
+        }
+        MDNS.update();
+    }
+}
+
+/**
+ * The function `isConnected` tells if the board is connected to the Wi-Fi network.
+ */
+bool NetworkManager::isConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+/**
+ * The function `setHostname` renames the device at runtime. The mDNS responder is closed, which sends a
+ * goodbye for the old name so clients drop it from their caches, and started again under the new name
+ * with the HTTP service advertised. Connected clients, the login token and the ring schedule are not
+ * affected. Before the first connection the name is simply used when the services start.
+ * 
+ * @param name The new host name, without ".local".
+ * 
+ * @return `false` if the mDNS responder could not be started under the new name.
+ */
+bool NetworkManager::setHostname(const String& name) {
+    uniqueURL = name;
+    WiFi.hostname(uniqueURL); // Used for DHCP from the next lease on
+
+    if (!servicesStarted) {
+        return true;
+    }
+
+    MDNS.end();
+    return startMDNS();
+}
+
+/**
+ * The connection metrics count how often the link was lost and reconnected, and how long the last
+ * connection (from the start of connecting, or from the link loss) took.
+ */
+uint32_t NetworkManager::getLinkLossCount() {
+    return linkLossCount;
+}
+
+uint32_t NetworkManager::getReconnectCount() {
+    return reconnectCount;
+}
+
+uint32_t NetworkManager::getLastConnectMillis() {
+    return lastConnectMillis;
+}
+
+bool NetworkManager::isFastConnect() {
+    return lastConnectFast;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `startConnecting` starts connecting to the saved network, through the cached access
+ * point if there is one.
+ */
+void NetworkManager::startConnecting() {
+    WiFi.mode(WIFI_STA);
+    state = CONNECTING;
+    stateSince = millis();
+    startAttempt(cacheValid);
+}
+
+/**
+ * The function `startAttempt` starts one connection attempt without waiting for it. A fast attempt
+ * goes straight to the cached channel and BSSID, which skips the scan. A normal attempt scans for the
+ * saved network. Both use DHCP, reusing the last address statically could collide with another device
+ * once the lease expires.
+ * 
+ * @param fast Use the cached access point.
+ */
+void NetworkManager::startAttempt(bool fast) {
+    WiFi.persistent(false); // Do not write the channel and BSSID to the SDK config in flash
+    if (fast) {
+        WiFi.begin(WiFi.SSID(), WiFi.psk(), cache.channel, cache.bssid);
+    } else {
+        WiFi.begin(WiFi.SSID(), WiFi.psk());
+    }
+    WiFi.persistent(true);
+
+    attemptActive = true;
+    attemptFast = fast;
+    attemptSince = millis();
+}
+
+/**
+ * The function `startPortal` opens the "BellSystemSetupAP" configuration portal. It runs from `update`
+ * through `WiFiManager::process` so the bells keep ringing while it is open.
+ */
+void NetworkManager::startPortal() {
+    wifiManager.startConfigPortal("BellSystemSetupAP");
+    state = PORTAL;
+    stateSince = millis();
+}
+
+/**
+ * The function `onConnected` records the connection metrics, refreshes the cache and starts the
+ * services on the first connection. After a reconnection the services keep running, mDNS is announced
+ * again so the name resolves right away.
+ */
+void NetworkManager::onConnected() {
+    unsigned long now = millis();
+    lastConnectMillis = now - stateSince;
+    lastConnectFast = attemptFast && state != PORTAL;
+
+    state = CONNECTED;
+    stateSince = now;
+    attemptActive = false;
+    backoff = MIN_BACKOFF;
+
+    saveCache();
+    if (servicesStarted) {
+        MDNS.announce();
+    } else {
+        startServices();
+    }
+}
+
+/**
+ * The function `saveCache` saves the channel and BSSID of the current connection. The EEPROM is only
+ * written when they changed, e.g. after the access point was replaced or changed its channel.
+ */
+void NetworkManager::saveCache() {
+    WifiCache current;
+    memset(&current, 0, sizeof(current));
+    current.magic = CACHE_MAGIC;
+    current.channel = WiFi.channel();
+    memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+    current.crc = crc32(&current, offsetof(WifiCache, crc));
+
+    if (!cacheValid || memcmp(&current, &cache, sizeof(cache)) != 0) {
+        cache = current;
+        cacheValid = eepromManager.saveWifiCache((uint8_t*)&cache, sizeof(cache));
+    }
+}
+
+/**
+ * The function `startServices` starts the mDNS responder, NTP synchronization and the HTTP and HTTPS
+ * servers the first time the board connects. The HTTP server cannot start earlier because the setup AP
+ * uses port 80.
+ */
+void NetworkManager::startServices() {
+    servicesStarted = true;
+
+    // Setup endpoints for the HTTP and HTTPS servers, the HTTPS service is advertised if it started
+    setupEndpoints();
+    server.begin();
+    startMDNS();
+
+    // Start synchronizing the clock
+    ntpManager.begin();
+}
+
+/**
+ * The function `startMDNS` starts the mDNS responder under the unique URL set by the user (default is
+ * bellsystem) and advertises the HTTP service with the status TXT records.
+ * 
+ * @return `false` if the responder failed to start.
+ */
+bool NetworkManager::startMDNS() {
+    char buffer[100];
+    bool started = MDNS.begin(uniqueURL);
+    httpService = nullptr;
+    if (!started) {
+        snprintf(buffer, sizeof(buffer), "MDNS responder failed to start. IP: %s", WiFi.localIP().toString().c_str());
+    } else {
+        snprintf(buffer, sizeof(buffer), "MDNS started with URL: %s.local", uniqueURL.c_str());
+        httpService = MDNS.addService(nullptr, "http", "tcp", WebServerManager::HTTP_PORT);
+        if (server.isSecureRunning()) {
+            MDNS.addService(nullptr, "https", "tcp", WebServerManager::HTTPS_PORT);
+        }
+
+        // The TXT records are filled in when a query is answered, so they are always current
+        MDNS.setDynamicServiceTxtCallback(httpService, [this](const MDNSResponder::hMDNSService service) {
+            addBeaconTxt(service);
+        });
+        lastSignature = beaconSignature();
+    }
+    eepromManager.addSystemMessage(buffer);
+    return started;
+}
+
+/**
+ * The function `addBeaconTxt` adds the status TXT records to the HTTP service, so a whole fleet can be
+ * surveyed with one multicast query instead of an HTTP request to every device:
+ * ver (firmware version), sched (schedule hash), next (next ring today, HH:MM or "-"),
+ * up (uptime in seconds), heap (free heap in bytes), sync ("ntp", "restored" or "none").
+ * 
+ * @param service The service the records are added to.
+ */
+void NetworkManager::addBeaconTxt(MDNSResponder::hMDNSService service) {
+    char schedule[9];
+    snprintf(schedule, sizeof(schedule), "%08x", scheduleManager.getScheduleHash());
+
+    char next[6] = "-";
+    uint16_t nextRing = scheduleManager.getNextRingMinute();
+    if (nextRing != CompactSchedule::NO_RING) {
+        snprintf(next, sizeof(next), "%02u:%02u", nextRing / 60, nextRing % 60);
+    }
+
+    const char* sync = "none";
+    if (ntpManager.isSynchronized()) {
+        sync = "ntp";
+    } else if (timeManager.isTimeRestored()) {
+        sync = "restored";
+    }
+
+    MDNS.addDynamicServiceTxt(service, "ver", FIRMWARE_VERSION);
+    MDNS.addDynamicServiceTxt(service, "sched", schedule);
+    MDNS.addDynamicServiceTxt(service, "next", next);
+    MDNS.addDynamicServiceTxt(service, "up", (uint32_t)(millis() / 1000));
+    MDNS.addDynamicServiceTxt(service, "heap", ESP.getFreeHeap());
+    MDNS.addDynamicServiceTxt(service, "sync", sync);
+}
+
+/**
+ * The function `beaconSignature` combines the TXT values that should be announced as soon as they
+ * change. Uptime and free heap change all the time and are only sent in answers to queries.
+ * 
+ * @return A hash of the schedule hash, the next ring and the sync state.
+ */
+uint32_t NetworkManager::beaconSignature() {
+    uint32_t syncState = ntpManager.isSynchronized() ? 2 : (timeManager.isTimeRestored() ? 1 : 0);
+    return (scheduleManager.getScheduleHash() * 31 + scheduleManager.getNextRingMinute()) * 31 + syncState;
+}
@@ -0,0 +1,94 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles bringing up Wi-Fi, mDNS, NTP and the HTTP server in the background, so the bells
+can ring from the restored clock while the network is still connecting. It also watches the link and
+reconnects on its own when the access point drops.
+*/
+
+#ifndef NetworkManager_h
+#define NetworkManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <ESP8266mDNS.h>
+#include <WiFiManager.h>
+
+#include "board/EEPROMLayoutManager.h"
+#include "web/WebServerManager.h"
+
+// Reported in the mDNS TXT records, set with -DFIRMWARE_VERSION in platformio.ini
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "dev"
+#endif
+
+class NTPManager;
+
+extern EEPROMLayoutManager eepromManager;
+extern NTPManager ntpManager;
+extern WebServerManager server;
+extern String uniqueURL;
+
+class NetworkManager {
+public:
+    NetworkManager();
+    void begin();
+    void update();
+    bool isConnected();
+    bool setHostname(const String& name);
+    uint32_t getLinkLossCount();
+    uint32_t getReconnectCount();
+    uint32_t getLastConnectMillis();
+    bool isFastConnect();
+private:
+    static constexpr uint32_t FAST_CONNECT_TIMEOUT = 5000; // Time to wait for a connection to the cached access point (ms)
+    static constexpr uint32_t CONNECT_TIMEOUT = 30000; // Time to wait for the saved network before opening the setup AP (ms)
+    static constexpr uint32_t RECONNECT_TIMEOUT = 15000; // Time to wait for each reconnect attempt with a scan (ms)
+    static constexpr uint32_t MIN_BACKOFF = 1000; // Wait before the first reconnect retry (ms)
+    static constexpr uint32_t MAX_BACKOFF = 60000; // Longest wait between reconnect retries (ms)
+    static constexpr uint32_t PORTAL_TIMEOUT = 180; // Time the setup AP stays open before retrying the saved network (s)
+    static constexpr uint8_t CACHE_MAGIC = 0xB5;
+    static constexpr uint32_t BEACON_INTERVAL = 1000; // Time between checks of the TXT record values (ms)
+
+    enum State { IDLE, CONNECTING, PORTAL, CONNECTED, RECONNECTING };
+
+    // Last good access point, saved in EEPROM to connect without scanning
+    struct WifiCache {
+        uint8_t magic;
+        uint8_t channel;
+        uint8_t bssid[6];
+        uint32_t crc; // CRC32 of the fields above
+    };
+
+    void startConnecting();
+    void startAttempt(bool fast);
+    void startPortal();
+    void onConnected();
+    void saveCache();
+    void startServices();
+    bool startMDNS();
+    void addBeaconTxt(MDNSResponder::hMDNSService service);
+    uint32_t beaconSignature();
+
+    WiFiManager wifiManager;
+    WifiCache cache;
+    bool cacheValid; // The cache holds a connection made with the saved credentials
+    State state;
+    unsigned long stateSince; // millis() when the current state was entered
+    unsigned long attemptSince; // millis() when the current connection attempt started
+    unsigned long retryAt; // millis() of the next reconnect attempt
+    bool attemptActive; // A connection attempt is in progress, otherwise waiting for retryAt
+    bool attemptFast; // The current attempt uses the cache
+    uint32_t backoff; // Wait before the next reconnect attempt (ms)
+    bool servicesStarted; // mDNS, NTP and HTTP are started once, on the first connection
+    uint32_t linkLossCount;
+    uint32_t reconnectCount;
+    uint32_t lastConnectMillis; // Time the last connection or reconnection took (ms)
+    bool lastConnectFast; // The last connection used the cache
+    MDNSResponder::hMDNSService httpService; // The advertised HTTP service carrying the TXT records
+    uint32_t lastSignature; // Signature of the TXT values last announced
+    unsigned long lastBeaconCheck; // millis() of the last check of the TXT values
+};
+
+#endif
@@ -0,0 +1,442 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the compact binary representation of the ring schedule.
+Ring code is a stream of entries: OP_DAYS selects the weekdays the following entries apply to, a
+literal ring takes two bytes, and OP_EVERY / OP_PLUS describe recurring rings that are only expanded
+into a single day's bitmap by `decodeDay`. See the layout comment in CompactSchedule.h.
+*/
+
+#include "CompactSchedule.h"
+
+CompactSchedule::CompactSchedule() {
+    clear();
+}
+
+/**
+ * The function `load` replaces the current blob with the given data after checking the header, the
+ * profile table and the ring code of every profile.
+ *
+ * @param data Pointer to the blob, usually read back from EEPROM.
+ * @param length Number of bytes available at `data`.
+ *
+ * @return `true` if the blob is well formed and was loaded, `false` if it was rejected (the current
+ * schedule is left untouched in that case).
+ */
+bool CompactSchedule::load(const uint8_t* data, size_t length) {
+    if (length < HEADER_SIZE || data[0] != 'B' || data[1] != 'S' || data[2] != FORMAT_VERSION) return false;
+
+    uint8_t count = data[3];
+    size_t total = data[4] | (data[5] << 8);
+    if (count > MAX_PROFILES || total > length || total > MAX_SIZE) return false;
+
+    size_t codeStart = HEADER_SIZE + count * PROFILE_HEADER_SIZE;
+    if (total < codeStart) return false;
+
+    // Every profile's code must lie inside the blob and decode cleanly
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* header = data + HEADER_SIZE + i * PROFILE_HEADER_SIZE;
+        size_t offset = header[16] | (header[17] << 8);
+        size_t codeLength = header[18] | (header[19] << 8);
+        if (offset < codeStart || offset + codeLength > total) return false;
+        if (!validateCode(data + offset, codeLength)) return false;
+    }
+
+    blob.assign(data, data + total);
+    return true;
+}
+
+/**
+ * The function `clear` resets the blob to an empty schedule with no profiles.
+ */
+void CompactSchedule::clear() {
+    blob.assign(HEADER_SIZE, 0);
+    blob[0] = 'B';
+    blob[1] = 'S';
+    blob[2] = FORMAT_VERSION;
+    blob[4] = HEADER_SIZE;
+}
+
+const uint8_t* CompactSchedule::data() const {
+    return blob.data();
+}
+
+size_t CompactSchedule::size() const {
+    return blob.size();
+}
+
+uint8_t CompactSchedule::profileCount() const {
+    return blob[3];
+}
+
+/**
+ * The function `findProfile` looks up a profile by name.
+ *
+ * @param name Name of the profile to look for.
+ *
+ * @return The index of the profile, or `NO_PROFILE` if there is no profile with that name.
+ */
+uint8_t CompactSchedule::findProfile(const String& name) const {
+    for (uint8_t i = 0; i < profileCount(); i++) {
+        if (name == profileName(i)) return i;
+    }
+    return NO_PROFILE;
+}
+
+String CompactSchedule::profileName(uint8_t profile) const {
+    char name[MAX_NAME_LENGTH + 1];
+    memcpy(name, &blob[profileHeader(profile)], MAX_NAME_LENGTH + 1);
+    name[MAX_NAME_LENGTH] = '\0';
+    return String(name);
+}
+
+uint16_t CompactSchedule::profileStartDay(uint8_t profile) const {
+    return readWord(profileHeader(profile) + 12);
+}
+
+uint16_t CompactSchedule::profileEndDay(uint8_t profile) const {
+    return readWord(profileHeader(profile) + 14);
+}
+
+/**
+ * The function `profileCode` locates the ring code of a profile inside the blob.
+ *
+ * @param profile Index of the profile.
+ * @param code Set to the first byte of the profile's ring code.
+ * @param length Set to the length of the ring code in bytes.
+ */
+void CompactSchedule::profileCode(uint8_t profile, const uint8_t*& code, size_t& length) const {
+    size_t header = profileHeader(profile);
+    code = blob.data() + readWord(header + 16);
+    length = readWord(header + 18);
+}
+
+/**
+ * The function `setProfile` adds a profile, or replaces the profile with the same name in place so
+ * the indexes of the other profiles are unchanged.
+ *
+ * @param name Name of the profile (1 to MAX_NAME_LENGTH characters).
+ * @param startDay First day the profile is active, or `NO_DATE`.
+ * @param endDay Last day the profile is active, or `NO_DATE`.
+ * @param code Ring code of the profile, usually produced by `encodeDays`.
+ *
+ * @return `false` if the name is invalid, the profile table is full or the result would not fit
+ * in `MAX_SIZE` bytes. The schedule is unchanged in that case.
+ */
+bool CompactSchedule::setProfile(const String& name, uint16_t startDay, uint16_t endDay, const std::vector<uint8_t>& code) {
+    if (name.length() == 0 || name.length() > MAX_NAME_LENGTH) return false;
+    if (!validateCode(code.data(), code.size())) return false;
+
+    std::vector<String> names;
+    std::vector<uint16_t> starts;
+    std::vector<uint16_t> ends;
+    std::vector<std::vector<uint8_t>> codes;
+    size_t total = HEADER_SIZE;
+    bool replaced = false;
+
+    for (uint8_t i = 0; i < profileCount(); i++) {
+        size_t header = profileHeader(i);
+        size_t offset = readWord(header + 16);
+        size_t length = readWord(header + 18);
+
+        names.push_back(profileName(i));
+        starts.push_back(profileStartDay(i));
+        ends.push_back(profileEndDay(i));
+        codes.push_back(std::vector<uint8_t>(blob.begin() + offset, blob.begin() + offset + length));
+
+        if (names.back() == name) {
+            starts.back() = startDay;
+            ends.back() = endDay;
+            codes.back() = code;
+            replaced = true;
+        }
+        total += PROFILE_HEADER_SIZE + codes.back().size();
+    }
+
+    if (!replaced) {
+        if (profileCount() >= MAX_PROFILES) return false;
+        names.push_back(name);
+        starts.push_back(startDay);
+        ends.push_back(endDay);
+        codes.push_back(code);
+        total += PROFILE_HEADER_SIZE + code.size();
+    }
+
+    if (total > MAX_SIZE) return false;
+
+    rebuild(names, starts, ends, codes);
+    return true;
+}
+
+/**
+ * The function `encodeDays` turns per-day lists of ring minutes into ring code. Each list is sorted
+ * and de-duplicated, and days with identical lists are grouped under a single OP_DAYS entry.
+ *
+ * @param days Ring minutes for each weekday, index 0 = Sunday. The lists are sorted in place.
+ * @param code Output buffer, the ring code is appended to it.
+ */
+void CompactSchedule::encodeDays(std::vector<uint16_t> (&days)[7], std::vector<uint8_t>& code) {
+    for (auto& times : days) {
+        std::sort(times.begin(), times.end());
+        times.erase(std::unique(times.begin(), times.end()), times.end());
+    }
+
+    uint8_t done = 0;
+    for (uint8_t day = 0; day < 7; day++) {
+        if ((done & (1 << day)) || days[day].empty()) continue;
+
+        // Collect every later day with the same ring list
+        uint8_t mask = 1 << day;
+        for (uint8_t other = day + 1; other < 7; other++) {
+            if (days[other] == days[day]) mask |= 1 << other;
+        }
+        done |= mask;
+
+        code.push_back(OP_DAYS);
+        code.push_back(mask);
+        for (uint16_t minute : days[day]) {
+            code.push_back(minute >> 8);
+            code.push_back(minute & 0xFF);
+        }
+    }
+}
+
+/**
+ * The function `encodeRule` appends a recurring rule to ring code. A rule takes 8 bytes plus 2 bytes
+ * per offset, no matter how many rings it produces.
+ *
+ * @param rule The rule to encode.
+ * @param code Output buffer, the rule is appended to it.
+ *
+ * @return `false` if the rule is invalid (no days, times out of range, `from` after `to` or a zero
+ * interval). Nothing is appended in that case.
+ */
+bool CompactSchedule::encodeRule(const RingRule& rule, std::vector<uint8_t>& code) {
+    if (rule.days == 0 || rule.days & 0x80) return false;
+    if (rule.from >= 1440 || rule.to >= 1440 || rule.from > rule.to || rule.every == 0) return false;
+
+    code.push_back(OP_DAYS);
+    code.push_back(rule.days);
+    code.push_back(OP_EVERY);
+    code.push_back(rule.from >> 8);
+    code.push_back(rule.from & 0xFF);
+    code.push_back(rule.to >> 8);
+    code.push_back(rule.to & 0xFF);
+    code.push_back(rule.every);
+    for (int8_t delta : rule.plus) {
+        code.push_back(OP_PLUS);
+        code.push_back((uint8_t)delta);
+    }
+    return true;
+}
+
+/**
+ * The function `validateCode` checks that ring code decodes into whole entries with valid minutes.
+ */
+bool CompactSchedule::validateCode(const uint8_t* code, size_t length) {
+    size_t pc = 0;
+    bool afterRule = false; // OP_PLUS is only valid after an OP_EVERY
+    while (pc < length) {
+        if (pc + 2 > length) return false;
+        uint8_t op = code[pc];
+        if (op == OP_DAYS) {
+            if (code[pc + 1] & 0x80) return false;
+            afterRule = false;
+            pc += 2;
+        } else if (op == OP_EVERY) {
+            if (pc + 6 > length) return false;
+            uint16_t from = (code[pc + 1] << 8) | code[pc + 2];
+            uint16_t to = (code[pc + 3] << 8) | code[pc + 4];
+            if (from >= 1440 || to >= 1440 || from > to || code[pc + 5] == 0) return false;
+            afterRule = true;
+            pc += 6;
+        } else if (op == OP_PLUS) {
+            if (!afterRule) return false;
+            pc += 2;
+        } else if (op >= OP_FIRST || ((op << 8) | code[pc + 1]) >= 1440) {
+            return false;
+        } else {
+            afterRule = false;
+            pc += 2;
+        }
+    }
+    return true;
+}
+
+/**
+ * The function `encodeBitmap` writes ring code for a week of ring bitmaps (7 days of DAY_BYTES, Sunday
+ * first). Days with identical bitmaps share a single OP_DAYS entry, like `encodeDays`, but nothing is
+ * collected in RAM, so the code can be written straight to a file however many rings there are.
+ *
+ * @param bitmap The ring bitmaps, bit (minute % 8) of byte (minute / 8) is set for a ring.
+ * @param out Where the ring code is written.
+ */
+void CompactSchedule::encodeBitmap(const uint8_t* bitmap, Print& out) {
+    uint8_t done = 0;
+    for (uint8_t day = 0; day < 7; day++) {
+        const uint8_t* bits = bitmap + day * DAY_BYTES;
+        if (done & (1 << day)) continue;
+
+        bool empty = true;
+        for (uint16_t i = 0; i < DAY_BYTES && empty; i++) {
+            empty = bits[i] == 0;
+        }
+        if (empty) continue;
+
+        // Collect every later day with the same rings
+        uint8_t mask = 1 << day;
+        for (uint8_t other = day + 1; other < 7; other++) {
+            if (memcmp(bits, bitmap + other * DAY_BYTES, DAY_BYTES) == 0) mask |= 1 << other;
+        }
+        done |= mask;
+
+        out.write(OP_DAYS);
+        out.write(mask);
+        for (uint16_t minute = 0; minute < 1440; minute++) {
+            if (bits[minute / 8] & (1 << (minute % 8))) {
+                out.write((uint8_t)(minute >> 8));
+                out.write((uint8_t)(minute & 0xFF));
+            }
+        }
+    }
+}
+
+/**
+ * The function `decodeDay` evaluates ring code for one weekday and sets a bit for every ring in a day
+ * bitmap. Literal times and rules (with their offsets) are expanded, offsets that fall outside the day
+ * are dropped. Code can be fed in pieces of any size: only whole entries are consumed and the state
+ * carries the current weekday mask and rule to the next piece.
+ *
+ * @param code Next piece of ring code.
+ * @param length Length of the piece.
+ * @param weekday Day of the week, 1 = Sunday through 7 = Saturday (same as ezTime's `weekday()`).
+ * @param literalsOnly Skip rules and only set literal ring times (used to show the schedule).
+ * @param state Decoder state, start with a default constructed one.
+ * @param bitmap Ring bitmap of DAY_BYTES bytes to set the rings in.
+ * @param rules If not null, every rule is appended to it whatever its weekdays.
+ *
+ * @return The number of bytes consumed, the rest is an incomplete entry to pass again with more code.
+ */
+size_t CompactSchedule::decodeDay(const uint8_t* code, size_t length, uint8_t weekday, bool literalsOnly, RingCodeState& state,
+                                  uint8_t* bitmap, std::vector<RingRule>* rules) {
+    uint8_t dayBit = 1 << (weekday - 1);
+    size_t pc = 0;
+
+    while (pc + 2 <= length) {
+        uint8_t op = code[pc];
+        if (op == OP_DAYS) {
+            state.mask = code[pc + 1];
+            pc += 2;
+        } else if (op == OP_EVERY) {
+            if (pc + 6 > length) break;
+            state.ruleFrom = (code[pc + 1] << 8) | code[pc + 2];
+            state.ruleTo = (code[pc + 3] << 8) | code[pc + 4];
+            state.ruleEvery = code[pc + 5];
+            pc += 6;
+
+            if (rules) {
+                RingRule rule;
+                rule.days = state.mask;
+                rule.from = state.ruleFrom;
+                rule.to = state.ruleTo;
+                rule.every = state.ruleEvery;
+                rules->push_back(rule);
+            }
+            if (literalsOnly || !(state.mask & dayBit) || state.ruleEvery == 0) continue;
+
+            for (uint16_t minute = state.ruleFrom; minute <= state.ruleTo && minute < 1440; minute += state.ruleEvery) {
+                bitmap[minute / 8] |= 1 << (minute % 8);
+            }
+        } else if (op == OP_PLUS) {
+            int delta = (int8_t)code[pc + 1];
+            pc += 2;
+
+            if (rules && !rules->empty()) {
+                rules->back().plus.push_back(delta);
+            }
+            if (literalsOnly || !(state.mask & dayBit) || state.ruleEvery == 0) continue;
+
+            for (int minute = state.ruleFrom + delta; minute <= state.ruleTo + delta; minute += state.ruleEvery) {
+                if (minute >= 0 && minute < 1440) {
+                    bitmap[minute / 8] |= 1 << (minute % 8);
+                }
+            }
+        } else {
+            uint16_t minute = (op << 8) | code[pc + 1];
+            pc += 2;
+            if ((state.mask & dayBit) && minute < 1440) {
+                bitmap[minute / 8] |= 1 << (minute % 8);
+            }
+        }
+    }
+    return pc;
+}
+
+/**
+ * The function `dayNumber` converts a calendar date to the number of days since 1970-01-01.
+ *
+ * @return The day number, which fits in 16 bits until the year 2149.
+ */
+uint16_t CompactSchedule::dayNumber(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * The function `dayNumberToDate` converts a day number back to a calendar date.
+ */
+void CompactSchedule::dayNumberToDate(uint16_t dayNumber, int& year, int& month, int& day) {
+    long z = (long)dayNumber + 719468;
+    long era = z / 146097;
+    long dayOfEra = z - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+/****************PRIVATE******************/
+
+uint16_t CompactSchedule::readWord(size_t offset) const {
+    return blob[offset] | (blob[offset + 1] << 8);
+}
+
+void CompactSchedule::writeWord(std::vector<uint8_t>& out, size_t offset, uint16_t value) const {
+    out[offset] = value & 0xFF;
+    out[offset + 1] = value >> 8;
+}
+
+size_t CompactSchedule::profileHeader(uint8_t profile) const {
+    return HEADER_SIZE + profile * PROFILE_HEADER_SIZE;
+}
+
+/**
+ * The function `rebuild` lays the given profiles out as a fresh blob.
+ */
+void CompactSchedule::rebuild(const std::vector<String>& names, const std::vector<uint16_t>& starts, const std::vector<uint16_t>& ends,
+                              const std::vector<std::vector<uint8_t>>& codes) {
+    std::vector<uint8_t> out(HEADER_SIZE + names.size() * PROFILE_HEADER_SIZE, 0);
+    out[0] = 'B';
+    out[1] = 'S';
+    out[2] = FORMAT_VERSION;
+    out[3] = names.size();
+
+    for (size_t i = 0; i < names.size(); i++) {
+        size_t header = HEADER_SIZE + i * PROFILE_HEADER_SIZE;
+        memcpy(&out[header], names[i].c_str(), names[i].length());
+        writeWord(out, header + 12, starts[i]);
+        writeWord(out, header + 14, ends[i]);
+        writeWord(out, header + 16, out.size());
+        writeWord(out, header + 18, codes[i].size());
+        out.insert(out.end(), codes[i].begin(), codes[i].end());
+    }
+
+    writeWord(out, 4, out.size());
+    blob.swap(out);
+}
@@ -0,0 +1,105 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the compact binary representation of the ring schedule.
+Several named profiles are stored side by side in one blob, each with an optional active date range,
+so switching profiles never requires re-parsing or rewriting the ring lists. On the device each
+profile's ring code is kept in its own file by ScheduleStoreManager, the blob is only used to read
+schedules saved in EEPROM by older firmware.
+*/
+
+#ifndef CompactSchedule_h
+#define CompactSchedule_h
+
+#include <Arduino.h>
+#include <vector>
+
+/*
+Blob layout (all multi-byte values little endian):
+  [0..1]  'B' 'S' magic
+  [2]     format version
+  [3]     profile count
+  [4..5]  total blob length
+  then one 20 byte header per profile:
+          name[12] (NUL padded), startDay u16, endDay u16, codeOffset u16, codeLength u16
+  then the ring code of every profile
+
+Ring code is a sequence of entries:
+  OP_DAYS mask                  the following entries apply to the weekdays in mask (bit 0 = Sunday)
+  hh ll                         a ring at minute-of-day ((hh << 8) | ll), hh is always below OP_FIRST
+  OP_EVERY fh fl th tl step     a ring every `step` minutes from minute (fh << 8 | fl) up to (th << 8 | tl)
+  OP_PLUS delta                 repeats the preceding OP_EVERY shifted by `delta` minutes (signed),
+                                e.g. a warning bell 5 minutes after every period start
+Rules are only expanded by `decodeDay`, into the ring bitmap of a single day.
+*/
+
+// State of `decodeDay` carried from one piece of ring code to the next
+struct RingCodeState {
+    uint8_t mask = 0x7F; // Weekdays of the entries that follow
+    uint16_t ruleFrom = 0; // Parameters of the last OP_EVERY, used by OP_PLUS
+    uint16_t ruleTo = 0;
+    uint8_t ruleEvery = 0; // 0 until the first OP_EVERY
+};
+
+// A recurring ring rule, e.g. "every 50 min from 08:00 to 15:00 on weekdays, plus 5 min"
+struct RingRule {
+    uint8_t days; // Weekday mask, bit 0 = Sunday
+    uint16_t from; // First ring, minute of the day
+    uint16_t to; // Last possible ring, minute of the day
+    uint8_t every; // Minutes between rings (1 - 255)
+    std::vector<int8_t> plus; // Extra rings relative to each ring of the rule
+};
+
+class CompactSchedule {
+public:
+    static constexpr uint8_t MAX_PROFILES = 8;
+    static constexpr uint8_t MAX_NAME_LENGTH = 11;
+    static constexpr uint16_t MAX_SIZE = 3000; // Size of the schedule area in EEPROM
+    static constexpr uint16_t NO_RING = 0xFFFF;
+    static constexpr uint16_t NO_DATE = 0;
+    static constexpr uint8_t NO_PROFILE = 0xFF;
+    static constexpr uint16_t DAY_BYTES = 1440 / 8; // Ring bitmap of one day, one bit per minute
+
+    CompactSchedule();
+    bool load(const uint8_t* data, size_t length);
+    void clear();
+    const uint8_t* data() const;
+    size_t size() const;
+
+    uint8_t profileCount() const;
+    uint8_t findProfile(const String& name) const;
+    String profileName(uint8_t profile) const;
+    uint16_t profileStartDay(uint8_t profile) const;
+    uint16_t profileEndDay(uint8_t profile) const;
+    void profileCode(uint8_t profile, const uint8_t*& code, size_t& length) const;
+
+    bool setProfile(const String& name, uint16_t startDay, uint16_t endDay, const std::vector<uint8_t>& code);
+
+    static void encodeDays(std::vector<uint16_t> (&days)[7], std::vector<uint8_t>& code);
+    static bool encodeRule(const RingRule& rule, std::vector<uint8_t>& code);
+    static void encodeBitmap(const uint8_t* bitmap, Print& out);
+    static size_t decodeDay(const uint8_t* code, size_t length, uint8_t weekday, bool literalsOnly, RingCodeState& state,
+                            uint8_t* bitmap, std::vector<RingRule>* rules = nullptr);
+    static bool validateCode(const uint8_t* code, size_t length);
+    static uint16_t dayNumber(int year, int month, int day);
+    static void dayNumberToDate(uint16_t dayNumber, int& year, int& month, int& day);
+
+private:
+    static constexpr uint8_t OP_FIRST = 0xF0;
+    static constexpr uint8_t OP_DAYS = 0xF0;
+    static constexpr uint8_t OP_EVERY = 0xF1;
+    static constexpr uint8_t OP_PLUS = 0xF2;
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint8_t HEADER_SIZE = 6;
+    static constexpr uint8_t PROFILE_HEADER_SIZE = 20;
+
+    uint16_t readWord(size_t offset) const;
+    void writeWord(std::vector<uint8_t>& out, size_t offset, uint16_t value) const;
+    size_t profileHeader(uint8_t profile) const;
+    void rebuild(const std::vector<String>& names, const std::vector<uint16_t>& starts, const std::vector<uint16_t>& ends,
+                 const std::vector<std::vector<uint8_t>>& codes);
+
+    std::vector<uint8_t> blob;
+};
+
+#endif
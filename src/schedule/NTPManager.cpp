@@ -0,0 +1,261 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles NTP synchronization. Each poll sends several requests one after another without
+blocking the main loop, keeps the samples with the lowest round trip delay and uses their median offset.
+*/
+
+#include "NTPManager.h"
+#include "TimeManager.h"
+#include "RingGuardManager.h"
+
+// Seconds between 1900-01-01 (NTP era) and 1970-01-01 (Unix epoch)
+static const uint32_t NTP_UNIX_OFFSET = 2208988800UL;
+
+NTPManager::NTPManager() : state(IDLE), samplesSent(0), samplesValid(0), requestSentMillis(0), requestSentAt(0), nextPollAt(0),
+                           synchronized(false), paused(false), lastOffset(0), lastDelay(0), lastSyncAt(0), syncCount(0) {}
+
+/**
+ * The `begin` function loads the NTP server from EEPROM and schedules the first poll right away.
+ */
+void NTPManager::begin() {
+    serverName = eepromManager.loadNtpServer();
+    udp.begin(0); // Any free local port
+    state = IDLE;
+    nextPollAt = millis();
+}
+
+/**
+ * The `update` function drives the polling state machine. It never waits for the network, each call
+ * either sends one request, reads one reply, or returns immediately.
+ */
+void NTPManager::update() {
+    if (state == IDLE) {
+        if (paused || (long)(millis() - nextPollAt) < 0 || WiFi.status() != WL_CONNECTED) {
+            return;
+        }
+
+        // Start a new poll
+        if (!WiFi.hostByName(serverName.c_str(), serverIP)) {
+            nextPollAt = millis() + RETRY_INTERVAL;
+            return;
+        }
+        samplesSent = 0;
+        samplesValid = 0;
+        sendRequest();
+        return;
+    }
+
+    if (readResponse() || millis() - requestSentAt >= SAMPLE_TIMEOUT) {
+        if (samplesSent < SAMPLE_COUNT) {
+            sendRequest();
+        } else {
+            finishPoll();
+        }
+    }
+}
+
+/**
+ * The function `setServer` changes and saves the NTP server and starts a new poll against it.
+ *
+ * @param server Host name or IP address of the NTP server, e.g. a LAN-local server without internet access.
+ *
+ * @return `false` if the name is empty or too long, or could not be saved.
+ */
+bool NTPManager::setServer(const String& server) {
+    if (!isValidServer(server)) {
+        return false;
+    }
+
+    serverName = server;
+    state = IDLE;
+    nextPollAt = millis();
+    return eepromManager.saveNtpServer(serverName);
+}
+
+/**
+ * The function `isValidServer` checks an NTP server name without applying it.
+ *
+ * @return `false` if the name is empty or too long to be saved.
+ */
+bool NTPManager::isValidServer(const String& server) {
+    return server.length() > 0 && server.length() <= 59;
+}
+
+/**
+ * The function `setPaused` stops or resumes polling. While a LAN sync leader disciplines the clock, NTP
+ * corrections would pull it away from the other units in the building.
+ *
+ * @param pause `true` to stop polling, `false` to poll again right away.
+ */
+void NTPManager::setPaused(bool pause) {
+    if (paused && !pause) {
+        nextPollAt = millis();
+    }
+    paused = pause;
+}
+
+String NTPManager::getServer() {
+    return serverName;
+}
+
+bool NTPManager::isSynchronized() {
+    return synchronized;
+}
+
+/**
+ * The function `isPolling` tells if a request was sent and its reply is awaited. The reply has to be
+ * read right away, its timestamps are only as good as the time it is read.
+ */
+bool NTPManager::isPolling() {
+    return state == WAITING;
+}
+
+int64_t NTPManager::getLastOffsetMillis() {
+    return lastOffset;
+}
+
+uint32_t NTPManager::getLastDelayMillis() {
+    return lastDelay;
+}
+
+unsigned long NTPManager::getLastSyncMillis() {
+    return lastSyncAt;
+}
+
+uint32_t NTPManager::getSyncCount() {
+    return syncCount;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `sendRequest` sends one NTP client request. The transmit timestamp is remembered so the
+ * reply can be matched to it.
+ */
+void NTPManager::sendRequest() {
+    uint8_t packet[48] = {0};
+    packet[0] = 0x23; // LI = 0, version 4, mode 3 (client)
+
+    requestSentMillis = timeManager.getEpochMillis();
+    millisToNtp(requestSentMillis, requestTimestamp);
+    memcpy(packet + 40, requestTimestamp, 8);
+
+    // Drop stale replies from earlier requests
+    while (udp.parsePacket() > 0) {}
+
+    udp.beginPacket(serverIP, NTP_PORT);
+    udp.write(packet, sizeof(packet));
+    udp.endPacket();
+
+    requestSentAt = millis();
+    samplesSent++;
+    state = WAITING;
+}
+
+/**
+ * The function `readResponse` reads a reply to the request in flight, if one arrived, and stores the
+ * offset and round trip delay as a sample.
+ *
+ * @return `true` if a valid reply was read.
+ */
+bool NTPManager::readResponse() {
+    if (udp.parsePacket() < 48) {
+        return false;
+    }
+
+    int64_t receivedMillis = timeManager.getEpochMillis();
+    uint8_t packet[48];
+    udp.read(packet, sizeof(packet));
+
+    // The reply must answer our request and come from a synchronized server
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    if (mode != 4 || stratum == 0 || stratum > 15 || memcmp(packet + 24, requestTimestamp, 8) != 0) {
+        return false;
+    }
+
+    int64_t serverReceive = ntpToMillis(packet + 32);
+    int64_t serverTransmit = ntpToMillis(packet + 40);
+    int64_t offset = ((serverReceive - requestSentMillis) + (serverTransmit - receivedMillis)) / 2;
+    int64_t delay = (receivedMillis - requestSentMillis) - (serverTransmit - serverReceive);
+
+    sampleOffsets[samplesValid] = offset;
+    sampleDelays[samplesValid] = delay < 0 ? 0 : delay;
+    samplesValid++;
+    return true;
+}
+
+/**
+ * The function `finishPoll` filters the samples of a poll and corrects the clock. The samples with the
+ * lowest round trip delay are the least affected by queuing, so only those are kept and their median
+ * offset is used. The first sync steps the clock, later ones are slewed and also update the drift
+ * estimate. Slewing 30 s takes 100 minutes, so an offset above STEP_THRESHOLD after the first sync (a
+ * wrong server, or a clock that ran from a stale checkpoint) is stepped instead. Such a step is put off
+ * while a ring is close. A step forward over a ring minute still rings it, `ScheduleManager::handleRing`
+ * catches up on the minutes it jumped over, and a step back never rings a minute twice.
+ */
+void NTPManager::finishPoll() {
+    state = IDLE;
+
+    if (samplesValid < MIN_SAMPLES) {
+        nextPollAt = millis() + (synchronized ? POLL_INTERVAL / 4 : RETRY_INTERVAL);
+        return;
+    }
+
+    // Sort the samples by delay (insertion sort, there are only a few)
+    for (uint8_t i = 1; i < samplesValid; i++) {
+        for (uint8_t j = i; j > 0 && sampleDelays[j] < sampleDelays[j - 1]; j--) {
+            std::swap(sampleDelays[j], sampleDelays[j - 1]);
+            std::swap(sampleOffsets[j], sampleOffsets[j - 1]);
+        }
+    }
+
+    // Median offset of the MIN_SAMPLES fastest samples
+    int64_t best[MIN_SAMPLES];
+    memcpy(best, sampleOffsets, sizeof(best));
+    std::sort(best, best + MIN_SAMPLES);
+    lastOffset = best[MIN_SAMPLES / 2];
+    lastDelay = sampleDelays[0];
+
+    bool step = !synchronized || lastOffset > STEP_THRESHOLD || lastOffset < -STEP_THRESHOLD;
+    if (step && synchronized && ringGuardManager.isOpen()) {
+        nextPollAt = millis() + ringGuardManager.getRetryAfter() * 1000;
+        return;
+    }
+
+    if (step) {
+        timeManager.stepClock(lastOffset);
+        if (!synchronized) {
+            eepromManager.addSystemMessage("Time synchronized successfully.");
+        }
+    } else {
+        timeManager.slewClock(lastOffset, millis() - lastSyncAt);
+    }
+
+    synchronized = true;
+    lastSyncAt = millis();
+    syncCount++;
+    nextPollAt = lastSyncAt + POLL_INTERVAL;
+}
+
+/**
+ * The function `ntpToMillis` converts a 64 bit NTP timestamp to milliseconds since the Unix epoch.
+ */
+int64_t NTPManager::ntpToMillis(const uint8_t* timestamp) {
+    uint32_t seconds = ((uint32_t)timestamp[0] << 24) | ((uint32_t)timestamp[1] << 16) | ((uint32_t)timestamp[2] << 8) | timestamp[3];
+    uint32_t fraction = ((uint32_t)timestamp[4] << 24) | ((uint32_t)timestamp[5] << 16) | ((uint32_t)timestamp[6] << 8) | timestamp[7];
+    return ((int64_t)seconds - NTP_UNIX_OFFSET) * 1000 + (((uint64_t)fraction * 1000) >> 32);
+}
+
+/**
+ * The function `millisToNtp` converts milliseconds since the Unix epoch to a 64 bit NTP timestamp.
+ */
+void NTPManager::millisToNtp(int64_t epochMillis, uint8_t* timestamp) {
+    uint32_t seconds = epochMillis / 1000 + NTP_UNIX_OFFSET;
+    uint32_t fraction = ((uint64_t)(epochMillis % 1000) << 32) / 1000;
+    for (int i = 0; i < 4; i++) {
+        timestamp[i] = seconds >> (24 - i * 8);
+        timestamp[4 + i] = fraction >> (24 - i * 8);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles NTP synchronization. Several samples are taken per poll and filtered, the local
+oscillator drift is estimated from successive polls, and small corrections are slewed instead of stepped.
+*/
+
+#ifndef NTPManager_h
+#define NTPManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#include "board/EEPROMLayoutManager.h"
+
+class TimeManager;
+
+extern EEPROMLayoutManager eepromManager;
+extern TimeManager timeManager;
+
+class NTPManager {
+public:
+    NTPManager();
+    void begin();
+    void update();
+    bool setServer(const String& server);
+    static bool isValidServer(const String& server);
+    void setPaused(bool paused);
+    String getServer();
+    bool isSynchronized();
+    bool isPolling();
+    int64_t getLastOffsetMillis();
+    uint32_t getLastDelayMillis();
+    unsigned long getLastSyncMillis();
+    uint32_t getSyncCount();
+private:
+    static constexpr uint8_t SAMPLE_COUNT = 5; // Samples per poll
+    static constexpr uint8_t MIN_SAMPLES = 3; // Valid samples needed to accept a poll
+    static constexpr uint32_t SAMPLE_TIMEOUT = 1000; // Time to wait for each reply (ms)
+    static constexpr uint32_t POLL_INTERVAL = 900000; // Time between polls (15 minutes)
+    static constexpr uint32_t RETRY_INTERVAL = 30000; // Time between polls until the first sync (ms)
+    static constexpr int32_t STEP_THRESHOLD = 30000; // After the first sync only offsets larger than this are stepped (ms)
+    static constexpr uint16_t NTP_PORT = 123;
+
+    enum State { IDLE, WAITING };
+
+    void sendRequest();
+    bool readResponse();
+    void finishPoll();
+    static int64_t ntpToMillis(const uint8_t* timestamp);
+    static void millisToNtp(int64_t epochMillis, uint8_t* timestamp);
+
+    WiFiUDP udp;
+    String serverName; // Host name or IP of the NTP server, saved in EEPROM
+    IPAddress serverIP; // Resolved once per poll
+    State state;
+    uint8_t samplesSent;
+    uint8_t samplesValid;
+    int64_t sampleOffsets[SAMPLE_COUNT]; // Server time - local time (ms)
+    uint32_t sampleDelays[SAMPLE_COUNT]; // Round trip delay (ms)
+    uint8_t requestTimestamp[8]; // Transmit timestamp of the request in flight
+    int64_t requestSentMillis; // Local clock when the request was sent
+    unsigned long requestSentAt; // millis() when the request was sent
+    unsigned long nextPollAt; // millis() when the next poll starts
+    bool synchronized;
+    bool paused; // Another time source (the LAN sync leader) disciplines the clock
+    int64_t lastOffset;
+    uint32_t lastDelay;
+    unsigned long lastSyncAt;
+    uint32_t syncCount;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the ring guard window and the operations put off until it closes.
+*/
+
+#include "RingGuardManager.h"
+
+#include "scheduleManager.h"
+#include "TimeManager.h"
+
+extern ScheduleManager scheduleManager;
+extern TimeManager timeManager;
+extern int ringDuration;
+
+RingGuardManager::RingGuardManager() : pendingCount(0), rejectedCount(0), deferredCount(0), checkedAt(0), checkedVersion(0),
+                                       retryAfter(0) {}
+
+/**
+ * The function `isOpen` tells if a ring is close, from `GUARD_BEFORE` seconds before it until
+ * `GUARD_AFTER` seconds after the bell stopped. The window never opens while the clock is not set.
+ */
+bool RingGuardManager::isOpen() {
+    return getRetryAfter() > 0;
+}
+
+/**
+ * The function `getRetryAfter` returns the time until the window closes, sent with a 503 response in
+ * the Retry-After header. It is asked on every pass of the main loop, so the answer is kept for the rest
+ * of the second unless the schedule changes.
+ *
+ * @return Seconds until the window closes, 0 if it is not open.
+ */
+uint32_t RingGuardManager::getRetryAfter() {
+    time_t now = timeManager.getEpoch();
+    if (now == checkedAt && scheduleManager.getVersion() == checkedVersion) {
+        return retryAfter;
+    }
+    checkedAt = now;
+    checkedVersion = scheduleManager.getVersion();
+    retryAfter = windowLeft();
+    return retryAfter;
+}
+
+/**
+ * The function `windowLeft` works out the time until the window closes from the schedule.
+ */
+uint32_t RingGuardManager::windowLeft() {
+    uint32_t after = min<uint32_t>(max(ringDuration, 0) + GUARD_AFTER, 59); // The check only sees the current minute's ring
+
+    uint32_t sinceRing = scheduleManager.getSecondsSinceRing();
+    if (sinceRing != ScheduleManager::NO_RING_SECONDS && sinceRing < after) {
+        return after - sinceRing;
+    }
+
+    uint32_t toRing = scheduleManager.getSecondsToNextRing();
+    if (toRing != ScheduleManager::NO_RING_SECONDS && toRing <= GUARD_BEFORE) {
+        return toRing + after;
+    }
+    return 0;
+}
+
+/**
+ * The function `defer` puts an operation off until the window closes, if it is open. An operation that
+ * is already waiting is not added again, e.g. several settings saved in a row are committed once.
+ *
+ * @param operation The operation, it is called from `update`.
+ *
+ * @return `true` if the operation was put off, `false` if the window is closed or the queue is full and
+ * the caller has to do it now.
+ */
+bool RingGuardManager::defer(DeferredOperation operation) {
+    if (!isOpen()) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < pendingCount; i++) {
+        if (pending[i] == operation) {
+            return true;
+        }
+    }
+    if (pendingCount >= MAX_DEFERRED) {
+        return false;
+    }
+
+    pending[pendingCount++] = operation;
+    deferredCount++;
+    return true;
+}
+
+/**
+ * The `update` function runs the operations put off, right after the window closed.
+ */
+void RingGuardManager::update() {
+    if (pendingCount == 0 || isOpen()) {
+        return;
+    }
+
+    // An operation may put off another one, it waits for the next call
+    DeferredOperation running[MAX_DEFERRED];
+    uint8_t count = pendingCount;
+    memcpy(running, pending, sizeof(running[0]) * count);
+    pendingCount = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        running[i]();
+    }
+}
+
+/**
+ * The function `countRejected` counts a request answered with 503 because the window was open.
+ */
+void RingGuardManager::countRejected() {
+    rejectedCount++;
+}
+
+uint32_t RingGuardManager::getRejectedCount() {
+    return rejectedCount;
+}
+
+uint32_t RingGuardManager::getDeferredCount() {
+    return deferredCount;
+}
+
+uint8_t RingGuardManager::getPendingCount() {
+    return pendingCount;
+}
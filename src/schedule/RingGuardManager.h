@@ -0,0 +1,47 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the ring guard window. For a few seconds before each scheduled ring until shortly
+after the bell stops, work that can block the CPU (flash erases, password hashing, TLS handshakes, large
+responses, restarts) is put off, so admin activity never makes a bell late.
+*/
+
+#ifndef RingGuardManager_h
+#define RingGuardManager_h
+
+#include <Arduino.h>
+
+class RingGuardManager {
+public:
+    static constexpr uint32_t GUARD_BEFORE = 5; // The window opens this long before a ring (s)
+    static constexpr uint32_t GUARD_AFTER = 2; // The window closes this long after the bell stops (s)
+    static constexpr uint8_t MAX_DEFERRED = 8;
+
+    // An operation put off until the window closes, e.g. an EEPROM commit
+    typedef void (*DeferredOperation)();
+
+    RingGuardManager();
+    bool isOpen();
+    uint32_t getRetryAfter();
+    bool defer(DeferredOperation operation);
+    void update();
+    void countRejected();
+    uint32_t getRejectedCount();
+    uint32_t getDeferredCount();
+    uint8_t getPendingCount();
+
+private:
+    uint32_t windowLeft();
+
+    DeferredOperation pending[MAX_DEFERRED]; // Each operation at most once, in the order it was put off
+    uint8_t pendingCount;
+    uint32_t rejectedCount; // Requests answered with 503 during the window
+    uint32_t deferredCount; // Operations put off
+    time_t checkedAt; // Epoch second of the last check
+    uint32_t checkedVersion; // Schedule version of the last check
+    uint32_t retryAfter; // Result of the last check
+};
+
+extern RingGuardManager ringGuardManager;
+
+#endif
@@ -0,0 +1,631 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the schedule store on LittleFS. Only the profile index is kept in RAM, ring code is
+streamed from the profile files in small pieces when a day's rings are needed.
+*/
+
+#include "ScheduleStoreManager.h"
+#include <coredecls.h>
+
+static const char* INDEX_PATH = "/schedule/index.bin";
+static const char* INDEX_TEMP_PATH = "/schedule/index.tmp";
+
+/*
+A Print that hashes and counts ring code, and writes it to a file in small blocks if one is given.
+Without a file it is used to find out if a profile changed before anything is written to flash.
+*/
+class CodeOutput : public Print {
+public:
+    CodeOutput(File* file) : file(file), length(0), hash(2166136261UL), buffered(0), failed(false) {}
+
+    size_t write(uint8_t c) override {
+        hash = (hash ^ c) * 16777619UL;
+        length++;
+        if (file) {
+            buffer[buffered++] = c;
+            if (buffered == sizeof(buffer)) {
+                flush();
+            }
+        }
+        return 1;
+    }
+
+    void flush() override {
+        if (file && buffered > 0) {
+            failed |= file->write(buffer, buffered) != buffered;
+            buffered = 0;
+        }
+    }
+
+    File* file;
+    uint32_t length;
+    uint32_t hash;
+    uint8_t buffer[128];
+    size_t buffered;
+    bool failed;
+};
+
+ScheduleStoreManager::ScheduleStoreManager() : indexHash(0) {
+    updateHash();
+}
+
+/**
+ * The function `begin` reads the index from LittleFS and removes code files left behind by a save that
+ * was interrupted. LittleFS must be mounted.
+ *
+ * @return `false` if there is no valid index, e.g. on the first boot after the schedule moved from
+ * EEPROM. The store is empty in that case.
+ */
+bool ScheduleStoreManager::begin() {
+    bool found = readIndex();
+    removeOrphans();
+    updateHash();
+    return found;
+}
+
+/**
+ * The function `hash` returns a 32 bit FNV-1a hash over the names, date ranges and ring code hashes of
+ * all profiles. Two devices with the same hash run the same schedule.
+ */
+uint32_t ScheduleStoreManager::hash() const {
+    return indexHash;
+}
+
+/**
+ * The function `profileHash` returns the FNV-1a hash of one profile's name, date range and ring code.
+ * It only changes when that profile changes.
+ *
+ * @param profile Index of the profile.
+ *
+ * @return The hash, or the FNV-1a offset basis if there is no such profile.
+ */
+uint32_t ScheduleStoreManager::profileHash(uint8_t profile) const {
+    uint32_t result = 2166136261UL;
+    if (profile >= index.size()) {
+        return result;
+    }
+
+    auto add = [&result](uint32_t value, uint8_t bytes) {
+        for (uint8_t i = 0; i < bytes; i++) {
+            result = (result ^ ((value >> (i * 8)) & 0xFF)) * 16777619UL;
+        }
+    };
+    const StoredProfile& entry = index[profile];
+    for (uint8_t i = 0; i <= CompactSchedule::MAX_NAME_LENGTH; i++) {
+        add((uint8_t)entry.name[i], 1);
+    }
+    add(entry.startDay, 2);
+    add(entry.endDay, 2);
+    add(entry.codeHash, 4);
+    return result;
+}
+
+uint8_t ScheduleStoreManager::profileCount() const {
+    return index.size();
+}
+
+/**
+ * The function `findProfile` looks up a profile by name.
+ *
+ * @param name Name of the profile to look for.
+ *
+ * @return The index of the profile, or `CompactSchedule::NO_PROFILE` if there is no profile with that name.
+ */
+uint8_t ScheduleStoreManager::findProfile(const String& name) const {
+    for (uint8_t i = 0; i < index.size(); i++) {
+        if (name == index[i].name) return i;
+    }
+    return CompactSchedule::NO_PROFILE;
+}
+
+String ScheduleStoreManager::profileName(uint8_t profile) const {
+    return profile < index.size() ? String(index[profile].name) : String();
+}
+
+uint16_t ScheduleStoreManager::profileStartDay(uint8_t profile) const {
+    return profile < index.size() ? index[profile].startDay : CompactSchedule::NO_DATE;
+}
+
+uint16_t ScheduleStoreManager::profileEndDay(uint8_t profile) const {
+    return profile < index.size() ? index[profile].endDay : CompactSchedule::NO_DATE;
+}
+
+/**
+ * The function `resolveProfile` picks the profile that should be active on a given day. A profile
+ * whose date range contains the day wins over one without a date range, and when several date ranges
+ * match the narrowest one wins (e.g. exam week inside a semester). Without any match the first
+ * profile without a date range is used.
+ *
+ * @param today Day number (days since 1970-01-01) in local time.
+ *
+ * @return The index of the profile to use, or `CompactSchedule::NO_PROFILE` if there are no profiles.
+ */
+uint8_t ScheduleStoreManager::resolveProfile(uint16_t today) const {
+    uint8_t fallback = CompactSchedule::NO_PROFILE;
+    uint8_t best = CompactSchedule::NO_PROFILE;
+    uint16_t bestSpan = 0xFFFF;
+
+    for (uint8_t i = 0; i < index.size(); i++) {
+        uint16_t start = index[i].startDay;
+        uint16_t end = index[i].endDay;
+
+        if (start == CompactSchedule::NO_DATE && end == CompactSchedule::NO_DATE) {
+            if (fallback == CompactSchedule::NO_PROFILE) fallback = i;
+            continue;
+        }
+
+        if ((start != CompactSchedule::NO_DATE && today < start) || (end != CompactSchedule::NO_DATE && today > end)) continue;
+
+        uint16_t span = (end == CompactSchedule::NO_DATE ? 0xFFFF : end) - (start == CompactSchedule::NO_DATE ? 0 : start);
+        if (best == CompactSchedule::NO_PROFILE || span < bestSpan) {
+            best = i;
+            bestSpan = span;
+        }
+    }
+
+    if (best != CompactSchedule::NO_PROFILE) return best;
+    if (fallback != CompactSchedule::NO_PROFILE) return fallback;
+    return index.empty() ? CompactSchedule::NO_PROFILE : 0;
+}
+
+/**
+ * The function `setProfile` adds a profile, or replaces the profile with the same name in place so the
+ * indexes of the other profiles are unchanged.
+ *
+ * @param name Name of the profile (1 to MAX_NAME_LENGTH characters).
+ * @param startDay First day the profile is active, or `CompactSchedule::NO_DATE`.
+ * @param endDay Last day the profile is active, or `CompactSchedule::NO_DATE`.
+ * @param code Ring code of the profile, usually produced by `CompactSchedule::encodeDays`.
+ *
+ * @return `false` if the name or code is invalid, the profile table is full or the profile could not be
+ * written. The store is unchanged in that case.
+ */
+bool ScheduleStoreManager::setProfile(const String& name, uint16_t startDay, uint16_t endDay, const std::vector<uint8_t>& code) {
+    if (!CompactSchedule::validateCode(code.data(), code.size())) {
+        return false;
+    }
+    return setProfile(name, startDay, endDay, [&code](Print& out) { out.write(code.data(), code.size()); });
+}
+
+/**
+ * The function `setProfile` adds or replaces a profile whose ring code is produced by a writer, so
+ * code of any size can go straight to flash. The writer is first run without a file to hash the code:
+ * a profile that did not change is not written again, and a changed date range alone only rewrites
+ * the index.
+ *
+ * @param name Name of the profile (1 to MAX_NAME_LENGTH characters).
+ * @param startDay First day the profile is active, or `CompactSchedule::NO_DATE`.
+ * @param endDay Last day the profile is active, or `CompactSchedule::NO_DATE`.
+ * @param writer Writes the ring code, it must produce valid code.
+ *
+ * @return `false` if the name is invalid, the profile table is full or the profile could not be written.
+ */
+bool ScheduleStoreManager::setProfile(const String& name, uint16_t startDay, uint16_t endDay, const CodeWriter& writer) {
+    if (name.length() == 0 || name.length() > CompactSchedule::MAX_NAME_LENGTH) {
+        return false;
+    }
+
+    uint8_t existing = findProfile(name);
+    if (existing == CompactSchedule::NO_PROFILE && index.size() >= MAX_PROFILES) {
+        return false;
+    }
+
+    CodeOutput dryRun(nullptr);
+    writer(dryRun);
+
+    StoredProfile entry = {};
+    strncpy(entry.name, name.c_str(), CompactSchedule::MAX_NAME_LENGTH);
+    entry.startDay = startDay;
+    entry.endDay = endDay;
+
+    bool sameCode = existing != CompactSchedule::NO_PROFILE && index[existing].codeLength == dryRun.length &&
+                    index[existing].codeHash == dryRun.hash;
+    if (sameCode) {
+        if (index[existing].startDay == startDay && index[existing].endDay == endDay) {
+            return true; // Nothing changed, nothing is written
+        }
+        entry.codeLength = dryRun.length;
+        entry.codeHash = dryRun.hash;
+        entry.file = index[existing].file;
+    } else if (!writeCode(writer, entry, freeFile(index))) {
+        return false;
+    }
+
+    std::vector<StoredProfile> newIndex = index;
+    uint8_t oldFile = existing == CompactSchedule::NO_PROFILE ? 0 : index[existing].file;
+    if (existing == CompactSchedule::NO_PROFILE) {
+        newIndex.push_back(entry);
+    } else {
+        newIndex[existing] = entry;
+    }
+
+    if (!writeIndex(newIndex)) {
+        if (!sameCode) LittleFS.remove(codePath(entry.file));
+        return false;
+    }
+    if (existing != CompactSchedule::NO_PROFILE && !sameCode) {
+        LittleFS.remove(codePath(oldFile));
+    }
+    return true;
+}
+
+/**
+ * The function `replaceProfiles` replaces every profile with the profiles of a compact schedule, as
+ * kept in EEPROM by older firmware.
+ *
+ * @param schedule The new profiles.
+ *
+ * @return `false` if a profile could not be written. The store is unchanged in that case.
+ */
+bool ScheduleStoreManager::replaceProfiles(const CompactSchedule& schedule) {
+    std::vector<NewProfile> profiles;
+    for (uint8_t i = 0; i < schedule.profileCount(); i++) {
+        const uint8_t* code;
+        size_t length;
+        schedule.profileCode(i, code, length);
+        profiles.push_back({schedule.profileName(i), schedule.profileStartDay(i), schedule.profileEndDay(i),
+                            [code, length](Print& out) { out.write(code, length); }});
+    }
+    return replaceProfiles(profiles);
+}
+
+/**
+ * The function `replaceProfiles` replaces every profile at once. Each profile's code goes from its
+ * writer straight to its file, so only one profile is handled at a time and the total size is only
+ * limited by flash. Profiles whose ring code did not change keep their files, only new or changed code
+ * is written. The new index replaces the old one in a single write.
+ *
+ * @param profiles The new profiles, at most MAX_PROFILES with distinct names.
+ *
+ * @return `false` if a name is invalid or repeated, there are too many profiles or a profile could not
+ * be written. The store is unchanged in that case.
+ */
+bool ScheduleStoreManager::replaceProfiles(const std::vector<NewProfile>& profiles) {
+    if (profiles.size() > MAX_PROFILES) {
+        return false;
+    }
+
+    std::vector<StoredProfile> newIndex;
+    std::vector<uint8_t> written;
+
+    for (const NewProfile& profile : profiles) {
+        bool repeated = false;
+        for (const StoredProfile& entry : newIndex) {
+            repeated |= profile.name == entry.name;
+        }
+        if (profile.name.length() == 0 || profile.name.length() > CompactSchedule::MAX_NAME_LENGTH || repeated) {
+            for (uint8_t file : written) LittleFS.remove(codePath(file));
+            return false;
+        }
+
+        CodeOutput dryRun(nullptr);
+        profile.writer(dryRun);
+
+        StoredProfile entry = {};
+        strncpy(entry.name, profile.name.c_str(), CompactSchedule::MAX_NAME_LENGTH);
+        entry.startDay = profile.startDay;
+        entry.endDay = profile.endDay;
+
+        uint8_t existing = findProfile(profile.name);
+        if (existing != CompactSchedule::NO_PROFILE && index[existing].codeLength == dryRun.length && index[existing].codeHash == dryRun.hash) {
+            entry.codeLength = dryRun.length;
+            entry.codeHash = dryRun.hash;
+            entry.file = index[existing].file;
+        } else if (writeCode(profile.writer, entry, freeFile(newIndex))) {
+            written.push_back(entry.file);
+        } else {
+            for (uint8_t file : written) LittleFS.remove(codePath(file));
+            return false;
+        }
+        newIndex.push_back(entry);
+    }
+
+    std::vector<StoredProfile> oldIndex = index;
+    if (!writeIndex(newIndex)) {
+        for (uint8_t file : written) LittleFS.remove(codePath(file));
+        return false;
+    }
+
+    // Remove the files no profile refers to any more
+    for (const StoredProfile& old : oldIndex) {
+        bool used = false;
+        for (const StoredProfile& entry : newIndex) {
+            used |= entry.file == old.file;
+        }
+        if (!used) LittleFS.remove(codePath(old.file));
+    }
+    return true;
+}
+
+/**
+ * The function `removeProfile` deletes a profile. Profiles after it move down one index.
+ *
+ * @param profile Index of the profile to remove.
+ *
+ * @return `false` if the index is out of range or the index file could not be written.
+ */
+bool ScheduleStoreManager::removeProfile(uint8_t profile) {
+    if (profile >= index.size()) {
+        return false;
+    }
+
+    uint8_t file = index[profile].file;
+    std::vector<StoredProfile> newIndex = index;
+    newIndex.erase(newIndex.begin() + profile);
+    if (!writeIndex(newIndex)) {
+        return false;
+    }
+    LittleFS.remove(codePath(file));
+    return true;
+}
+
+/**
+ * The function `loadDay` reads a profile's ring code from flash and expands the rings of one weekday
+ * into a bitmap. The file is read in small pieces, so memory use does not depend on its size.
+ *
+ * @param profile Index of the profile.
+ * @param weekday Day of the week, 1 = Sunday through 7 = Saturday.
+ * @param bitmap Ring bitmap of `CompactSchedule::DAY_BYTES` bytes, cleared first.
+ * @param literalsOnly Skip rules and only set literal ring times (used to show the schedule).
+ *
+ * @return `false` if the profile does not exist or its file could not be read, the bitmap is then empty.
+ */
+bool ScheduleStoreManager::loadDay(uint8_t profile, uint8_t weekday, uint8_t* bitmap, bool literalsOnly) {
+    memset(bitmap, 0, CompactSchedule::DAY_BYTES);
+    return decodeFile(profile, weekday, literalsOnly, bitmap, nullptr);
+}
+
+/**
+ * The function `getRules` reads the recurring rules of a profile, so they can be shown and edited.
+ *
+ * @param profile Index of the profile.
+ * @param rules Output list, the rules are appended in the order they are stored.
+ *
+ * @return `false` if the profile does not exist or its file could not be read.
+ */
+bool ScheduleStoreManager::getRules(uint8_t profile, std::vector<RingRule>& rules) {
+    uint8_t bitmap[CompactSchedule::DAY_BYTES];
+    return decodeFile(profile, 1, true, bitmap, &rules);
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `serializeIndex` lays out index entries as stored in the index file, including the
+ * header and checksum.
+ */
+void ScheduleStoreManager::serializeIndex(const std::vector<StoredProfile>& entries, std::vector<uint8_t>& out) {
+    out.clear();
+    out.push_back('B');
+    out.push_back('X');
+    out.push_back(FORMAT_VERSION);
+    out.push_back(entries.size());
+
+    for (const StoredProfile& entry : entries) {
+        out.insert(out.end(), (const uint8_t*)entry.name, (const uint8_t*)entry.name + CompactSchedule::MAX_NAME_LENGTH + 1);
+        out.push_back(entry.startDay & 0xFF);
+        out.push_back(entry.startDay >> 8);
+        out.push_back(entry.endDay & 0xFF);
+        out.push_back(entry.endDay >> 8);
+        for (int i = 0; i < 4; i++) out.push_back(entry.codeLength >> (i * 8));
+        for (int i = 0; i < 4; i++) out.push_back(entry.codeHash >> (i * 8));
+        out.push_back(entry.file);
+    }
+
+    uint32_t crc = crc32(out.data(), out.size());
+    for (int i = 0; i < 4; i++) out.push_back(crc >> (i * 8));
+}
+
+/**
+ * The function `readIndex` loads and checks the index file. A profile whose code file is missing or
+ * has the wrong size is dropped, the others are kept.
+ *
+ * @return `false` if there is no index file or it is damaged, the index is then empty.
+ */
+bool ScheduleStoreManager::readIndex() {
+    index.clear();
+
+    File file = LittleFS.open(INDEX_PATH, "r");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> bytes(file.size());
+    size_t length = file.read(bytes.data(), bytes.size());
+    file.close();
+
+    if (length != bytes.size() || length < HEADER_SIZE + 4 || bytes[0] != 'B' || bytes[1] != 'X' || bytes[2] != FORMAT_VERSION) {
+        return false;
+    }
+    uint8_t count = bytes[3];
+    if (count > MAX_PROFILES || length != (size_t)(HEADER_SIZE + count * ENTRY_SIZE + 4)) {
+        return false;
+    }
+    uint32_t crc = bytes[length - 4] | (bytes[length - 3] << 8) | (bytes[length - 2] << 16) | ((uint32_t)bytes[length - 1] << 24);
+    if (crc != crc32(bytes.data(), length - 4)) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t* data = bytes.data() + HEADER_SIZE + i * ENTRY_SIZE;
+        StoredProfile entry;
+        memcpy(entry.name, data, sizeof(entry.name));
+        entry.name[CompactSchedule::MAX_NAME_LENGTH] = '\0';
+        entry.startDay = data[12] | (data[13] << 8);
+        entry.endDay = data[14] | (data[15] << 8);
+        entry.codeLength = data[16] | (data[17] << 8) | (data[18] << 16) | ((uint32_t)data[19] << 24);
+        entry.codeHash = data[20] | (data[21] << 8) | (data[22] << 16) | ((uint32_t)data[23] << 24);
+        entry.file = data[24];
+
+        File code = LittleFS.open(codePath(entry.file), "r");
+        if (!code || code.size() != entry.codeLength) {
+            char message[64];
+            snprintf(message, sizeof(message), "Schedule profile %s is damaged and was removed.", entry.name);
+            eepromManager.addSystemMessage(message);
+            continue;
+        }
+        code.close();
+        index.push_back(entry);
+    }
+    return true;
+}
+
+/**
+ * The function `writeIndex` replaces the index file. It is written to a temporary file first and then
+ * renamed over the old one, so the index on flash is always complete.
+ *
+ * @param newIndex The new profile entries.
+ *
+ * @return `false` if the file could not be written, the index is then unchanged.
+ */
+bool ScheduleStoreManager::writeIndex(const std::vector<StoredProfile>& newIndex) {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> current;
+    serializeIndex(newIndex, bytes);
+    serializeIndex(index, current);
+    if (bytes == current && LittleFS.exists(INDEX_PATH)) {
+        return true;
+    }
+
+    File file = LittleFS.open(INDEX_TEMP_PATH, "w");
+    if (!file) {
+        return false;
+    }
+    size_t written = file.write(bytes.data(), bytes.size());
+    file.close();
+
+    if (written != bytes.size() || !LittleFS.rename(INDEX_TEMP_PATH, INDEX_PATH)) {
+        LittleFS.remove(INDEX_TEMP_PATH);
+        return false;
+    }
+
+    index = newIndex;
+    updateHash();
+    return true;
+}
+
+/**
+ * The function `writeCode` writes a profile's ring code to a new code file.
+ *
+ * @param writer Writes the ring code.
+ * @param entry Index entry, its length, hash and file number are filled in.
+ * @param file Number of a code file that is not in use.
+ *
+ * @return `false` if the file could not be written completely, it is removed again in that case.
+ */
+bool ScheduleStoreManager::writeCode(const CodeWriter& writer, StoredProfile& entry, uint8_t file) {
+    File code = LittleFS.open(codePath(file), "w");
+    if (!code) {
+        return false;
+    }
+
+    CodeOutput out(&code);
+    writer(out);
+    out.flush();
+    code.close();
+
+    if (out.failed) {
+        LittleFS.remove(codePath(file));
+        return false;
+    }
+
+    entry.codeLength = out.length;
+    entry.codeHash = out.hash;
+    entry.file = file;
+    return true;
+}
+
+/**
+ * The function `freeFile` finds a code file number used neither by the index nor by entries that are
+ * about to be written.
+ */
+uint8_t ScheduleStoreManager::freeFile(const std::vector<StoredProfile>& pending) const {
+    for (uint16_t file = 0; file < 256; file++) {
+        bool used = false;
+        for (const StoredProfile& entry : index) used |= entry.file == file;
+        for (const StoredProfile& entry : pending) used |= entry.file == file;
+        if (!used) return file;
+    }
+    return 0; // Unreachable, there are far fewer profiles than file numbers
+}
+
+String ScheduleStoreManager::codePath(uint8_t file) const {
+    return "/schedule/" + String(file) + ".bin";
+}
+
+/**
+ * The function `decodeFile` streams a profile's code file through `CompactSchedule::decodeDay` in
+ * pieces of 64 bytes. An entry split between two pieces is moved to the front of the buffer and
+ * completed by the next read.
+ */
+bool ScheduleStoreManager::decodeFile(uint8_t profile, uint8_t weekday, bool literalsOnly, uint8_t* bitmap, std::vector<RingRule>* rules) {
+    if (profile >= index.size()) {
+        return false;
+    }
+
+    File file = LittleFS.open(codePath(index[profile].file), "r");
+    if (!file) {
+        return false;
+    }
+
+    uint8_t buffer[64];
+    size_t used = 0;
+    RingCodeState state;
+    while (true) {
+        size_t read = file.read(buffer + used, sizeof(buffer) - used);
+        used += read;
+
+        size_t consumed = CompactSchedule::decodeDay(buffer, used, weekday, literalsOnly, state, bitmap, rules);
+        memmove(buffer, buffer + consumed, used - consumed);
+        used -= consumed;
+
+        if (read == 0) break;
+    }
+    file.close();
+    return true;
+}
+
+/**
+ * The function `removeOrphans` deletes code files that no profile refers to, left behind when the
+ * power failed between writing a profile and writing the index.
+ */
+void ScheduleStoreManager::removeOrphans() {
+    std::vector<String> orphans;
+    Dir dir = LittleFS.openDir("/schedule");
+    while (dir.next()) {
+        String name = dir.fileName();
+        if (name == "index.bin") continue;
+
+        bool used = false;
+        for (const StoredProfile& entry : index) {
+            used |= name == String(entry.file) + ".bin";
+        }
+        if (!used) orphans.push_back("/schedule/" + name);
+    }
+
+    for (const String& path : orphans) {
+        LittleFS.remove(path);
+    }
+}
+
+/**
+ * The function `updateHash` recalculates the hash of all profiles after the index changed.
+ */
+void ScheduleStoreManager::updateHash() {
+    uint32_t result = 2166136261UL;
+    auto add = [&result](uint32_t value, uint8_t bytes) {
+        for (uint8_t i = 0; i < bytes; i++) {
+            result = (result ^ ((value >> (i * 8)) & 0xFF)) * 16777619UL;
+        }
+    };
+
+    for (const StoredProfile& entry : index) {
+        for (uint8_t i = 0; i <= CompactSchedule::MAX_NAME_LENGTH; i++) {
+            add((uint8_t)entry.name[i], 1);
+        }
+        add(entry.startDay, 2);
+        add(entry.endDay, 2);
+        add(entry.codeHash, 4);
+    }
+    indexHash = result;
+}
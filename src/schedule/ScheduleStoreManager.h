@@ -0,0 +1,97 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the schedule store on LittleFS. Every profile's ring code is kept in its own file and
+a small index holds the names, date ranges and checksums, so only the index is kept in RAM and a day's
+rings are read from flash when they are needed, however large the schedule grows.
+*/
+
+#ifndef ScheduleStoreManager_h
+#define ScheduleStoreManager_h
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <functional>
+#include <vector>
+
+#include "CompactSchedule.h"
+#include "../board/EEPROMLayoutManager.h"
+
+extern EEPROMLayoutManager eepromManager;
+
+/*
+Files:
+  /schedule/index.bin   'B' 'X' magic, format version, profile count, then one 25 byte entry per profile:
+                        name[12] (NUL padded), startDay u16, endDay u16, codeLength u32, codeHash u32,
+                        file u8, and a crc32 of everything before it
+  /schedule/<file>.bin  ring code of one profile (see CompactSchedule.h)
+A changed profile is written to a new file first and the index is replaced by renaming a temporary file,
+so a power loss during a save leaves either the old or the new schedule, never a mix.
+*/
+
+// Index entry of a stored profile
+struct StoredProfile {
+    char name[CompactSchedule::MAX_NAME_LENGTH + 1];
+    uint16_t startDay;
+    uint16_t endDay;
+    uint32_t codeLength;
+    uint32_t codeHash; // FNV-1a hash of the ring code
+    uint8_t file; // Number of the code file
+};
+
+class ScheduleStoreManager {
+public:
+    static constexpr uint8_t MAX_PROFILES = 32;
+
+    // Writes a profile's ring code, it may be called more than once and must write the same bytes each time
+    typedef std::function<void(Print& out)> CodeWriter;
+
+    // A profile given to `replaceProfiles`, its ring code is produced by `writer` when it is stored
+    struct NewProfile {
+        String name;
+        uint16_t startDay;
+        uint16_t endDay;
+        CodeWriter writer;
+    };
+
+    ScheduleStoreManager();
+    bool begin();
+    uint32_t hash() const;
+    uint32_t profileHash(uint8_t profile) const;
+
+    uint8_t profileCount() const;
+    uint8_t findProfile(const String& name) const;
+    String profileName(uint8_t profile) const;
+    uint16_t profileStartDay(uint8_t profile) const;
+    uint16_t profileEndDay(uint8_t profile) const;
+    uint8_t resolveProfile(uint16_t today) const;
+
+    bool setProfile(const String& name, uint16_t startDay, uint16_t endDay, const std::vector<uint8_t>& code);
+    bool setProfile(const String& name, uint16_t startDay, uint16_t endDay, const CodeWriter& writer);
+    bool replaceProfiles(const CompactSchedule& schedule);
+    bool replaceProfiles(const std::vector<NewProfile>& profiles);
+    bool removeProfile(uint8_t profile);
+
+    bool loadDay(uint8_t profile, uint8_t weekday, uint8_t* bitmap, bool literalsOnly = false);
+    bool getRules(uint8_t profile, std::vector<RingRule>& rules);
+
+private:
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr uint8_t HEADER_SIZE = 4;
+    static constexpr uint8_t ENTRY_SIZE = 25;
+
+    static void serializeIndex(const std::vector<StoredProfile>& entries, std::vector<uint8_t>& out);
+    bool readIndex();
+    bool writeIndex(const std::vector<StoredProfile>& newIndex);
+    bool writeCode(const CodeWriter& writer, StoredProfile& entry, uint8_t file);
+    uint8_t freeFile(const std::vector<StoredProfile>& pending) const;
+    String codePath(uint8_t file) const;
+    bool decodeFile(uint8_t profile, uint8_t weekday, bool literalsOnly, uint8_t* bitmap, std::vector<RingRule>* rules);
+    void removeOrphans();
+    void updateHash();
+
+    std::vector<StoredProfile> index;
+    uint32_t indexHash; // Hash of all profiles, changes when any name, date range or ring changes
+};
+
+#endif
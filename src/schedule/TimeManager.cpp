@@ -2,48 +2,82 @@
 Quinton Nelson
 3/12/2024
 This file handles time synchronization with NTP, keeping track of the current time, and returning the current time and date
+The local time is decomposed once per minute and cached, so ring checks never touch the time zone rules or allocate memory
+The clock is kept here (millis() plus drift and slew corrections from NTPManager), ezTime is only used for the time zone rules
+A checkpoint of the clock is kept in RTC memory so the bells keep ringing right after a reset, before Wi-Fi and NTP are up
 */
 
 #include "TimeManager.h"
+#include <coredecls.h>
 
-TimeManager::TimeManager() {}
+TimeManager::TimeManager() : nextMinuteUtc(0), nextDstTransitionUtc(0), utcOffsetMinutes(0), minuteOfDay(0), dayNumber(0), dayOfWeek(5),
+                             baseEpochMillis(0), baseMillis(0), timeValid(false), timeRestored(false), minuteChangePending(false),
+                             lastCheckpointAt(0), driftPpm(0), driftCarry(0), slewRemaining(0) {}
 
 /**
- * The `begin` function in the `TimeManager` class sets the time zone to CST and waits for time
- * synchronization from an NTP server.
+ * The `begin` function in the `TimeManager` class loads the time zone saved in EEPROM (CST by default)
+ * and restores the clock from the RTC memory checkpoint if the board was only reset. It never waits
+ * for the network, NTPManager sets the clock once Wi-Fi is up.
  */
 void TimeManager::begin() {
-    // Set the time zone to CST, using Posix format which contains the daylight savings time rules
-    myTimeZone.setPosix("CST6CDT,M3.2.0,M11.1.0");
-
-    //This function waits for the time to be synchronized from the NTP server
-    if (waitForSync()) {
-        eepromManager.addSystemMessage("Time synchronized successfully.");
-    } else {
-        eepromManager.addSystemMessage("Time synchronization failed.");
+    // Set the time zone using Posix format which contains the daylight savings time rules
+    posixTimezone = eepromManager.loadTimezone();
+    myTimeZone.setPosix(posixTimezone);
+
+    // NTPManager keeps the clock in sync, stop ezTime from polling on its own
+    setInterval(0);
+
+    if (restoreCheckpoint()) {
+        eepromManager.addSystemMessage("Time restored after reset, waiting for NTP.");
     }
+
+    nextMinuteUtc = 0;
+    nextDstTransitionUtc = 0;
+    minuteChangePending = update(); // The ring task sees the restored minute on its first update
 }
 
 /**
- * The getTime function in the TimeManager class retrieves the current hour and minute, formats them
- * with leading zeros if necessary, and returns the time in the format "HH:MM".
+ * The `update` function refreshes the cached local time when a new minute starts (or the clock was
+ * set backwards). It is cheap to call on every loop iteration.
  * 
- * @return The `getTime()` function returns a formatted string representing the current time in the
- * format "HH:MM" (hours:minutes). The function first retrieves the current hour and minute in the
- * local time zone, then formats them with leading zeros if necessary, and finally returns the
- * formatted time string.
+ * @return `true` if the cached local minute changed, which is when the schedule should be checked. A
+ * change found while the clock was set (`begin`, `stepClock`) is kept and returned by the next call.
  */
-String TimeManager::getTime() {
-    // Get the current hour and minute
-    String hour = String(myTimeZone.hour());
-    String minute = String(myTimeZone.minute());
+bool TimeManager::update() {
+    if (millis() - baseMillis >= 1000) {
+        tickClock();
+    }
+    if (!timeValid) {
+        return false;
+    }
+    if (millis() - lastCheckpointAt >= CHECKPOINT_INTERVAL) {
+        saveCheckpoint();
+    }
 
-    // Add a leading zero if the hour or minute is less than 10
-    if (hour.length() == 1) hour = "0" + hour;
-    if (minute.length() == 1) minute = "0" + minute;
+    bool pending = minuteChangePending;
+    minuteChangePending = false;
 
-    String time = hour + ":" + minute;
-    return time;
+    time_t utc = getEpoch();
+    if (utc < nextMinuteUtc && utc >= nextMinuteUtc - 60) {
+        return pending;
+    }
+
+    uint16_t previousMinute = minuteOfDay;
+    uint16_t previousDay = dayNumber;
+    refreshLocalTime(utc);
+    return pending || minuteOfDay != previousMinute || dayNumber != previousDay;
+}
+
+/**
+ * The getTime function in the TimeManager class returns the cached local time in the format "HH:MM".
+ * 
+ * @return The `getTime()` function returns a formatted string representing the current time in the
+ * format "HH:MM" (hours:minutes), with leading zeros.
+ */
+String TimeManager::getTime() {
+    char time[6];
+    snprintf(time, sizeof(time), "%02u:%02u", minuteOfDay / 60, minuteOfDay % 60);
+    return String(time);
 }
 
 /**
@@ -55,17 +89,291 @@ String TimeManager::getTime() {
  */
 String TimeManager::getDateTime() {
     // Get the current date and time
-    String dateTime = myTimeZone.dateTime("Y-m-d H:i:s");
+    String dateTime = myTimeZone.dateTime(getEpoch(), UTC_TIME, "Y-m-d H:i:s");
     return dateTime;
 }
 
 /**
- * The function `getDayOfWeek` in the `TimeManager` class returns the current day of the week.
+ * The function `getDayOfWeek` in the `TimeManager` class returns the cached local day of the week.
  * 
- * @return The function `getDayOfWeek()` is returning the day of the week as an integer value.
+ * @return The day of the week as an integer value, 1 = Sunday through 7 = Saturday.
  */
 int TimeManager::getDayOfWeek() {
-    time_t now = myTimeZone.now();
-    int dayOfWeek = weekday(now);
     return dayOfWeek;
-}
\ No newline at end of file
+}
+
+/**
+ * The function `getDayNumber` returns the cached local date as the number of days since 1970-01-01.
+ * This is the format used for the date ranges of schedule profiles.
+ * 
+ * @return The number of whole days since 1970-01-01 in the local time zone.
+ */
+uint16_t TimeManager::getDayNumber() {
+    return dayNumber;
+}
+
+/**
+ * The function `getMinuteOfDay` returns the cached local time as minutes since midnight.
+ * 
+ * @return The minute of the day, 0 - 1439.
+ */
+uint16_t TimeManager::getMinuteOfDay() {
+    return minuteOfDay;
+}
+
+/**
+ * The function `getEpoch` returns the current UTC time.
+ * 
+ * @return Seconds since 1970-01-01 00:00:00 UTC.
+ */
+time_t TimeManager::getEpoch() {
+    return getEpochMillis() / 1000;
+}
+
+/**
+ * The function `getEpochMillis` returns the current UTC time of the disciplined clock in milliseconds.
+ * 
+ * @return Milliseconds since 1970-01-01 00:00:00 UTC, or since boot if the clock was never set.
+ */
+int64_t TimeManager::getEpochMillis() {
+    return baseEpochMillis + (uint32_t)(millis() - baseMillis);
+}
+
+/**
+ * The function `getMinuteStartMillis` returns the UTC time the cached local minute started. It is the
+ * scheduled time of a ring in the current minute, used to measure how late the ring was.
+ * 
+ * @return Milliseconds since 1970-01-01 00:00:00 UTC.
+ */
+int64_t TimeManager::getMinuteStartMillis() {
+    return (int64_t)(nextMinuteUtc - 60) * 1000;
+}
+
+/**
+ * The function `isTimeValid` tells if the clock has been set. Rings are held back until it is.
+ */
+bool TimeManager::isTimeValid() {
+    return timeValid;
+}
+
+/**
+ * The function `isTimeRestored` tells if the clock runs from the RTC checkpoint of the previous boot
+ * and has not been synchronized with NTP since.
+ */
+bool TimeManager::isTimeRestored() {
+    return timeRestored;
+}
+
+/**
+ * The function `stepClock` corrects the clock at once. It is used for the first synchronization and for
+ * offsets too large to slew. A step forward never skips a ring, `ScheduleManager::handleRing` catches up
+ * on the minutes it jumped over.
+ * 
+ * @param offsetMillis Correction to apply, positive moves the clock forward.
+ */
+void TimeManager::stepClock(int64_t offsetMillis) {
+    tickClock();
+    baseEpochMillis += offsetMillis;
+    slewRemaining = 0;
+    timeValid = true;
+    timeRestored = false;
+
+    // The cached local time is refreshed now, and the minute change is kept for the ring task so the
+    // minute the step lands in is still checked right away
+    minuteChangePending = update();
+}
+
+/**
+ * The function `slewClock` corrects the clock gradually, by at most SLEW_RATE ms per second, so the
+ * time never jumps. The part of the offset that the correction still pending does not explain was
+ * accumulated by the oscillator since the last sync, and is used to refine the drift estimate.
+ * 
+ * @param offsetMillis Measured offset (server time - local time).
+ * @param intervalMillis Time since the previous measurement.
+ */
+void TimeManager::slewClock(int32_t offsetMillis, uint32_t intervalMillis) {
+    tickClock();
+    if (intervalMillis >= 60000) {
+        float driftError = (float)(offsetMillis - slewRemaining) * 1000000.0f / intervalMillis;
+        driftPpm = constrain(driftPpm + driftError / 2, -MAX_DRIFT_PPM, MAX_DRIFT_PPM);
+    }
+    slewRemaining = offsetMillis;
+}
+
+float TimeManager::getDriftPpm() {
+    return driftPpm;
+}
+
+int32_t TimeManager::getPendingSlewMillis() {
+    return slewRemaining;
+}
+
+/**
+ * The function `getNextDstTransition` returns when the UTC offset changes next. Rings scheduled in the
+ * hour skipped by the spring transition ring once when the clock jumps past them, and rings in the hour
+ * repeated by the fall transition only ring the first time.
+ * 
+ * @return The UTC time of the next transition, about a year ahead if the time zone has no DST.
+ */
+time_t TimeManager::getNextDstTransition() {
+    return nextDstTransitionUtc;
+}
+
+/**
+ * The function `setTimezone` applies and saves a new POSIX TZ string, e.g. "EST5EDT,M3.2.0,M11.1.0".
+ * 
+ * @param posix The POSIX TZ string.
+ * 
+ * @return `false` if the string is obviously not a TZ string or could not be saved.
+ */
+bool TimeManager::setTimezone(const String& posix) {
+    if (!isValidTimezone(posix)) {
+        return false;
+    }
+
+    posixTimezone = posix;
+    myTimeZone.setPosix(posixTimezone);
+
+    // Drop the cached offset and transition so they are recalculated for the new zone
+    nextMinuteUtc = 0;
+    nextDstTransitionUtc = 0;
+    update();
+
+    return eepromManager.saveTimezone(posixTimezone);
+}
+
+/**
+ * The function `isValidTimezone` checks a POSIX TZ string without applying it.
+ *
+ * @return `false` if the string is obviously not a TZ string or too long to be saved.
+ */
+bool TimeManager::isValidTimezone(const String& posix) {
+    if (posix.length() < 4 || posix.length() > 59) {
+        return false;
+    }
+    return isalpha(posix[0]) || posix[0] == '<';
+}
+
+String TimeManager::getTimezone() {
+    return posixTimezone;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `saveCheckpoint` writes the current time and drift estimate to RTC user memory. This is
+ * cheap (a few microseconds) so it is done often, the time lost on a reset is at most CHECKPOINT_INTERVAL.
+ */
+void TimeManager::saveCheckpoint() {
+    ClockCheckpoint checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    checkpoint.epochMillis = getEpochMillis();
+    checkpoint.magic = CHECKPOINT_MAGIC;
+    checkpoint.driftPpm = driftPpm;
+    checkpoint.crc = crc32(&checkpoint, offsetof(ClockCheckpoint, crc));
+
+    ESP.rtcUserMemoryWrite(CHECKPOINT_BLOCK, (uint32_t*)&checkpoint, sizeof(checkpoint));
+    lastCheckpointAt = millis();
+}
+
+/**
+ * The function `restoreCheckpoint` sets the clock from the RTC memory checkpoint. RTC memory keeps its
+ * content through a reset (watchdog, crash, reset button or a restart after saving settings) but not
+ * through a power loss, in which case the checksum fails and the clock stays unset until NTP answers.
+ * The time between the checkpoint and the reset is not known, the clock is at most CHECKPOINT_INTERVAL
+ * plus the boot time behind until NTP corrects it.
+ * 
+ * @return `true` if the clock was restored.
+ */
+bool TimeManager::restoreCheckpoint() {
+    ClockCheckpoint checkpoint;
+    if (!ESP.rtcUserMemoryRead(CHECKPOINT_BLOCK, (uint32_t*)&checkpoint, sizeof(checkpoint))) {
+        return false;
+    }
+    if (checkpoint.magic != CHECKPOINT_MAGIC || checkpoint.crc != crc32(&checkpoint, offsetof(ClockCheckpoint, crc))) {
+        return false;
+    }
+
+    // millis() restarted at zero with the reset, so the time since boot has to be added
+    baseMillis = millis();
+    baseEpochMillis = checkpoint.epochMillis + baseMillis;
+    driftPpm = checkpoint.driftPpm;
+    timeValid = true;
+    timeRestored = true;
+    return true;
+}
+
+/**
+ * The function `tickClock` moves the clock base forward to now, applying the drift correction and the
+ * next slice of any pending slew.
+ */
+void TimeManager::tickClock() {
+    uint32_t now = millis();
+    uint32_t elapsed = now - baseMillis;
+
+    // Drift correction, keeping the fraction of a ms for the next tick
+    driftCarry += elapsed * driftPpm / 1000000.0f;
+    int32_t drift = (int32_t)driftCarry;
+    driftCarry -= drift;
+
+    // Slew at most SLEW_RATE ms per elapsed second
+    int32_t maxSlew = elapsed * SLEW_RATE / 1000;
+    int32_t slew = constrain(slewRemaining, -maxSlew, maxSlew);
+    slewRemaining -= slew;
+
+    baseEpochMillis += elapsed + drift + slew;
+    baseMillis = now;
+}
+
+/**
+ * The function `refreshLocalTime` decomposes a UTC time into the cached local fields. The UTC offset
+ * is only looked up again after crossing the precomputed DST transition.
+ * 
+ * @param utc The current UTC time.
+ */
+void TimeManager::refreshLocalTime(time_t utc) {
+    if (nextDstTransitionUtc == 0 || utc >= nextDstTransitionUtc || utc < nextMinuteUtc - 60) {
+        utcOffsetMinutes = myTimeZone.getOffset(utc, UTC_TIME);
+        findNextDstTransition(utc);
+    }
+
+    time_t local = utc - (time_t)utcOffsetMinutes * 60;
+    dayNumber = local / 86400;
+    minuteOfDay = (local % 86400) / 60;
+    dayOfWeek = (dayNumber + 4) % 7 + 1; // 1970-01-01 was a Thursday
+
+    nextMinuteUtc = utc - utc % 60 + 60;
+}
+
+/**
+ * The function `findNextDstTransition` searches the coming year for the next change of the UTC offset,
+ * first in weekly steps and then by bisection down to the minute.
+ * 
+ * @param utc The time to search from.
+ */
+void TimeManager::findNextDstTransition(time_t utc) {
+    const time_t week = 7L * 86400;
+    time_t low = utc;
+    time_t high = utc;
+
+    for (int i = 0; i < 53; i++) {
+        high += week;
+        if (myTimeZone.getOffset(high, UTC_TIME) != utcOffsetMinutes) break;
+        low = high;
+    }
+
+    if (myTimeZone.getOffset(high, UTC_TIME) == utcOffsetMinutes) {
+        nextDstTransitionUtc = high; // No transition within a year, look again then
+        return;
+    }
+
+    while (high - low > 60) {
+        time_t middle = low + (high - low) / 2;
+        if (myTimeZone.getOffset(middle, UTC_TIME) == utcOffsetMinutes) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    nextDstTransitionUtc = high - high % 60;
+}
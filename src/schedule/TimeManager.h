@@ -18,11 +18,62 @@ class TimeManager {
 public:
     TimeManager();
     void begin();
+    bool update();
     String getTime();
     String getDateTime();
     int getDayOfWeek();
+    uint16_t getDayNumber();
+    uint16_t getMinuteOfDay();
+    time_t getEpoch();
+    int64_t getEpochMillis();
+    int64_t getMinuteStartMillis();
+    bool isTimeValid();
+    bool isTimeRestored();
+    void stepClock(int64_t offsetMillis);
+    void slewClock(int32_t offsetMillis, uint32_t intervalMillis);
+    float getDriftPpm();
+    int32_t getPendingSlewMillis();
+    time_t getNextDstTransition();
+    bool setTimezone(const String& posix);
+    static bool isValidTimezone(const String& posix);
+    String getTimezone();
 private:
+    static constexpr uint32_t SLEW_RATE = 5; // Maximum slew in ms per second of elapsed time (0.5%)
+    static constexpr float MAX_DRIFT_PPM = 500;
+    static constexpr uint32_t CHECKPOINT_INTERVAL = 100; // Time between clock checkpoints (ms)
+    static constexpr uint32_t CHECKPOINT_BLOCK = 32; // First RTC user memory block, blocks 0 - 31 are used by OTA
+    static constexpr uint32_t CHECKPOINT_MAGIC = 0x424C434B; // "BLCK"
+
+    // Clock state kept in RTC user memory, which survives a reset but not a power loss
+    struct ClockCheckpoint {
+        int64_t epochMillis; // UTC time in ms when the checkpoint was written
+        uint32_t magic;
+        float driftPpm;
+        uint32_t crc; // CRC32 of the fields above
+    };
+
+    void saveCheckpoint();
+    bool restoreCheckpoint();
+    void tickClock();
+    void refreshLocalTime(time_t utc);
+    void findNextDstTransition(time_t utc);
     Timezone myTimeZone;
+    String posixTimezone; // POSIX TZ string, saved in EEPROM
+    time_t nextMinuteUtc; // UTC time the cached local time expires
+    time_t nextDstTransitionUtc; // UTC time the UTC offset changes next
+    int16_t utcOffsetMinutes; // ezTime offset (UTC - local) valid until nextDstTransitionUtc
+    uint16_t minuteOfDay; // Cached local minute of the day (0 - 1439)
+    uint16_t dayNumber; // Cached local days since 1970-01-01
+    uint8_t dayOfWeek; // Cached local day of the week, 1 = Sunday
+    int64_t baseEpochMillis; // UTC time in ms at baseMillis
+    uint32_t baseMillis; // millis() of the last clock tick
+    bool timeValid; // The clock has been set at least once
+    bool timeRestored; // The clock was restored from the RTC checkpoint and not synchronized since
+    bool minuteChangePending; // The minute changed while the clock was set, the next `update` reports it
+    uint32_t lastCheckpointAt; // millis() of the last checkpoint
+    float driftPpm; // Estimated oscillator error, positive when millis() runs slow
+    float driftCarry; // Fraction of a ms of drift correction not applied yet
+    int32_t slewRemaining; // Correction still to be slewed in (ms)
 };
 
 #endif
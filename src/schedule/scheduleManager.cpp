@@ -1,7 +1,7 @@
 /*
 Quinton Nelson
 3/22/2024
-This file handles reading a schedule from the client, saving it to EEPROM, and checking if the bell should ring
+This file handles reading a schedule from the client, saving it to LittleFS, and checking if the bell should ring
 */
 
 #include "scheduleManager.h"
@@ -9,79 +9,582 @@ This file handles reading a schedule from the client, saving it to EEPROM, and c
 /****************PUBLIC******************/
 
 // Constructor for ScheduleManager class that initializes the EEPROMLayoutManager, TimeManager, and RelayManager objects
-ScheduleManager::ScheduleManager() : currentSchedule(4096) {
-    loadScheduleFromEEPROM();
-    ringInterval = 60000; // 1 minute interval
-    lastRingTimeMillies = 0;
+// The global instance is constructed before setup() starts the EEPROM, the state is loaded by `begin`
+ScheduleManager::ScheduleManager() {
+    manualProfile = CompactSchedule::NO_PROFILE;
+    version = 0;
+    invalidateDays();
+    lastCheckedDay = 0;
+    lastCheckedMinute = 0;
+    lastRingLateness = 0;
+    maxRingLateness = 0;
+    totalRingLateness = 0;
+    ringCount = 0;
+}
+
+/**
+ * The function `begin` loads the manually selected profile from EEPROM, which must be started, and opens
+ * the schedule store on LittleFS, which must be mounted. On the first boot after an update from firmware
+ * that kept the schedule in EEPROM, the schedule is moved to the store. The profile is saved to EEPROM on
+ * every change, so after a warm restart it matches the one `restoreState` restored.
+ */
+void ScheduleManager::begin() {
+    manualProfile = eepromManager.loadActiveProfile();
+    if (!store.begin()) {
+        migrateFromEEPROM();
+    }
+    invalidateDays();
 }
 
 
 /**
  * The function `updateSchedule` in the `ScheduleManager` class updates and saves a schedule by
- * deserializing, validating, sorting, and serializing JSON data.
+ * validating and compiling a parsed JSON document into the compact schedule format.
  * 
- * @param jsonSchedule The `jsonSchedule` parameter in the `updateSchedule` function is a JSON string
- * that represents a schedule. This JSON string is deserialized into a `DynamicJsonDocument` object
- * named `tempSchedule` for further processing. The function then validates the structure and content
- * of the schedule, sorts the schedule
+ * @param schedule The `schedule` parameter is either a single week schedule (days as keys and
+ * arrays of "HH:MM" times as values, plus an optional "rules" array, see `compileRule`), which
+ * replaces the currently active profile, or a document of the
+ * form {"profiles":[{"name":..., "start":"YYYY-MM-DD", "end":"YYYY-MM-DD", "days":{...}}], "active":...}
+ * which replaces every profile at once. "start", "end" and "active" are optional.
  * 
  * @return The `updateSchedule` function returns a boolean value. It returns `true` if the schedule
- * update was successful and the updated schedule was saved to EEPROM, and it returns `false` if there
- * was an error during the process such as failure to deserialize the JSON string, validation failure,
- * or failure to save the updated schedule to EEPROM.
+ * update was successful and the updated schedule was saved, and it returns `false` if there was an
+ * error during the process such as validation failure or failure to save the updated schedule.
  */
-bool ScheduleManager::updateSchedule(const String& jsonSchedule) {
-    DynamicJsonDocument tempSchedule(4096); // Temp schedule object (used for sorting times)
+bool ScheduleManager::updateSchedule(JsonObject schedule) {
+    // A single week schedule replaces the profile that is active right now
+    if (!schedule.containsKey("profiles")) {
+        uint8_t profile = activeProfile();
+        String name = profile == CompactSchedule::NO_PROFILE ? String("default") : store.profileName(profile);
+        std::vector<uint8_t> code;
+        if (!compileDays(schedule, code)) {
+            return false; // Schedule is not as expected, indicate failure
+        }
 
-    // Deserialize the JSON string into the tempSchedule object
-    auto error = deserializeJson(tempSchedule, jsonSchedule);
-        if (error) {
-        return false; // Indicate failure to update schedule
+        bool saved = store.setProfile(name, store.profileStartDay(profile), store.profileEndDay(profile), code);
+        invalidateDays(); // Read the rings again on the next check
+        return saved;
     }
-    
-    
-    // Validate the schedule structure and content
-    if (!validateSchedule(tempSchedule)) {
-        return false; // Schedule is not as expected, indicate failure
+
+    // Otherwise check every profile before touching the current schedule. The store then compiles one
+    // profile at a time straight into its file, the code of all profiles is never held in RAM at once.
+    JsonArray profiles = schedule["profiles"].as<JsonArray>();
+    if (profiles.size() > ScheduleStoreManager::MAX_PROFILES) {
+        return false;
+    }
+
+    std::vector<ScheduleStoreManager::NewProfile> newProfiles;
+    for (JsonObject profile : profiles) {
+        std::vector<uint8_t> code;
+        uint16_t startDay = CompactSchedule::NO_DATE;
+        uint16_t endDay = CompactSchedule::NO_DATE;
+
+        if (!compileDays(profile["days"].as<JsonObject>(), code)) return false;
+        if (profile.containsKey("start") && !parseDate(profile["start"].as<String>(), startDay)) return false;
+        if (profile.containsKey("end") && !parseDate(profile["end"].as<String>(), endDay)) return false;
+
+        JsonObject days = profile["days"].as<JsonObject>();
+        newProfiles.push_back({profile["name"].as<String>(), startDay, endDay, [this, days](Print& out) {
+            std::vector<uint8_t> code;
+            compileDays(days, code);
+            out.write(code.data(), code.size());
+        }});
+    }
+
+    if (!store.replaceProfiles(newProfiles)) {
+        return false;
     }
 
-    // Sort the schedule times for each day (modified by reference)
-    sortScheduleTimes(tempSchedule);
+    uint8_t manual = CompactSchedule::NO_PROFILE;
+    if (schedule.containsKey("active")) {
+        manual = store.findProfile(schedule["active"].as<String>());
+    }
+    if (manual != manualProfile) {
+        manualProfile = manual;
+        eepromManager.saveActiveProfile(manualProfile);
+    }
+    invalidateDays();
+    return true;
+}
+
+/**
+ * The function `updateProfile` adds or replaces a single named profile.
+ * 
+ * @param name Name of the profile to add or replace.
+ * @param schedule A single week schedule (days as keys and arrays of "HH:MM" times as values).
+ * @param startDate First day the profile is active ("YYYY-MM-DD"), or an empty string for no start.
+ * @param endDate Last day the profile is active ("YYYY-MM-DD"), or an empty string for no end.
+ * 
+ * @return `true` if the profile was saved, `false` if the schedule or dates are invalid, the profile
+ * table is full, or the profile could not be written to flash.
+ */
+bool ScheduleManager::updateProfile(const String& name, JsonObject schedule, const String& startDate, const String& endDate) {
+    std::vector<uint8_t> code;
+    uint16_t startDay = CompactSchedule::NO_DATE;
+    uint16_t endDay = CompactSchedule::NO_DATE;
 
-    // Clear the currentSchedule object and copy the tempSchedule object to it
-    currentSchedule.clear();
-    currentSchedule = tempSchedule;
+    if (!compileDays(schedule, code)) return false;
+    if (startDate.length() > 0 && !parseDate(startDate, startDay)) return false;
+    if (endDate.length() > 0 && !parseDate(endDate, endDay)) return false;
+    if (!store.setProfile(name, startDay, endDay, code)) return false;
 
-    // Now that currentSchedule is updated, save back to EEPROM
-    String updatedJsonString;
-    serializeJson(currentSchedule, updatedJsonString); // Serialize the currentSchedule object back to a string
-    return eepromManager.saveRingSchedule(updatedJsonString); // Save the updated schedule to EEPROM
+    invalidateDays();
+    return true;
 }
 
+/**
+ * The function `setActiveProfile` switches the active profile. Only the selected profile index is
+ * written to EEPROM, the ring lists are neither re-parsed nor rewritten.
+ * 
+ * @param name Name of the profile to activate, or "auto" to select the profile by date again.
+ * 
+ * @return `false` if there is no profile with that name.
+ */
+bool ScheduleManager::setActiveProfile(const String& name) {
+    uint8_t profile = CompactSchedule::NO_PROFILE;
+    if (name != "auto") {
+        profile = store.findProfile(name);
+        if (profile == CompactSchedule::NO_PROFILE) {
+            return false;
+        }
+    }
+
+    manualProfile = profile;
+    invalidateDays();
+    return eepromManager.saveActiveProfile(manualProfile);
+}
 
 /**
- * The function `getScheduleString` returns a JSON string representation of the current schedule.
+ * The function `deleteProfile` removes a profile from the schedule.
+ * 
+ * @param name Name of the profile to remove.
  * 
- * @return The `getScheduleString` function returns a string representation of the `currentSchedule`
- * object after serializing it using the `serializeJson` function.
+ * @return `false` if there is no profile with that name or the schedule could not be saved.
  */
-String ScheduleManager::getScheduleString() {
-    String schedule;
-    serializeJson(currentSchedule, schedule);
-    return schedule;
+bool ScheduleManager::deleteProfile(const String& name) {
+    uint8_t profile = store.findProfile(name);
+    if (profile == CompactSchedule::NO_PROFILE || !store.removeProfile(profile)) {
+        return false;
+    }
+
+    // Keep the manual selection pointing at the same profile after the indexes shift
+    if (manualProfile == profile) {
+        manualProfile = CompactSchedule::NO_PROFILE;
+        eepromManager.saveActiveProfile(manualProfile);
+    } else if (manualProfile != CompactSchedule::NO_PROFILE && manualProfile > profile) {
+        manualProfile--;
+        eepromManager.saveActiveProfile(manualProfile);
+    }
+
+    invalidateDays();
+    return true;
 }
 
+
 /**
- * The `handleRing` function checks if the bell should ring and activates the relay if necessary.
+ * The function `beginCsvImport` starts a CSV import. Rows are given to `importCsvChunk` as the request
+ * body arrives and only applied by `finishCsvImport`, so a file with an error changes nothing.
+ * 
+ * The file has one ring per row: "profile,day,time", e.g. "exams,monday,08:15". The day is a weekday
+ * name (or its first three letters) and the time is "H:MM" or "HH:MM". Empty lines, lines starting with
+ * '#' and a header row starting with "profile" are skipped. Fields may be quoted.
+ * 
+ * Rings are collected in a bitmap of 1440 bits per day and profile, so memory is fixed by the number of
+ * profiles no matter how many rows (or duplicate rows) the file has, and each row takes constant time.
+ * A file may name up to CsvImport::MAX_PROFILES profiles, the bitmaps of the store's full 32 would not
+ * fit in RAM.
+ */
+void ScheduleManager::beginCsvImport() {
+    csvImport.reset(new CsvImport());
+    csvImport->lineLength = 0;
+    csvImport->lineNumber = 0;
+    csvImport->ringCount = 0;
+}
+
+/**
+ * The function `importCsvChunk` parses the complete lines of a piece of the CSV file. A line split
+ * across two pieces is carried over to the next call.
+ * 
+ * @param data Next piece of the file.
+ * @param length Length of the piece in bytes.
+ */
+void ScheduleManager::importCsvChunk(const uint8_t* data, size_t length) {
+    if (!csvImport) {
+        return;
+    }
+
+    for (size_t i = 0; i < length && csvImport->error.isEmpty(); i++) {
+        char c = data[i];
+        if (c == '\n') {
+            csvImport->line[csvImport->lineLength] = '\0';
+            importCsvLine(csvImport->line);
+            csvImport->lineLength = 0;
+        } else if (csvImport->lineLength < CsvImport::MAX_LINE) {
+            csvImport->line[csvImport->lineLength++] = c;
+        } else {
+            csvImport->error = "Line " + String(csvImport->lineNumber + 1) + ": line too long";
+        }
+    }
+}
+
+/**
+ * The function `finishCsvImport` parses the last line of the file and replaces every profile named in
+ * it with the imported rings. Profiles that are not in the file are left alone, and a replaced profile
+ * keeps its date range. A profile whose rings did not change is not written again.
+ * 
+ * @param result Set to a summary of the import, or to the reason it failed.
+ * 
+ * @return `true` if the profiles were replaced and saved.
+ */
+bool ScheduleManager::finishCsvImport(String& result) {
+    if (!csvImport) {
+        result = "No CSV data received";
+        return false;
+    }
+
+    if (csvImport->lineLength > 0 && csvImport->error.isEmpty()) {
+        csvImport->line[csvImport->lineLength] = '\0';
+        importCsvLine(csvImport->line);
+    }
+
+    std::unique_ptr<CsvImport> import = std::move(csvImport);
+    if (!import->error.isEmpty()) {
+        result = import->error;
+        return false;
+    }
+    if (import->names.empty()) {
+        result = "No rings in file";
+        return false;
+    }
+
+    // Each profile is encoded from its bitmap straight into its file, the code is never held in RAM
+    for (size_t p = 0; p < import->names.size(); p++) {
+        const uint8_t* bitmap = import->rings[p].data();
+        uint8_t existing = store.findProfile(import->names[p]);
+        bool saved = store.setProfile(import->names[p], store.profileStartDay(existing), store.profileEndDay(existing),
+                                      [bitmap](Print& out) { CompactSchedule::encodeBitmap(bitmap, out); });
+        if (!saved) {
+            invalidateDays();
+            result = "Profile " + import->names[p] + " could not be saved";
+            return false;
+        }
+    }
+    invalidateDays();
+
+    result = "Imported " + String(import->ringCount) + " rings into " + String(import->names.size()) + " profiles";
+    return true;
+}
+
+/**
+ * The function `abortCsvImport` drops a CSV import in progress, e.g. when the client disconnects.
+ */
+void ScheduleManager::abortCsvImport() {
+    csvImport.reset();
+}
+
+/**
+ * The function `exportCsv` writes the schedule as CSV in the format read by `beginCsvImport`. Rings are
+ * written as they are found, the file is never built in memory. Recurring rules are written out as
+ * the individual rings they produce.
+ * 
+ * @param out Where to write the file, e.g. a buffer that sends full pieces to the client.
+ * @param profileName Name of the profile to export, every profile is exported when empty.
+ */
+void ScheduleManager::exportCsv(Print& out, const String& profileName) {
+    out.print("profile,day,time\n");
+
+    uint8_t bitmap[CompactSchedule::DAY_BYTES];
+    for (uint8_t profile = 0; profile < store.profileCount(); profile++) {
+        String name = store.profileName(profile);
+        if (profileName.length() > 0 && name != profileName) continue;
+
+        for (int day = 1; day <= 7; day++) {
+            String dayName = dayOfWeekStr(day);
+            store.loadDay(profile, day, bitmap);
+
+            uint16_t minute = nextRingInDay(bitmap, 0);
+            while (minute != CompactSchedule::NO_RING) {
+                out.print(name);
+                out.print(',');
+                out.print(dayName);
+                out.print(',');
+                out.print(formatTime(minute));
+                out.print('\n');
+                minute = nextRingInDay(bitmap, minute + 1);
+            }
+        }
+    }
+}
+
+/**
+ * The function `getScheduleString` returns a JSON string representation of a schedule profile, with
+ * the days of the week as keys and arrays of "HH:MM" times as values. Recurring rules are returned in
+ * a "rules" array as they were entered, not expanded into the day lists.
+ * 
+ * @param profileName Name of the profile to return, the active profile is used when empty.
+ * 
+ * @return The `getScheduleString` function returns the profile serialized as JSON, or "{}" if the
+ * profile does not exist.
+ */
+String ScheduleManager::getScheduleString(const String& profileName) {
+    ArenaJsonDocument schedule(4096);
+    if (!getSchedule(profileName, schedule)) {
+        return "{}";
+    }
+
+    String result;
+    serializeJson(schedule, result);
+    return result;
+}
+
+/**
+ * The function `getSchedule` fills a JSON document with a schedule profile, in the layout described at
+ * `getScheduleString`. The compact layout keeps the values of the compact schedule instead of formatting
+ * them: times and rule bounds are minutes of the day and rule days are a weekday mask (bit 0 = Sunday).
+ * It is meant for MessagePack clients, where a small integer takes 1 - 3 bytes against 6 for "HH:MM".
+ * 
+ * @param profileName Name of the profile to return, the active profile is used when empty.
+ * @param schedule Document to fill, it is cleared first.
+ * @param compact `true` for the compact layout.
+ * 
+ * @return `false` if the profile does not exist, the document is then an empty object.
+ */
+bool ScheduleManager::getSchedule(const String& profileName, JsonDocument& schedule, bool compact) {
+    schedule.to<JsonObject>();
+    uint8_t profile = profileName.length() > 0 ? store.findProfile(profileName) : activeProfile();
+    if (profile == CompactSchedule::NO_PROFILE) {
+        return false;
+    }
+
+    uint8_t bitmap[CompactSchedule::DAY_BYTES];
+    for (int day = 1; day <= 7; day++) {
+        JsonArray times = schedule.createNestedArray(dayOfWeekStr(day));
+        store.loadDay(profile, day, bitmap, true);
+        uint16_t minute = nextRingInDay(bitmap, 0);
+        while (minute != CompactSchedule::NO_RING) {
+            if (compact) {
+                times.add(minute);
+            } else {
+                times.add(formatTime(minute));
+            }
+            minute = nextRingInDay(bitmap, minute + 1);
+        }
+    }
+
+    std::vector<RingRule> rules;
+    store.getRules(profile, rules);
+    if (!rules.empty()) {
+        JsonArray rulesArray = schedule.createNestedArray("rules");
+        for (const RingRule& rule : rules) {
+            JsonObject ruleObject = rulesArray.createNestedObject();
+            ruleObject["every"] = rule.every;
+
+            if (compact) {
+                ruleObject["from"] = rule.from;
+                ruleObject["to"] = rule.to;
+                ruleObject["days"] = rule.days;
+            } else {
+                ruleObject["from"] = formatTime(rule.from);
+                ruleObject["to"] = formatTime(rule.to);
+
+                JsonArray days = ruleObject.createNestedArray("days");
+                for (int day = 1; day <= 7; day++) {
+                    if (rule.days & (1 << (day - 1))) days.add(dayOfWeekStr(day));
+                }
+            }
+
+            if (!rule.plus.empty()) {
+                JsonArray plus = ruleObject.createNestedArray("plus");
+                for (int8_t delta : rule.plus) plus.add(delta);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * The function `getScheduleETag` returns the entity tag of a schedule. For a named profile it is the
+ * FNV-1a hash of that profile's name, date range and ring code, so it changes when one of its rings,
+ * rules, its date range or name changes, but not when another profile is edited. An If-Match then only
+ * fails on a real conflict.
+ * 
+ * Without a name the request is about the schedule as a whole: the active profile (which depends on
+ * every profile's date range) or, for a multi-profile update, every profile. The tag then combines the
+ * hash of all profiles with the active profile's, so it changes when any profile changes or a different
+ * profile becomes active.
+ * 
+ * @param profileName Name of the profile, or empty for the whole schedule.
+ * 
+ * @return The entity tag including its quotes, e.g. "1a2b3c4d" in double quotes.
+ */
+String ScheduleManager::getScheduleETag(const String& profileName) {
+    uint32_t tag;
+    if (profileName.length() > 0) {
+        tag = store.profileHash(store.findProfile(profileName));
+    } else {
+        tag = (store.hash() ^ store.profileHash(activeProfile())) * 16777619UL;
+    }
+
+    char buffer[12];
+    snprintf(buffer, sizeof(buffer), "\"%08x\"", tag);
+    return String(buffer);
+}
+
+/**
+ * The function `getScheduleHash` returns the hash of every profile's name, date range and rings, which
+ * lets a fleet be compared without downloading every schedule.
+ */
+uint32_t ScheduleManager::getScheduleHash() {
+    return store.hash();
+}
+
+/**
+ * The function `getProfiles` fills a JSON document with a description of all profiles and which one is
+ * active.
+ * 
+ * @param doc Document to fill, of the form {"active":..., "manual":true|false, "profiles":[{"name":...,
+ * "start":..., "end":...}]}. Dates are omitted for profiles without a date range.
+ */
+void ScheduleManager::getProfiles(JsonDocument& doc) {
+    doc.clear();
+    uint8_t active = activeProfile();
+
+    doc["active"] = active == CompactSchedule::NO_PROFILE ? String("") : store.profileName(active);
+    doc["manual"] = manualProfile != CompactSchedule::NO_PROFILE;
+
+    JsonArray profiles = doc.createNestedArray("profiles");
+    for (uint8_t i = 0; i < store.profileCount(); i++) {
+        JsonObject profile = profiles.createNestedObject();
+        profile["name"] = store.profileName(i);
+        if (store.profileStartDay(i) != CompactSchedule::NO_DATE) {
+            profile["start"] = formatDate(store.profileStartDay(i));
+        }
+        if (store.profileEndDay(i) != CompactSchedule::NO_DATE) {
+            profile["end"] = formatDate(store.profileEndDay(i));
+        }
+    }
+}
+
+/**
+ * The `handleRing` function checks if the bell should ring and activates the relay if necessary. It is
+ * called when the local minute changes. From PREFETCH_MINUTE on, tomorrow's rings are read from flash
+ * after the check, so the ring of the minute is never held up and midnight needs no flash access.
  */
 void ScheduleManager::handleRing() {
-    unsigned long currentMillis = millis();
-    if (shouldRingNow() && (currentMillis - lastRingTimeMillies) >= ringInterval) {
-        relayManager.activateRelay();
-        lastRingTimeMillies = currentMillis;
+    if (!timeManager.isTimeValid()) {
+        return; // Never ring from an unset clock
+    }
+
+    uint16_t today = timeManager.getDayNumber();
+    uint16_t currentMinute = timeManager.getMinuteOfDay();
+    checkRings(today, currentMinute);
+
+    if (currentMinute >= PREFETCH_MINUTE && tomorrowRings.day != today + 1) {
+        buildDayTable(tomorrowRings, today + 1);
     }
 }
 
+/**
+ * The function `checkRings` rings the bell if a ring is due. Every minute since the last check is
+ * covered exactly once: when the clock jumps forward (the hour skipped by the DST spring transition, or
+ * a stalled loop) the skipped rings ring once, and when it goes back (the hour repeated by the fall
+ * transition) rings that already happened are not repeated.
+ *
+ * @param today Current local day number.
+ * @param currentMinute Current local minute of the day.
+ */
+void ScheduleManager::checkRings(uint16_t today, uint16_t currentMinute) {
+    uint16_t fromMinute = currentMinute;
+
+    if (today == lastCheckedDay) {
+        if (currentMinute <= lastCheckedMinute) {
+            return; // This minute was already checked
+        }
+        fromMinute = lastCheckedMinute + 1;
+    } else if (today == lastCheckedDay + 1) {
+        fromMinute = 0; // Midnight passed since the last check
+    }
+
+    // Catch up on at most the hour a DST transition skips
+    if (currentMinute - fromMinute > 60) {
+        fromMinute = currentMinute;
+    }
+
+    lastCheckedDay = today;
+    lastCheckedMinute = currentMinute;
+
+    uint16_t ringMinute = dueRing(fromMinute, currentMinute);
+    if (ringMinute == CompactSchedule::NO_RING) {
+        return;
+    }
+
+    // Measure how late the relay closes against the scheduled second of the ring
+    int64_t scheduledMillis = timeManager.getMinuteStartMillis() - (int64_t)(currentMinute - ringMinute) * 60000;
+    lastRingLateness = timeManager.getEpochMillis() - scheduledMillis;
+    maxRingLateness = max(maxRingLateness, lastRingLateness);
+    totalRingLateness += lastRingLateness;
+    ringCount++;
+
+    relayManager.activateScheduledRelay(scheduledMillis / 60000);
+}
+
+/**
+ * The ring accuracy getters return how late the relay closed against the scheduled second of each ring,
+ * in milliseconds, measured with the NTP disciplined clock.
+ */
+int32_t ScheduleManager::getLastRingLateness() {
+    return lastRingLateness;
+}
+
+int32_t ScheduleManager::getMaxRingLateness() {
+    return maxRingLateness;
+}
+
+int32_t ScheduleManager::getAverageRingLateness() {
+    return ringCount == 0 ? 0 : totalRingLateness / ringCount;
+}
+
+uint32_t ScheduleManager::getRingCount() {
+    return ringCount;
+}
+
+/**
+ * The function `getVersion` returns a counter that changes whenever the schedule, the selected profile or
+ * the day's rings may have changed, so responses built from the schedule can be cached until it moves.
+ */
+uint32_t ScheduleManager::getVersion() {
+    return version;
+}
+
+/**
+ * The state getters expose what `RestartManager` keeps in RTC memory across a planned restart: the
+ * manually selected profile and the last minute checked for rings.
+ */
+uint8_t ScheduleManager::getManualProfile() {
+    return manualProfile;
+}
+
+void ScheduleManager::getLastCheck(uint16_t& day, uint16_t& minute) {
+    day = lastCheckedDay;
+    minute = lastCheckedMinute;
+}
+
+/**
+ * The function `restoreState` restores the ring state from a warm restart snapshot. Restoring the last
+ * checked minute keeps a ring from repeating when the restart happens in the minute it rang. The
+ * schedule itself is read from LittleFS by `begin`.
+ * 
+ * @param manual Profile selected by the user, or NO_PROFILE.
+ * @param lastDay Day of the last ring check.
+ * @param lastMinute Minute of the day of the last ring check.
+ */
+void ScheduleManager::restoreState(uint8_t manual, uint16_t lastDay, uint16_t lastMinute) {
+    manualProfile = manual;
+    invalidateDays();
+    lastCheckedDay = lastDay;
+    lastCheckedMinute = lastMinute;
+}
+
 /**
  * The function `getTodayRemainingRingTimes` returns a string containing the remaining ring times for
  * today in a comma-separated format or "No more rings today" if there are none.
@@ -91,101 +594,340 @@ void ScheduleManager::handleRing() {
  * more rings today".
  */
 String ScheduleManager::getTodayRemainingRingTimes() {
-    JsonArray remainingTimes = getRemainingRingTimes();
+    std::vector<uint16_t> minutes;
+    getTodayRemainingRings(minutes);
+
     String result;
-    for (JsonVariant v : remainingTimes) {
+    for (uint16_t minute : minutes) {
         if (!result.isEmpty()) {
             result += ",";
         }
-        result += v.as<String>();
+        result += formatTime(minute);
     }
     return result.isEmpty() ? "No more rings today" : result;
 }
 
-/****************PRIVATE******************/
+/**
+ * The function `getTodayRemainingRings` collects the rings of today strictly after the current minute.
+ * 
+ * @param minutes Filled with the minutes of the day of the remaining rings, in order.
+ */
+void ScheduleManager::getTodayRemainingRings(std::vector<uint16_t>& minutes) {
+    const DayTable& table = todayTable();
+    minutes.clear();
+
+    uint16_t minute = nextRingInDay(table.bits, timeManager.getMinuteOfDay() + 1);
+    while (minute != CompactSchedule::NO_RING) {
+        minutes.push_back(minute);
+        minute = nextRingInDay(table.bits, minute + 1);
+    }
+}
 
 /**
- * The function `shouldRingNow` checks if the current time matches any scheduled time for ringing a
- * bell based on the day of the week.
+ * The function `getNextRingMinute` returns the next ring of today after the current minute.
  * 
- * @return The function `shouldRingNow()` returns a boolean value. It returns `true` if the current
- * time matches any of the scheduled times for the day in the `currentSchedule`, indicating that the
- * bell should ring now. Otherwise, it returns `false`, indicating that there is no scheduled ringing
- * for the current minute.
+ * @return The minute of the day of the next ring, or `CompactSchedule::NO_RING` if there are no more
+ * rings today or the clock is not set.
  */
-bool ScheduleManager::shouldRingNow() {
-    String currentTime = timeManager.getTime(); // "HH:MM" format
-    String today = dayOfWeekStr(timeManager.getDayOfWeek());
-    
-    // Ensure currentSchedule contains today's schedule
-    if (!currentSchedule.containsKey(today)) return false;
+uint16_t ScheduleManager::getNextRingMinute() {
+    if (!timeManager.isTimeValid()) {
+        return CompactSchedule::NO_RING;
+    }
+    return nextRingInDay(todayTable().bits, timeManager.getMinuteOfDay() + 1);
+}
 
-    JsonArray times = currentSchedule[today].as<JsonArray>();
+/**
+ * The function `getSecondsToNextRing` returns the time until the next ring after the current minute,
+ * today or, once tomorrow's rings were read before midnight, right after midnight.
+ * 
+ * @return Seconds until the next ring, or `NO_RING_SECONDS` if there is none or the clock is not set.
+ */
+uint32_t ScheduleManager::getSecondsToNextRing() {
+    if (!timeManager.isTimeValid()) {
+        return NO_RING_SECONDS;
+    }
 
-    // Look for the exact current time in today's schedule
-    for (JsonVariant v : times) {
-        if (currentTime == v.as<String>()) {
-            return true; // Time to ring the bell
+    uint16_t minute = timeManager.getMinuteOfDay();
+    uint32_t nextRing = nextRingInDay(todayTable().bits, minute + 1);
+    if (nextRing == CompactSchedule::NO_RING) {
+        if (tomorrowRings.day != timeManager.getDayNumber() + 1) {
+            return NO_RING_SECONDS;
         }
+        nextRing = nextRingInDay(tomorrowRings.bits, 0);
+        if (nextRing == CompactSchedule::NO_RING) {
+            return NO_RING_SECONDS;
+        }
+        nextRing += 1440;
+    }
+    return (nextRing - minute) * 60 - timeManager.getEpoch() % 60;
+}
+
+/**
+ * The function `getSecondsSinceRing` returns the time since the ring of the current minute. Rings are
+ * due at the start of their minute.
+ * 
+ * @return Seconds since the ring, or `NO_RING_SECONDS` if the current minute has no ring or the clock is
+ * not set.
+ */
+uint32_t ScheduleManager::getSecondsSinceRing() {
+    if (!timeManager.isTimeValid()) {
+        return NO_RING_SECONDS;
+    }
+
+    uint16_t minute = timeManager.getMinuteOfDay();
+    if (nextRingInDay(todayTable().bits, minute) != minute) {
+        return NO_RING_SECONDS;
     }
-    return false; // No ring scheduled for the current minute
+    return timeManager.getEpoch() % 60;
 }
 
+/****************PRIVATE******************/
 
 /**
- * The function `getRemainingRingTimes` retrieves the remaining ring times for the current day based on
- * the current time.
+ * The function `dueRing` checks if any ring of today's schedule falls between `fromMinute` and the
+ * current minute.
+ * 
+ * @param fromMinute First minute of the day that has not been checked yet.
+ * @param currentMinute The current minute of the day.
  * 
- * @return A JsonArray containing the remaining ring times for the current day that are after the
- * current time.
+ * @return The minute of the first ring in the range [fromMinute, currentMinute], indicating that the
+ * bell should ring now, or `CompactSchedule::NO_RING` if there is none.
  */
-JsonArray ScheduleManager::getRemainingRingTimes() {
-    String dayOfWeek = dayOfWeekStr(timeManager.getDayOfWeek());
-    String currentTime = timeManager.getTime();
-    JsonArray result = currentSchedule.createNestedArray("temp"); // Temp array for results
+uint16_t ScheduleManager::dueRing(uint16_t fromMinute, uint16_t currentMinute) {
+    uint16_t nextRing = nextRingInDay(todayTable().bits, fromMinute);
+    return nextRing <= currentMinute ? nextRing : CompactSchedule::NO_RING;
+}
 
-    if (currentSchedule.containsKey(dayOfWeek)) {
-        JsonArray timesArray = currentSchedule[dayOfWeek].as<JsonArray>();
-        for (JsonVariant v : timesArray) {
-            String ringTime = v.as<String>();
-            if (ringTime > currentTime) {
-                result.add(ringTime);
-            }
+/**
+ * The function `activeProfile` returns the profile that is active today. The profile is resolved
+ * when today's rings are read, not on every ring check.
+ * 
+ * @return The index of the active profile, or `CompactSchedule::NO_PROFILE` if there are no profiles.
+ */
+uint8_t ScheduleManager::activeProfile() {
+    return todayTable().profile;
+}
+
+/**
+ * The function `profileForDay` returns the profile that is active on a given day: the one selected by
+ * the user, otherwise the one whose date range matches.
+ */
+uint8_t ScheduleManager::profileForDay(uint16_t day) {
+    if (manualProfile < store.profileCount()) {
+        return manualProfile;
+    }
+    return store.resolveProfile(day);
+}
+
+/**
+ * The function `todayTable` returns today's rings. After midnight the table prefetched for tomorrow is
+ * used, so the first rings of the day do not wait for flash; otherwise the table is read now.
+ */
+const DayTable& ScheduleManager::todayTable() {
+    uint16_t day = timeManager.getDayNumber();
+    if (todayRings.day != day) {
+        if (tomorrowRings.day == day) {
+            todayRings = tomorrowRings;
+            tomorrowRings.day = 0;
+        } else {
+            buildDayTable(todayRings, day);
         }
     }
+    return todayRings;
+}
 
-    return result;
+/**
+ * The function `buildDayTable` reads the rings of the profile active on a day from flash.
+ * 
+ * @param table The table to fill.
+ * @param day Day number (days since 1970-01-01) in local time.
+ */
+void ScheduleManager::buildDayTable(DayTable& table, uint16_t day) {
+    table.profile = profileForDay(day);
+    memset(table.bits, 0, sizeof(table.bits));
+    if (table.profile != CompactSchedule::NO_PROFILE) {
+        store.loadDay(table.profile, weekdayOf(day), table.bits);
+    }
+    table.day = day;
 }
 
+/**
+ * The function `invalidateDays` drops both day tables after the schedule or the selected profile
+ * changed, today's rings are read again on the next check.
+ */
+void ScheduleManager::invalidateDays() {
+    version++;
+    todayRings.day = 0;
+    tomorrowRings.day = 0;
+}
 
 /**
- * The function `sortScheduleTimes` sorts the times in each day's schedule in ascending order.
+ * The function `nextRingInDay` finds the first ring at or after a minute in a day's ring bitmap. Whole
+ * bytes without rings are skipped.
  * 
- * @param schedule The `sortScheduleTimes` function takes a `DynamicJsonDocument` reference named
- * `schedule` as a parameter. This `schedule` parameter is expected to contain a JSON object
- * representing a schedule with days as keys and an array of times as values. The function iterates
- * over each key-value pair in
+ * @return The minute of the day of the ring, or `CompactSchedule::NO_RING` if there are no more rings.
  */
-void ScheduleManager::sortScheduleTimes(DynamicJsonDocument& schedule) {
-    for (JsonPair kv : schedule.as<JsonObject>()) {
-        String day = kv.key().c_str();
-        JsonArray times = kv.value().as<JsonArray>();
+uint16_t ScheduleManager::nextRingInDay(const uint8_t* bits, uint16_t fromMinute) {
+    for (uint16_t minute = fromMinute; minute < 1440; minute++) {
+        if (minute % 8 == 0 && bits[minute / 8] == 0) {
+            minute += 7;
+            continue;
+        }
+        if (bits[minute / 8] & (1 << (minute % 8))) {
+            return minute;
+        }
+    }
+    return CompactSchedule::NO_RING;
+}
 
-        // Create a temporary std::vector for sorting
-        std::vector<String> sortedTimes;
-        for (JsonVariant v : times) {
-            sortedTimes.push_back(v.as<String>());
+/**
+ * The function `weekdayOf` returns the day of the week of a day number, 1 = Sunday through 7 = Saturday.
+ * 1970-01-01 was a Thursday.
+ */
+uint8_t ScheduleManager::weekdayOf(uint16_t day) {
+    return (day + 4) % 7 + 1;
+}
+
+/**
+ * The function `compileDays` validates a single week schedule and encodes it as compact ring code.
+ * 
+ * @param schedule JSON object with the days of the week as keys and arrays of "HH:MM" times as values.
+ * @param code Output buffer for the ring code.
+ * 
+ * @return `false` if the schedule does not pass validation.
+ */
+bool ScheduleManager::compileDays(JsonObject schedule, std::vector<uint8_t>& code) {
+    if (schedule.isNull() || !validateSchedule(schedule)) {
+        return false;
+    }
+
+    std::vector<uint16_t> days[7];
+    for (int day = 1; day <= 7; day++) {
+        String name = dayOfWeekStr(day);
+        if (!schedule.containsKey(name)) continue;
+
+        for (JsonVariant v : schedule[name].as<JsonArray>()) {
+            days[day - 1].push_back(parseTime(v.as<String>()));
+        }
+    }
+
+    CompactSchedule::encodeDays(days, code);
+
+    // Recurring rules are compiled as is, they are never expanded into ring times
+    if (schedule.containsKey("rules")) {
+        for (JsonObject rule : schedule["rules"].as<JsonArray>()) {
+            if (!compileRule(rule, code)) {
+                return false;
+            }
         }
+    }
+    return true;
+}
+
+/**
+ * The function `compileRule` validates a recurring ring rule and appends it to ring code. A rule
+ * looks like {"every":50, "from":"08:00", "to":"15:00", "days":"weekdays", "plus":[5]}, which rings
+ * every 50 minutes from 08:00 up to 15:00 Monday to Friday, and again 5 minutes after each of those.
+ * 
+ * @param rule JSON object describing the rule. "days" can be "daily", "weekdays", "weekends" or an
+ * array of day names, and "plus" is optional.
+ * @param code Output buffer for the ring code.
+ * 
+ * @return `false` if the rule is invalid.
+ */
+bool ScheduleManager::compileRule(JsonObject rule, std::vector<uint8_t>& code) {
+    String from = rule["from"].as<String>();
+    String to = rule["to"].as<String>();
+    int every = rule["every"] | 0;
+    if (!isValidTimeFormat(from) || !isValidTimeFormat(to) || every < 1 || every > 255) {
+        return false;
+    }
 
-        // Sort the std::vector
-        std::sort(sortedTimes.begin(), sortedTimes.end());
+    RingRule ringRule;
+    ringRule.days = parseDays(rule["days"]);
+    ringRule.from = parseTime(from);
+    ringRule.to = parseTime(to);
+    ringRule.every = every;
 
-        // Clear the original JsonArray and repopulate it with sorted times
-        times.clear();
-        for (const String& time : sortedTimes) {
-            times.add(time);
+    for (JsonVariant v : rule["plus"].as<JsonArray>()) {
+        int delta = v.as<int>();
+        if (delta < -120 || delta > 120 || delta == 0) {
+            return false;
         }
+        ringRule.plus.push_back(delta);
     }
+
+    return CompactSchedule::encodeRule(ringRule, code);
+}
+
+/**
+ * The function `parseDays` converts the "days" of a rule to a weekday mask (bit 0 = Sunday).
+ * 
+ * @param days Either "daily", "weekdays", "weekends", or an array of day names.
+ * 
+ * @return The weekday mask, 0 if no valid day was given.
+ */
+uint8_t ScheduleManager::parseDays(JsonVariant days) {
+    if (days.is<const char*>()) {
+        String name = days.as<String>();
+        if (name == "daily") return 0x7F;
+        if (name == "weekdays") return 0x3E;
+        if (name == "weekends") return 0x41;
+        return 0;
+    }
+
+    uint8_t mask = 0;
+    for (JsonVariant v : days.as<JsonArray>()) {
+        String name = v.as<String>();
+        for (int day = 1; day <= 7; day++) {
+            if (name == dayOfWeekStr(day)) mask |= 1 << (day - 1);
+        }
+    }
+    return mask;
+}
+
+/**
+ * The function `parseDate` converts a "YYYY-MM-DD" string to a day number.
+ * 
+ * @return `false` if the string is not a valid date.
+ */
+bool ScheduleManager::parseDate(const String& date, uint16_t& dayNumber) {
+    if (date.length() != 10 || date[4] != '-' || date[7] != '-') return false;
+    int year = date.substring(0, 4).toInt();
+    int month = date.substring(5, 7).toInt();
+    int day = date.substring(8, 10).toInt();
+    if (year < 1971 || year > 2148 || month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+    dayNumber = CompactSchedule::dayNumber(year, month, day);
+    return true;
+}
+
+/**
+ * The function `formatDate` converts a day number back to a "YYYY-MM-DD" string.
+ */
+String ScheduleManager::formatDate(uint16_t dayNumber) {
+    int year, month, day;
+    CompactSchedule::dayNumberToDate(dayNumber, year, month, day);
+    char buffer[11];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, day);
+    return String(buffer);
+}
+
+/**
+ * The function `parseTime` converts a "HH:MM" string to the minute of the day. The string is expected
+ * to have passed `isValidTimeFormat`.
+ */
+uint16_t ScheduleManager::parseTime(const String& time) {
+    return time.substring(0, 2).toInt() * 60 + time.substring(3, 5).toInt();
+}
+
+/**
+ * The function `formatTime` converts a minute of the day to a "HH:MM" string.
+ */
+String ScheduleManager::formatTime(uint16_t minute) {
+    char buffer[6];
+    snprintf(buffer, sizeof(buffer), "%02d:%02d", minute / 60, minute % 60);
+    return String(buffer);
 }
 
 
@@ -227,7 +969,7 @@ String ScheduleManager::dayOfWeekStr(int day) {
  * The function `validateSchedule` checks if a given schedule JSON object contains valid time entries
  * for each day of the week.
  * 
- * @param schedule The `validateSchedule` function takes a `DynamicJsonDocument` object named
+ * @param schedule The `validateSchedule` function takes a `JsonObject` named
  * `schedule` as a parameter. This object is expected to contain schedules for each day of the week,
  * where the keys are the names of the days ("monday", "tuesday", etc.) and the corresponding values
  * are
@@ -236,7 +978,7 @@ String ScheduleManager::dayOfWeekStr(int day) {
  * passes all validation checks, and `false` if any validation check fails during the iteration over
  * the days of the week and their corresponding times.
  */
-bool ScheduleManager::validateSchedule(DynamicJsonDocument& schedule) {
+bool ScheduleManager::validateSchedule(JsonObject schedule) {
     const char* daysOfWeek[] = {"monday", "tuesday", "wednesday", "thursday", "friday", "saturday", "sunday"};
     
     for (const char* day : daysOfWeek) {
@@ -280,17 +1022,109 @@ bool ScheduleManager::isValidTimeFormat(const String& time) {
 
 
 /**
- * The function `loadScheduleFromEEPROM` loads a ring schedule from EEPROM, deserializes it into a JSON
- * object, and prints the loaded schedule.
+ * The function `importCsvLine` parses one row of a CSV import and sets its ring in the bitmap of its
+ * profile. The first error is kept in the import state and stops the import.
+ * 
+ * @param line The row without its line break, it is modified while being split into fields.
  */
-void ScheduleManager::loadScheduleFromEEPROM() {
-    String schedule = eepromManager.loadRingSchedule();
+void ScheduleManager::importCsvLine(char* line) {
+    csvImport->lineNumber++;
+    String where = "Line " + String(csvImport->lineNumber) + ": ";
+
+    // Split into at most three fields, dropping white space and quotes around each
+    char* fields[3];
+    uint8_t count = 0;
+    char* field = line;
+    while (field && count < 3) {
+        char* next = strchr(field, ',');
+        if (next) *next++ = '\0';
+
+        while (*field == ' ' || *field == '\t' || *field == '"') field++;
+        char* end = field + strlen(field);
+        while (end > field && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '"')) end--;
+        *end = '\0';
+
+        fields[count++] = field;
+        field = next;
+    }
 
-    if (schedule.length() > 0 && schedule[0] != char(0xFF)) {
-        // Clear the current schedule object
-        currentSchedule.clear();
+    if ((count == 1 && fields[0][0] == '\0') || fields[0][0] == '#') {
+        return; // Empty line or comment
+    }
+    if (count < 3 || field) {
+        csvImport->error = where + "expected profile,day,time";
+        return;
+    }
+    if (strcasecmp(fields[0], "profile") == 0) {
+        return; // Header row
+    }
 
-        // Deserialize the JSON string into the currentSchedule object
-        deserializeJson(currentSchedule, schedule);
+    String name = fields[0];
+    if (name.length() == 0 || name.length() > CompactSchedule::MAX_NAME_LENGTH) {
+        csvImport->error = where + "profile name must be 1 to " + String(CompactSchedule::MAX_NAME_LENGTH) + " characters";
+        return;
     }
-}
\ No newline at end of file
+
+    int day = 0;
+    for (int d = 1; d <= 7 && day == 0; d++) {
+        String dayName = dayOfWeekStr(d);
+        if (strcasecmp(fields[1], dayName.c_str()) == 0 || (strlen(fields[1]) == 3 && strncasecmp(fields[1], dayName.c_str(), 3) == 0)) {
+            day = d;
+        }
+    }
+    if (day == 0) {
+        csvImport->error = where + "unknown day " + String(fields[1]);
+        return;
+    }
+
+    String time = fields[2];
+    if (time.length() == 4) time = "0" + time;
+    if (!isValidTimeFormat(time)) {
+        csvImport->error = where + "invalid time " + String(fields[2]);
+        return;
+    }
+    uint16_t minute = parseTime(time);
+
+    // Find or add the profile
+    size_t profile = 0;
+    while (profile < csvImport->names.size() && csvImport->names[profile] != name) profile++;
+    if (profile == csvImport->names.size()) {
+        if (profile == CsvImport::MAX_PROFILES) {
+            csvImport->error = where + "more than " + String(CsvImport::MAX_PROFILES) + " profiles";
+            return;
+        }
+        csvImport->names.push_back(name);
+        csvImport->rings.emplace_back(7 * CompactSchedule::DAY_BYTES, 0);
+    }
+
+    uint8_t& bits = csvImport->rings[profile][(day - 1) * CompactSchedule::DAY_BYTES + minute / 8];
+    if (!(bits & (1 << (minute % 8)))) {
+        bits |= 1 << (minute % 8);
+        csvImport->ringCount++;
+    }
+}
+
+/**
+ * The function `migrateFromEEPROM` moves a schedule saved in EEPROM by older firmware to the store on
+ * LittleFS. A compact schedule is copied profile by profile, a JSON schedule is compiled into a
+ * "default" profile. The EEPROM area is left as it was.
+ */
+void ScheduleManager::migrateFromEEPROM() {
+    std::vector<uint8_t> buffer(CompactSchedule::MAX_SIZE);
+    size_t length = eepromManager.loadCompactSchedule(buffer.data(), buffer.size());
+
+    CompactSchedule schedule;
+    if (schedule.load(buffer.data(), length)) {
+        if (schedule.profileCount() > 0 && store.replaceProfiles(schedule)) {
+            eepromManager.addSystemMessage("Schedule moved from EEPROM to LittleFS.");
+        }
+        return;
+    }
+
+    String legacy = eepromManager.loadRingSchedule();
+    DynamicJsonDocument legacySchedule(4096);
+    if (legacy.length() > 0 && legacy[0] == '{' && !deserializeJson(legacySchedule, legacy) &&
+        updateProfile("default", legacySchedule.as<JsonObject>(), "", "")) {
+        eepromManager.addSystemMessage("Schedule moved from EEPROM to LittleFS.");
+    }
+}
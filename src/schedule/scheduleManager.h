@@ -1,37 +1,114 @@
 /*
 Quinton Nelson
 3/22/2024
-This file handles reading a schedule from the client, saving it to EEPROM, and checking if the bell should ring
+This file handles reading a schedule from the client, saving it to LittleFS, and checking if the bell should ring
 */
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <memory>
 
 #include "TimeManager.h"
+#include "CompactSchedule.h"
+#include "ScheduleStoreManager.h"
 #include "../board/RelayManager.h"
 #include "../board/EEPROMLayoutManager.h"
+#include "../board/ArenaManager.h"
 
 // Global objects initialized in main.cpp
 extern EEPROMLayoutManager eepromManager;
 extern TimeManager timeManager;
 extern RelayManager relayManager;
 
+// State of a CSV import in progress, only allocated while a file is being received
+struct CsvImport {
+    static constexpr uint8_t MAX_LINE = 64;
+    static constexpr uint8_t MAX_PROFILES = 8; // One week bitmap of 1260 bytes each, about 10 KB at most
+
+    std::vector<String> names; // Profiles named in the file
+    std::vector<std::vector<uint8_t>> rings; // 7 * CompactSchedule::DAY_BYTES ring bitmap per profile
+    char line[MAX_LINE + 1]; // Partial line carried over between chunks
+    uint8_t lineLength;
+    uint32_t lineNumber;
+    uint32_t ringCount;
+    String error;
+};
+
+// Rings of one day, only today's and tomorrow's are kept in RAM
+struct DayTable {
+    uint16_t day; // Day number the table was built for, 0 if it is not built
+    uint8_t profile; // Profile active on that day
+    uint8_t bits[CompactSchedule::DAY_BYTES]; // One bit per minute of the day
+};
+
 class ScheduleManager {
     public:
         ScheduleManager();
-        String getScheduleString();
+        void begin();
+        String getScheduleString(const String& profileName = "");
+        bool getSchedule(const String& profileName, JsonDocument& schedule, bool compact = false);
+        void getProfiles(JsonDocument& doc);
+        String getScheduleETag(const String& profileName = "");
+        uint32_t getScheduleHash();
         String getTodayRemainingRingTimes();
+        void getTodayRemainingRings(std::vector<uint16_t>& minutes);
+        uint16_t getNextRingMinute();
         void handleRing();
-        bool updateSchedule(const String& jsonSchedule);
+        bool updateSchedule(JsonObject schedule);
+        bool updateProfile(const String& name, JsonObject schedule, const String& startDate, const String& endDate);
+        bool setActiveProfile(const String& name);
+        bool deleteProfile(const String& name);
+        void beginCsvImport();
+        void importCsvChunk(const uint8_t* data, size_t length);
+        bool finishCsvImport(String& result);
+        void abortCsvImport();
+        void exportCsv(Print& out, const String& profileName = "");
+        int32_t getLastRingLateness();
+        int32_t getMaxRingLateness();
+        int32_t getAverageRingLateness();
+        uint32_t getRingCount();
+        uint32_t getVersion();
+        uint32_t getSecondsToNextRing();
+        uint32_t getSecondsSinceRing();
+
+        static constexpr uint32_t NO_RING_SECONDS = 0xFFFFFFFF; // No ring to measure from
+        uint8_t getManualProfile();
+        void getLastCheck(uint16_t& day, uint16_t& minute);
+        void restoreState(uint8_t manual, uint16_t lastDay, uint16_t lastMinute);
     private:
-        bool shouldRingNow();
-        JsonArray getRemainingRingTimes();
-        void sortScheduleTimes(DynamicJsonDocument& schedule);
+        static constexpr uint16_t PREFETCH_MINUTE = 23 * 60; // Tomorrow's rings are read from flash after 23:00
+
+        void checkRings(uint16_t today, uint16_t currentMinute);
+        uint16_t dueRing(uint16_t fromMinute, uint16_t currentMinute);
+        uint8_t activeProfile();
+        uint8_t profileForDay(uint16_t day);
+        const DayTable& todayTable();
+        void buildDayTable(DayTable& table, uint16_t day);
+        void invalidateDays();
+        static uint16_t nextRingInDay(const uint8_t* bits, uint16_t fromMinute);
+        static uint8_t weekdayOf(uint16_t day);
+        bool compileDays(JsonObject schedule, std::vector<uint8_t>& code);
+        bool compileRule(JsonObject rule, std::vector<uint8_t>& code);
+        uint8_t parseDays(JsonVariant days);
+        bool parseDate(const String& date, uint16_t& dayNumber);
+        String formatDate(uint16_t dayNumber);
+        uint16_t parseTime(const String& time);
+        String formatTime(uint16_t minute);
         String dayOfWeekStr(int day);
-        void loadScheduleFromEEPROM();
-        DynamicJsonDocument currentSchedule;
-        bool validateSchedule(DynamicJsonDocument& schedule);
+        void migrateFromEEPROM();
+        ScheduleStoreManager store;
+        DayTable todayRings;
+        DayTable tomorrowRings; // Prefetched before midnight
+        bool validateSchedule(JsonObject schedule);
         bool isValidTimeFormat(const String& time);
-        unsigned long lastRingTimeMillies;
-        unsigned long ringInterval;
+        void importCsvLine(char* line);
+        std::unique_ptr<CsvImport> csvImport;
+        uint8_t manualProfile; // Profile selected by the user, NO_PROFILE to select by date
+        uint16_t lastCheckedDay; // Day of the last ring check
+        uint16_t lastCheckedMinute; // Minute of the day of the last ring check
+        int32_t lastRingLateness; // How late the last ring was against its scheduled second (ms)
+        int32_t maxRingLateness;
+        int64_t totalRingLateness;
+        uint32_t ringCount;
+        uint32_t version; // Changes whenever the rings may have changed
 };
\ No newline at end of file
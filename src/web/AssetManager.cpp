@@ -0,0 +1,119 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the web files that are compiled into the firmware. The archive and its table are
+generated from data/ before every build, see tools/packassets/packassets.py.
+*/
+
+#include "AssetManager.h"
+
+#include <algorithm>
+
+#include "AssetArchive.h"
+
+AssetManager::AssetManager() {}
+
+/**
+ * The `begin` function builds the index of the archive. The hash of every path is computed once and kept
+ * in RAM sorted by value, the paths, contents and ETags stay in flash.
+ */
+void AssetManager::begin() {
+    slots.clear();
+    slots.reserve(ASSET_COUNT);
+    for (uint8_t entry = 0; entry < ASSET_COUNT; entry++) {
+        slots.push_back({hashPath(readEntry(entry).path, true), entry});
+    }
+
+    std::sort(slots.begin(), slots.end(), [](const Slot& a, const Slot& b) {
+        return a.pathHash < b.pathHash;
+    });
+}
+
+uint8_t AssetManager::count() const {
+    return slots.size();
+}
+
+/**
+ * The function `findAsset` looks a path up in the archive without touching the file system.
+ *
+ * @param path Request path, e.g. "/script/index.js".
+ * @param asset Receives the location of the contents in flash, their length, MIME type and ETag.
+ *
+ * @return `false` if the archive has no file with that path.
+ */
+bool AssetManager::findAsset(const String& path, Asset& asset) const {
+    uint32_t pathHash = hashPath(path.c_str(), false);
+    auto slot = std::lower_bound(slots.begin(), slots.end(), pathHash, [](const Slot& a, uint32_t value) {
+        return a.pathHash < value;
+    });
+
+    // Different paths may share a hash, so every slot with the hash is checked
+    for (; slot != slots.end() && slot->pathHash == pathHash; ++slot) {
+        AssetEntry entry = readEntry(slot->entry);
+        if (strcmp_P(path.c_str(), entry.path) == 0) {
+            asset.data = assetData + entry.offset;
+            asset.length = entry.length;
+            asset.mimeType = entry.mimeType;
+            asset.etag = entry.etag;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * The function `readAsset` copies a file of the archive into a string, for pages whose placeholders are
+ * filled in before they are sent.
+ *
+ * @param path Path of the file, e.g. "/index.html".
+ * @param content Receives the contents.
+ *
+ * @return `false` if the file is not in the archive or does not fit in memory.
+ */
+bool AssetManager::readAsset(const String& path, String& content) const {
+    Asset asset;
+    if (!findAsset(path, asset)) {
+        return false;
+    }
+
+    content = String();
+    if (!content.reserve(asset.length)) {
+        return false;
+    }
+
+    char buffer[64];
+    for (uint32_t position = 0; position < asset.length; position += sizeof(buffer)) {
+        size_t length = std::min<uint32_t>(sizeof(buffer), asset.length - position);
+        memcpy_P(buffer, asset.data + position, length);
+        content.concat(buffer, length);
+    }
+    return true;
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `hashPath` computes the FNV-1a hash of a path.
+ *
+ * @param path The path.
+ * @param progmem `true` if the path is stored in flash.
+ */
+uint32_t AssetManager::hashPath(const char* path, bool progmem) {
+    uint32_t result = 2166136261UL;
+    for (;; path++) {
+        uint8_t c = progmem ? pgm_read_byte(path) : *path;
+        if (c == 0) {
+            return result;
+        }
+        result = (result ^ c) * 16777619UL;
+    }
+}
+
+/**
+ * The function `readEntry` copies an entry of the archive table out of flash.
+ */
+AssetEntry AssetManager::readEntry(uint8_t entry) {
+    AssetEntry result;
+    memcpy_P(&result, &assetEntries[entry], sizeof(result));
+    return result;
+}
@@ -0,0 +1,53 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the web files that are compiled into the firmware. The files in data/ are packed into
+one read-only archive in flash at build time (tools/packassets), and an index built once at boot finds
+them by path, so static requests need no LittleFS calls and no file handles.
+*/
+
+#ifndef AssetManager_h
+#define AssetManager_h
+
+#include <Arduino.h>
+#include <vector>
+
+// Archive entry as generated by tools/packassets/packassets.py, stored in flash
+struct AssetEntry {
+    const char* path; // PROGMEM
+    const char* mimeType; // PROGMEM
+    uint32_t offset; // Offset of the contents in the archive, 4 byte aligned
+    uint32_t length;
+    uint32_t etag; // FNV-1a hash of the contents
+};
+
+// A file found in the archive
+struct Asset {
+    const uint8_t* data; // PROGMEM
+    uint32_t length;
+    const char* mimeType; // PROGMEM
+    uint32_t etag;
+};
+
+class AssetManager {
+public:
+    AssetManager();
+    void begin();
+    uint8_t count() const;
+    bool findAsset(const String& path, Asset& asset) const;
+    bool readAsset(const String& path, String& content) const;
+
+private:
+    // Index slot kept in RAM, sorted by hash so a lookup is a binary search plus one path compare
+    struct Slot {
+        uint32_t pathHash;
+        uint8_t entry;
+    };
+
+    static uint32_t hashPath(const char* path, bool progmem);
+    static AssetEntry readEntry(uint8_t entry);
+
+    std::vector<Slot> slots;
+};
+
+#endif
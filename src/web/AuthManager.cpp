@@ -80,8 +80,9 @@ bool AuthManager::updatePassword(const String &newPassword) {
  * @return The `generateToken` function returns the current token that is generated after combining
  * random data, current timestamp, and salt, and then hashing the combined data.
  */
-String AuthManager::generateToken() {
-    String tokenData = String(micros()) + String(random(0, INT32_MAX)) + _salt;
+const String& AuthManager::generateToken() {
+    char tokenData[64];
+    snprintf(tokenData, sizeof(tokenData), "%lu%ld%s", micros(), random(0, INT32_MAX), _salt.c_str());
     _tokenTimestamp = millis();
     _currentToken = hashToken(tokenData);
     return _currentToken;
@@ -99,6 +100,47 @@ bool AuthManager::checkToken(const String &token) {
     return token == _currentToken && isTokenValid();
 }
 
+/**
+ * The state getters expose what `RestartManager` keeps in RTC memory across a planned restart, so the
+ * password does not have to be loaded again and the user stays logged in.
+ */
+String AuthManager::getPasswordHash() {
+    return _encryptedPassword;
+}
+
+String AuthManager::getSalt() {
+    return _salt;
+}
+
+String AuthManager::getToken() {
+    return isTokenValid() ? _currentToken : String();
+}
+
+unsigned long AuthManager::getTokenRemaining() {
+    return isTokenValid() ? _tokenValidityPeriod - (millis() - _tokenTimestamp) : 0;
+}
+
+/**
+ * The function `restoreState` restores the authentication state from a warm restart snapshot instead of
+ * loading it from EEPROM with `initialize`.
+ * 
+ * @param passwordHash The salted password hash as a hex string.
+ * @param salt The salt of the password hash.
+ * @param token The token that was valid before the restart, or an empty string.
+ * @param tokenRemaining How long the token stays valid, in milliseconds.
+ */
+void AuthManager::restoreState(const String &passwordHash, const String &salt, const String &token, unsigned long tokenRemaining) {
+    _encryptedPassword = passwordHash;
+    _salt = salt;
+    _initialized = true;
+    _currentToken = token;
+    _tokenTimestamp = millis() - (_tokenValidityPeriod - tokenRemaining);
+
+    if (checkPassword("admin")) {
+        eepromManager.addSystemMessage("Default password detected. Change the default password as soon as possible.");
+    }
+}
+
 
 /****************PRIVATE******************/
 
@@ -141,44 +183,50 @@ String AuthManager::generateSalt(size_t length) {
 String AuthManager::hashPasswordWithSalt(const String &password, const String &salt) {
     br_sha256_context mc;
     br_sha256_init(&mc);
-    String saltedPassword = salt + password; // Prepend
-    br_sha256_update(&mc, saltedPassword.c_str(), saltedPassword.length());
+    br_sha256_update(&mc, salt.c_str(), salt.length()); // Prepend the salt
+    br_sha256_update(&mc, password.c_str(), password.length());
     unsigned char hash[br_sha256_SIZE];
     br_sha256_out(&mc, hash);
-
-    String result = "";
-    for (size_t i = 0; i < sizeof(hash); i++) {
-        if (hash[i] < 16) result += "0";
-        result += String(hash[i], HEX);
-    }
-    return result;
+    return hexString(hash);
 }
 
 /**
  * The `hashToken` function in C++ calculates the SHA-256 hash of the input data and returns it as a
  * hexadecimal string.
  * 
- * @param data The `hashToken` function takes a `String` reference named `data` as input. This `data`
+ * @param data The `hashToken` function takes a NUL terminated string named `data` as input. This `data`
  * parameter represents the data that needs to be hashed using the SHA-256 algorithm. The function
  * calculates the SHA-256 hash of the input data and returns the hashed result as a `String
  * 
  * @return The `hashToken` function returns a hashed token generated from the input data using the
  * SHA-256 algorithm. The hashed token is represented as a string of hexadecimal characters.
  */
-String AuthManager::hashToken(const String &data) {
+String AuthManager::hashToken(const char* data) {
     br_sha256_context mc;
     br_sha256_init(&mc);
-    br_sha256_update(&mc, data.c_str(), data.length());
+    br_sha256_update(&mc, data, strlen(data));
     unsigned char hash[br_sha256_SIZE];
     br_sha256_out(&mc, hash);
+    return hexString(hash);
+}
 
-    String result;
-    for (size_t i = 0; i < sizeof(hash); i++) {
-        char buf[3];
-        sprintf(buf, "%02x", (unsigned int)hash[i]);
-        result += String(buf);
+/**
+ * The function `hexString` formats a SHA-256 hash as 64 lower case hex digits. The digits are written
+ * into a buffer on the stack, so the only heap allocation is the returned string.
+ * 
+ * @param hash The hash, br_sha256_SIZE bytes.
+ * 
+ * @return The hash as a hex string.
+ */
+String AuthManager::hexString(const unsigned char* hash) {
+    static const char digits[] = "0123456789abcdef";
+    char result[br_sha256_SIZE * 2 + 1];
+    for (size_t i = 0; i < br_sha256_SIZE; i++) {
+        result[i * 2] = digits[hash[i] >> 4];
+        result[i * 2 + 1] = digits[hash[i] & 0x0F];
     }
-    return result;
+    result[br_sha256_SIZE * 2] = 0;
+    return String(result);
 }
 
 /**
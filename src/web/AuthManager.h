@@ -27,15 +27,21 @@ class AuthManager {
     String hashPasswordWithSalt(const String &password, const String &salt); // Hashes the password with the salt
     String generateSalt(size_t length); // Generates a random salt
     bool isTokenValid(); // Checks if the current token is still valid
-    String hashToken(const String &data); // Hashes the data
+    String hashToken(const char* data); // Hashes the data
+    static String hexString(const unsigned char* hash); // Formats a SHA-256 hash as hex
 
   public:
     AuthManager();
     bool initialize();
     bool checkPassword(const String &password);
     bool updatePassword(const String &newPassword);
-    String generateToken();
+    const String& generateToken();
     bool checkToken(const String &token);
+    String getPasswordHash();
+    String getSalt();
+    String getToken();
+    unsigned long getTokenRemaining();
+    void restoreState(const String &passwordHash, const String &salt, const String &token, unsigned long tokenRemaining);
 };
 
 #endif
@@ -9,23 +9,41 @@ Sending all necessary files and data to the client at once is not feasible, so t
 #include "Endpoints.h"
 
 #include <ArduinoJson.h>
-#include <LittleFS.h>
 #include <ezTime.h>
 
 #include "board/EEPROMLayoutManager.h"
 #include "schedule/TimeManager.h"
+#include "schedule/NTPManager.h"
+#include "board/RestartManager.h"
+#include "network/NetworkManager.h"
+#include "network/ConfigSyncManager.h"
+#include "network/LanSyncManager.h"
 #include "schedule/scheduleManager.h"
 #include "board/RelayManager.h"
+#include "board/ArenaManager.h"
+#include "board/TaskManager.h"
+#include "board/PowerManager.h"
+#include "schedule/RingGuardManager.h"
 #include "web/AuthManager.h"
+#include "web/AssetManager.h"
+#include "web/RouteManager.h"
+#include "web/ResponseCacheManager.h"
 
 // Global objects that are defined in main.cpp
 extern EEPROMLayoutManager eepromManager; // EEPROM manager object
 extern const int relayPin; // Pin for the relay module (GPIO5)
-extern ESP8266WebServer server; // HTTP server object
+extern WebServerManager server; // HTTP and HTTPS servers
 extern RelayManager relayManager; // Relay manager object
 extern TimeManager timeManager; // Time manager object
+extern NTPManager ntpManager; // NTP synchronization object
+extern RestartManager restartManager; // Planned restarts
+extern NetworkManager networkManager; // Wi-Fi supervisor
+extern ConfigSyncManager configSyncManager; // Config server pull
+extern LanSyncManager lanSyncManager; // Synchronized ringing on the LAN
+extern unsigned long bootMillis; // Time from power on until setup finished
 extern ScheduleManager scheduleManager; // Schedule manager object
 extern AuthManager authManager; // Authentication manager object
+extern AssetManager assetManager; // Web files compiled into the firmware
 
 
 extern String deviceName; // Device name
@@ -34,337 +52,833 @@ extern int ringDuration; // Ring duration in seconds
 
 
 
-void setupEndpoints() {
-    /*************************Schedule Page*************************************/
-
-    server.on("/getSchedule", HTTP_GET, []() {
-        // Ensure no caching for dynamic content
-        server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-        server.sendHeader("Pragma", "no-cache");
-        server.sendHeader("Expires", "-1");
-
-        String scheduleJson = scheduleManager.getScheduleString(); // Get the schedule as a string
-        server.send(200, "application/json", scheduleJson);
-    });
-
-
-
-    server.on("/updateSchedule", HTTP_POST, []() {
-        String providedToken = server.header("Authorization");
-
-        if (!authManager.checkToken(providedToken)) {
-            server.send(401, "text/plain", "Unauthorized");
-            return;
-        }
-
-        // Check if the request has a body (raw POST data)
-        if (server.hasArg("plain") == false) { // Use "plain" for raw POST body
-            server.send(400, "text/plain", "No schedule data received");
-            return;
-        }
+/**
+ * The function `etagMatches` checks an If-Match or If-None-Match header against an entity tag. The
+ * header may be "*" or a comma separated list of tags, weak tags (W/"...") are compared by their value.
+ *
+ * @param header Value of the request header.
+ * @param etag The current entity tag, including its quotes.
+ *
+ * @return `true` if the header names the tag or is "*".
+ */
+static bool etagMatches(const String& header, const String& etag) {
+    if (header.length() == 0) {
+        return false;
+    }
+    return header == "*" || header.indexOf(etag) >= 0;
+}
+
+/**
+ * The function `representationETag` returns the entity tag of the MessagePack form of a response whose
+ * JSON form has the tag `etag`. The two forms have different bytes, so they must not share a strong tag.
+ *
+ * @param etag Tag of the JSON form, including its quotes.
+ * @param msgPack `true` for the MessagePack form.
+ *
+ * @return `etag` for JSON, or the tag with "-m" added inside the quotes for MessagePack.
+ */
+static String representationETag(const String& etag, bool msgPack) {
+    return msgPack ? etag.substring(0, etag.length() - 1) + "-m\"" : etag;
+}
+
+/**
+ * The function `sendAsset` sends a file of the compiled in web archive straight from flash. The ETag is
+ * the hash of the contents, so browsers revalidate with If-None-Match and get a 304 until the firmware
+ * is updated with changed files.
+ *
+ * @param path Path of the file in data/, e.g. "/script/index.js".
+ */
+void sendAsset(const char* path) {
+    Asset asset;
+    if (!assetManager.findAsset(path, asset)) {
+        server.send(404, "text/plain", "Not found");
+        return;
+    }
+
+    char etag[11];
+    snprintf(etag, sizeof(etag), "\"%08x\"", (unsigned int)asset.etag);
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if (etagMatches(server.header("If-None-Match"), etag)) {
+        server.send(304);
+        return;
+    }
+
+    server.send_P(200, asset.mimeType, (PGM_P)asset.data, asset.length);
+}
+
+/**
+ * The function `acceptsMsgPack` checks whether the client asked for MessagePack instead of JSON.
+ *
+ * @return `true` if the Accept header lists application/msgpack.
+ */
+static bool acceptsMsgPack() {
+    return server.header("Accept").indexOf("application/msgpack") >= 0;
+}
 
-        // Getting the raw POST data
-        String schedule = server.arg("plain");
-        DynamicJsonDocument doc(4096); // Create a JSON document to store the schedule with a capacity of 8192 bytes
-        DeserializationError error = deserializeJson(doc, schedule);
-        
-        if (error) { // Check for errors in parsing
-            server.send(500, "text/plain", "Error parsing JSON");
-            return;
-        }
+/*
+A Print that collects output in a small buffer and sends every full buffer as one piece of the response,
+so large responses are streamed without building them in memory or sending tiny TCP segments. The output
+can also be copied into the response cache while it is sent.
+*/
+class ContentPrint : public Print {
+public:
+    explicit ContentPrint(uint8_t* capture = nullptr) : capture(capture) {}
 
-        // Serialize JSON to String and save it
-        if (scheduleManager.updateSchedule(schedule)) {
-            server.send(200, "text/plain", "Schedule saved successfully");
-        } else {
-            server.send(500, "text/plain", "Failed to save schedule");
+    size_t write(uint8_t c) override {
+        if (capture != nullptr) {
+            *capture++ = c;
         }
-    });
-
-    server.on("/script/schedule.js", HTTP_GET, []() {
-        File file = LittleFS.open("/script/schedule.js", "r");
-        if (!file) {
-            return;
+        buffer[length++] = c;
+        if (length == sizeof(buffer)) {
+            flush();
         }
+        return 1;
+    }
 
-        //No changes need to be made to the JS file, so send it as is
-        server.streamFile(file, "text/javascript");
-        file.close();
-    });
+    void flush() override {
+        if (length > 0) {
+            server.sendContent((const char*)buffer, length);
+            length = 0;
 
-    server.on("/schedule", HTTP_GET, []() {
-        File file = LittleFS.open("/schedule.html", "r");
-        if (!file) {
-            return;
+            // A large response is sent in many pieces, a due ring goes first
+            taskManager.preempt();
         }
-
-        String htmlContent;
-        htmlContent = file.readString();
-        file.close();
-
-        // Replace the placeholder with the device name
-        htmlContent.replace("{{deviceName}}", deviceName);
-
-        server.send(200, "text/html", htmlContent);
-    });
-
-    /*************************Authentication*************************************/
-
-    server.on("/completeLogin", HTTP_POST, []() {
-        if (server.hasArg("password")) {
-            String password = server.arg("password");
-            if (authManager.checkPassword(password)) {
-                String token = authManager.generateToken();
-                String jsonResponse = "{\"token\":\"" + token + "\"}";
-                server.send(200, "application/json", jsonResponse);
-            } else {
-                server.send(401, "text/plain", "Unauthorized");
-            }
+    }
+
+private:
+    uint8_t buffer[512];
+    size_t length = 0;
+    uint8_t* capture;
+};
+
+// Response cache of the read endpoints
+static ResponseCacheManager responseCache;
+
+// Where a response goes in the response cache, see `sendCached`
+struct CacheTarget {
+    uint32_t key;
+    uint32_t version;
+};
+
+/**
+ * The function `sendCached` answers the request from the response cache if the cached body was built from
+ * the current version of its data. The key covers the path, the arguments and the format, so e.g. every
+ * profile of /getSchedule and its JSON and MessagePack forms are cached separately.
+ *
+ * @param version Current version of the data the response is built from.
+ * @param target Receives the cache slot the handler passes to the send function when it builds the body.
+ *
+ * @return `true` if the response was sent from the cache.
+ */
+static bool sendCached(uint32_t version, CacheTarget& target) {
+    uint32_t key = routeHash(server.uri().c_str());
+    for (int i = 0; i < server.args(); i++) {
+        key = ResponseCacheManager::combine(key, routeHash(server.argName(i).c_str()));
+        key = ResponseCacheManager::combine(key, routeHash(server.arg(i).c_str()));
+    }
+    key = ResponseCacheManager::combine(key, acceptsMsgPack());
+
+    target.key = key == 0 ? 1 : key; // 0 marks an empty cache entry
+    target.version = version;
+    return responseCache.send(server, target.key, version);
+}
+
+/**
+ * The function `sendText` sends a text response and keeps a copy in the response cache.
+ *
+ * @param contentType Content type, a string literal.
+ * @param body The response body.
+ * @param cache Cache slot from `sendCached`.
+ */
+static void sendText(const char* contentType, const String& body, const CacheTarget& cache) {
+    uint8_t* copy = responseCache.store(cache.key, cache.version, contentType, body.length());
+    if (copy != nullptr) {
+        memcpy(copy, body.c_str(), body.length());
+    }
+    server.send(200, contentType, (const uint8_t*)body.c_str(), body.length());
+}
+
+/**
+ * The function `sendDocument` sends a JSON document as MessagePack or JSON, depending on the Accept
+ * header. The length is measured first and the document is serialized straight into the response, so no
+ * copy of the output is built on the heap.
+ *
+ * @param doc The document to send.
+ * @param negotiate `false` to always send JSON.
+ * @param cache Cache slot from `sendCached` to keep a copy of the output in, or nullptr.
+ */
+static void sendDocument(const JsonDocument& doc, bool negotiate = true, const CacheTarget* cache = nullptr) {
+    bool msgPack = negotiate && acceptsMsgPack();
+    const char* contentType = msgPack ? "application/msgpack" : "application/json";
+    size_t length = msgPack ? measureMsgPack(doc) : measureJson(doc);
+
+    ContentPrint out(cache != nullptr ? responseCache.store(cache->key, cache->version, contentType, length) : nullptr);
+    server.setContentLength(length);
+    server.send(200, contentType, "");
+    if (msgPack) {
+        serializeMsgPack(doc, out);
+    } else {
+        serializeJson(doc, out);
+    }
+    out.flush();
+}
+
+/**
+ * The function `sendMinutesMsgPack` sends a list of minutes of the day as a MessagePack array. The
+ * array is encoded by hand, a JsonDocument would need 16 bytes per element for up to 1440 rings.
+ *
+ * @param minutes The minutes to send, each below 1440.
+ * @param cache Cache slot from `sendCached` to keep a copy of the output in.
+ */
+static void sendMinutesMsgPack(const std::vector<uint16_t>& minutes, const CacheTarget& cache) {
+    // array 16 header, then each minute as a positive fixint or uint 16
+    size_t length = 3;
+    for (uint16_t minute : minutes) {
+        length += minute < 0x80 ? 1 : 3;
+    }
+
+    server.setContentLength(length);
+    server.send(200, "application/msgpack", "");
+
+    ContentPrint out(responseCache.store(cache.key, cache.version, "application/msgpack", length));
+    out.write(0xDC);
+    out.write(minutes.size() >> 8);
+    out.write(minutes.size() & 0xFF);
+    for (uint16_t minute : minutes) {
+        if (minute < 0x80) {
+            out.write(minute);
         } else {
-            server.send(400, "text/plain", "No password received");
+            out.write(0xCD);
+            out.write(minute >> 8);
+            out.write(minute & 0xFF);
         }
-    });
-
-    server.on("/auth", HTTP_GET, []() {
-        String providedToken = server.header("Authorization");
-
-        if (!authManager.checkToken(providedToken)) {
+    }
+    out.flush();
+}
+
+/*************************Schedule Page*************************************/
+
+static void handleGetSchedule() {
+    // Clients may keep the schedule but must revalidate it, an unchanged schedule costs a 304 only. JSON
+    // and MessagePack have their own tags, the route sends Vary: Accept.
+    String etag = representationETag(scheduleManager.getScheduleETag(server.arg("profile")), acceptsMsgPack());
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("ETag", etag);
+
+    if (etagMatches(server.header("If-None-Match"), etag)) {
+        server.send(304);
+        return;
+    }
+
+    // The active profile may change with the date, so a new day is a new version
+    CacheTarget cache;
+    if (sendCached(ResponseCacheManager::combine(scheduleManager.getVersion(), timeManager.getDayNumber()), cache)) {
+        return;
+    }
+
+    ArenaJsonDocument schedule(4096);
+    scheduleManager.getSchedule(server.arg("profile"), schedule, acceptsMsgPack());
+    sendDocument(schedule, true, &cache);
+}
+
+static void handleGetProfiles() {
+    server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    ArenaJsonDocument profiles(1024);
+    scheduleManager.getProfiles(profiles);
+    sendDocument(profiles, false);
+}
+
+static void handleUpdateSchedule() {
+    // Check if the request has a body (raw POST data)
+    if (server.hasArg("plain") == false) { // Use "plain" for raw POST body
+        server.send(400, "text/plain", "No schedule data received");
+        return;
+    }
+
+    // Parse the raw POST data once, the schedule manager works on the parsed document
+    ArenaJsonDocument doc(4096);
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+
+
+    if (error) { // Check for errors in parsing
+        server.send(500, "text/plain", "Error parsing JSON");
+        return;
+    }
+
+    // Optimistic concurrency, reject the update if the schedule changed since the client read it. Without
+    // a profile the update may replace every profile, so the tag covers the whole store. A client that
+    // read the MessagePack form sends its tag, either form names the same schedule.
+    String etag = scheduleManager.getScheduleETag(server.arg("profile"));
+    String ifMatch = server.header("If-Match");
+    if (ifMatch.length() > 0 && !etagMatches(ifMatch, etag) && !etagMatches(ifMatch, representationETag(etag, true))) {
+        server.sendHeader("ETag", etag);
+        server.send(412, "text/plain", "Schedule was changed by another client");
+        return;
+    }
+
+    // A profile argument adds or replaces that profile, otherwise the active profile is replaced
+    bool saved;
+    if (server.hasArg("profile")) {
+        saved = scheduleManager.updateProfile(server.arg("profile"), doc.as<JsonObject>(), server.arg("start"), server.arg("end"));
+    } else {
+        saved = scheduleManager.updateSchedule(doc.as<JsonObject>());
+    }
+
+    String newEtag = scheduleManager.getScheduleETag(server.arg("profile"));
+    server.sendHeader("ETag", newEtag);
+    if (!saved) {
+        server.send(500, "text/plain", "Failed to save schedule");
+    } else if (newEtag == etag) {
+        server.send(200, "text/plain", "Schedule unchanged");
+    } else {
+        server.send(200, "text/plain", "Schedule saved successfully");
+    }
+}
+
+// The CSV body is handed over piece by piece while it arrives, then the import is finished here
+static void handleImportSchedule() {
+    String result;
+    if (scheduleManager.finishCsvImport(result)) {
+        server.sendHeader("ETag", scheduleManager.getScheduleETag());
+        server.send(200, "text/plain", result);
+    } else {
+        server.send(400, "text/plain", result);
+    }
+}
+
+static void handleImportScheduleBody() {
+    HTTPRaw& raw = server.raw();
+
+    // Only called for authorized requests, the route manager drops the body of the others
+    if (raw.status == RAW_START) {
+        scheduleManager.beginCsvImport();
+    } else if (raw.status == RAW_WRITE) {
+        scheduleManager.importCsvChunk(raw.buf, raw.currentSize);
+        taskManager.preempt();
+    } else if (raw.status == RAW_ABORTED) {
+        scheduleManager.abortCsvImport();
+    }
+}
+
+static void handleExportSchedule() {
+    server.sendHeader("Content-Disposition", "attachment; filename=\"schedule.csv\"");
+    if (!server.chunkedResponseModeStart(200, "text/csv")) {
+        server.send(505, "text/plain", "HTTP/1.1 required");
+        return;
+    }
+
+    ContentPrint out;
+    scheduleManager.exportCsv(out, server.arg("profile"));
+    out.flush();
+    server.chunkedResponseFinalize();
+}
+
+static void handleSetActiveProfile() {
+    if (!server.hasArg("name")) {
+        server.send(400, "text/plain", "No profile name received");
+        return;
+    }
+
+    if (scheduleManager.setActiveProfile(server.arg("name"))) {
+        server.send(200, "text/plain", "Active profile changed");
+    } else {
+        server.send(404, "text/plain", "Profile not found");
+    }
+}
+
+static void handleDeleteProfile() {
+    if (scheduleManager.deleteProfile(server.arg("name"))) {
+        server.send(200, "text/plain", "Profile deleted");
+    } else {
+        server.send(404, "text/plain", "Profile not found");
+    }
+}
+
+static void handleSchedulePage() {
+    String htmlContent;
+    if (!assetManager.readAsset("/schedule.html", htmlContent)) {
+        server.send(500, "text/plain", "Page not available");
+        return;
+    }
+
+    // Replace the placeholder with the device name
+    htmlContent.replace("{{deviceName}}", deviceName);
+
+    server.send(200, "text/html", htmlContent);
+}
+
+/*************************Authentication*************************************/
+
+static void handleCompleteLogin() {
+    if (server.hasArg("password")) {
+        String password = server.arg("password");
+        if (authManager.checkPassword(password)) {
+            char jsonResponse[80];
+            int length = snprintf(jsonResponse, sizeof(jsonResponse), "{\"token\":\"%s\"}", authManager.generateToken().c_str());
+            server.send(200, "application/json", (const uint8_t*)jsonResponse, length);
+        } else {
             server.send(401, "text/plain", "Unauthorized");
-            return;
         }
-
-        server.send(200, "text/plain", "Authorized");
-    });
-
-    server.on("/script/auth.js", HTTP_GET, []() {
-        String jsContent;
-        File file = LittleFS.open("/script/auth.js", "r");
-        if (!file) {
-            return;
+    } else {
+        server.send(400, "text/plain", "No password received");
+    }
+}
+
+static void handleAuth() {
+    server.send(200, "text/plain", "Authorized");
+}
+
+/*************************Home Page*************************************/
+
+static void handleToggleRelay() {
+    relayManager.activateRelay(); // Activate the relay for saved duration
+    server.send(200, "text/plain", "Relay toggle successful");
+}
+
+static void handleGetTodayRemainingRingTimes() {
+    // The list changes with the schedule and on every minute tick
+    uint32_t minute = timeManager.getDayNumber() * 1440UL + timeManager.getMinuteOfDay();
+    CacheTarget cache;
+    if (sendCached(ResponseCacheManager::combine(scheduleManager.getVersion(), minute), cache)) {
+        return;
+    }
+
+    // MessagePack clients get the minutes of the day instead of a formatted list
+    if (acceptsMsgPack()) {
+        std::vector<uint16_t> minutes;
+        scheduleManager.getTodayRemainingRings(minutes);
+        sendMinutesMsgPack(minutes, cache);
+        return;
+    }
+
+    String result = scheduleManager.getTodayRemainingRingTimes(); // Get the remaining ring times for today
+    sendText("text/plain", result, cache);
+}
+
+static void handleGetStatus() {
+    ArenaJsonDocument doc(4352);
+
+    JsonObject time = doc.createNestedObject("time");
+    time["valid"] = timeManager.isTimeValid();
+    time["restored"] = timeManager.isTimeRestored();
+    time["synchronized"] = ntpManager.isSynchronized();
+    time["server"] = ntpManager.getServer();
+    time["syncCount"] = ntpManager.getSyncCount();
+    time["lastSyncAgeMs"] = ntpManager.isSynchronized() ? millis() - ntpManager.getLastSyncMillis() : 0;
+    time["offsetMs"] = ntpManager.getLastOffsetMillis();
+    time["delayMs"] = ntpManager.getLastDelayMillis();
+    time["driftPpm"] = timeManager.getDriftPpm();
+    time["pendingSlewMs"] = timeManager.getPendingSlewMillis();
+
+    JsonObject system = doc.createNestedObject("system");
+    system["warmBoot"] = restartManager.isWarmBoot();
+    system["bootMs"] = bootMillis;
+
+    JsonObject wifi = doc.createNestedObject("wifi");
+    wifi["connected"] = networkManager.isConnected();
+    wifi["rssi"] = WiFi.RSSI();
+    wifi["channel"] = WiFi.channel();
+    wifi["linkLosses"] = networkManager.getLinkLossCount();
+    wifi["reconnects"] = networkManager.getReconnectCount();
+    wifi["lastConnectMs"] = networkManager.getLastConnectMillis();
+    wifi["fastConnect"] = networkManager.isFastConnect();
+
+    JsonObject sync = doc.createNestedObject("configSync");
+    sync["url"] = configSyncManager.getUrl();
+    sync["intervalMinutes"] = configSyncManager.getIntervalMinutes();
+    sync["lastResult"] = configSyncManager.getLastResult();
+    sync["lastPollAgeMs"] = configSyncManager.getLastPollMillis() == 0 ? 0 : millis() - configSyncManager.getLastPollMillis();
+    sync["applied"] = configSyncManager.getAppliedCount();
+
+    JsonObject lanSync = doc.createNestedObject("lanSync");
+    lanSync["mode"] = lanSyncManager.getModeString();
+    lanSync["locked"] = lanSyncManager.isLocked();
+    lanSync["leader"] = lanSyncManager.getLeader().toString();
+    lanSync["lastCorrectionMs"] = lanSyncManager.getLastCorrectionMillis();
+    lanSync["beacons"] = lanSyncManager.getBeaconCount();
+    lanSync["armedRings"] = lanSyncManager.getArmedRingCount();
+
+    JsonObject rings = doc.createNestedObject("rings");
+    rings["count"] = scheduleManager.getRingCount();
+    rings["lastLatenessMs"] = scheduleManager.getLastRingLateness();
+    rings["maxLatenessMs"] = scheduleManager.getMaxRingLateness();
+    rings["averageLatenessMs"] = scheduleManager.getAverageRingLateness();
+
+    JsonObject http = doc.createNestedObject("http");
+    http["requests"] = arenaManager.getRequestCount();
+    http["arenaSize"] = ArenaManager::ARENA_SIZE;
+    http["arenaPeak"] = arenaManager.getPeakUse();
+    http["heapAllocations"] = arenaManager.getHeapAllocationCount();
+    http["heapGrowths"] = arenaManager.getHeapGrowthCount();
+    http["lastHeapDelta"] = arenaManager.getLastHeapDelta();
+    http["freeHeap"] = ESP.getFreeHeap();
+    http["maxFreeBlock"] = ESP.getMaxFreeBlockSize();
+    http["fragmentation"] = ESP.getHeapFragmentation();
+    http["cacheHits"] = responseCache.getHitCount();
+    http["cacheMisses"] = responseCache.getMissCount();
+    http["cacheBytes"] = responseCache.getSize();
+
+    // Whether a handshake resumed a session is not reported by BearSSL, so only the fast handshakes are
+    // counted (tlsprobe measures the session cache hit rate)
+    TlsServer& tls = server.getTlsServer();
+    JsonObject https = doc.createNestedObject("https");
+    https["running"] = server.isSecureRunning();
+    https["handshakes"] = tls.getHandshakeCount();
+    https["fastHandshakes"] = tls.getFastHandshakeCount();
+    https["failedHandshakes"] = tls.getFailedHandshakeCount();
+    https["lastHandshakeMs"] = tls.getLastHandshakeMillis();
+    https["averageHandshakeMs"] = tls.getAverageHandshakeMillis();
+    https["maxHandshakeMs"] = tls.getMaxHandshakeMillis();
+    https["sessionCacheSize"] = WebServerManager::SESSION_CACHE_SIZE;
+
+    JsonObject guard = doc.createNestedObject("ringGuard");
+    guard["open"] = ringGuardManager.isOpen();
+    guard["retryAfter"] = ringGuardManager.getRetryAfter();
+    guard["rejectedRequests"] = ringGuardManager.getRejectedCount();
+    guard["deferredOperations"] = ringGuardManager.getDeferredCount();
+    guard["pending"] = ringGuardManager.getPendingCount();
+
+    // The share of the time since boot the loop spent napping, the chip is in light sleep for most of it
+    JsonObject power = doc.createNestedObject("power");
+    power["lowPower"] = powerManager.isEnabled();
+    power["state"] = powerManager.getState();
+    power["sleepMs"] = powerManager.getSleepMillis();
+    power["sleepPercent"] = (uint32_t)(powerManager.getSleepMillis() * 100 / max(millis(), 1UL));
+    power["naps"] = powerManager.getNapCount();
+    power["earlyWakes"] = powerManager.getEarlyWakeCount();
+    power["wakeLeadS"] = PowerManager::WAKE_LEAD;
+
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (uint8_t i = 0; i < taskManager.getTaskCount(); i++) {
+        const Task& task = taskManager.getTask(i);
+        JsonObject entry = tasks.createNestedObject();
+        entry["name"] = task.name;
+        entry["priority"] = (uint8_t)task.priority;
+        entry["runs"] = task.runs;
+        entry["lastUs"] = task.lastMicros;
+        entry["maxUs"] = task.maxMicros;
+        entry["averageUs"] = task.runs == 0 ? 0 : (uint32_t)(task.totalMicros / task.runs);
+        entry["budgetUs"] = task.budget;
+        entry["overBudget"] = task.overBudget;
+        entry["skippedRuns"] = task.skippedRuns;
+        entry["maxLatenessMs"] = task.maxLateness;
+        entry["missedDeadlines"] = task.missedDeadlines;
+    }
+
+    sendDocument(doc);
+}
+
+static void handleGetServerMessages() {
+    // Every new message is a new version
+    CacheTarget cache;
+    if (sendCached(eepromManager.getMessageCount(), cache)) {
+        return;
+    }
+    sendDocument(systemMessages, true, &cache);
+}
+
+/**
+ * The function `handleGetState` sends everything the home page shows in one response: device name,
+ * time, today's remaining rings, the messages the page has not seen yet, MAC address and sync status.
+ * Ring times are minutes of the day. With ?since=<messageCount of an earlier answer> only the messages
+ * added after it are sent.
+ */
+static void handleGetState() {
+    ArenaJsonDocument doc(2048);
+
+    doc["name"] = deviceName;
+    doc["time"] = timeManager.getDateTime();
+    doc["minute"] = timeManager.getMinuteOfDay();
+
+    std::vector<uint16_t> minutes;
+    scheduleManager.getTodayRemainingRings(minutes);
+    JsonArray rings = doc.createNestedArray("rings");
+    for (uint16_t minute : minutes) {
+        rings.add(minute);
+    }
+
+    // The array holds the newest messages, the last one is number messageCount
+    JsonArray allMessages = systemMessages.as<JsonArray>();
+    uint32_t messageCount = eepromManager.getMessageCount();
+    uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+    uint32_t first = messageCount - allMessages.size();
+    doc["messageCount"] = messageCount;
+    JsonArray messages = doc.createNestedArray("messages");
+    for (size_t i = 0; i < allMessages.size(); i++) {
+        if (first + i + 1 > since) {
+            messages.add(allMessages[i]);
         }
-
-        //No changes need to be made to the JS file, so send it as is
-        server.streamFile(file, "text/javascript");
-        file.close();
-    });
-
-    /*************************Home Page*************************************/
-
-    server.on("/script/index.js", HTTP_GET, []() {
-        String jsContent;
-        File file = LittleFS.open("/script/index.js", "r");
-        if (!file) {
+    }
+
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    char macStr[18];
+    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    doc["mac"] = macStr;
+
+    JsonObject sync = doc.createNestedObject("sync");
+    sync["ntp"] = ntpManager.isSynchronized();
+    sync["lan"] = lanSyncManager.getModeString();
+    sync["lanLocked"] = lanSyncManager.isLocked();
+    sync["config"] = configSyncManager.getLastResult();
+
+    server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    sendDocument(doc);
+}
+
+static void handleIndexPage() {
+    String htmlContent;
+    if (!assetManager.readAsset("/index.html", htmlContent)) {
+        server.send(500, "text/plain", "Page not available");
+        return;
+    }
+
+    // Replace the placeholder with the device name
+    htmlContent.replace("{{deviceName}}", deviceName);
+    htmlContent.replace("{{dateTime}}", timeManager.getDateTime());
+
+    server.send(200, "text/html", htmlContent);
+}
+
+/*************************Settings Page*************************************/
+
+static void handleSettingsPage() {
+    String htmlContent;
+    if (!assetManager.readAsset("/settings.html", htmlContent)) {
+        server.send(500, "text/plain", "Page not available");
+        return;
+    }
+
+    // Replace the placeholder with the device name
+    htmlContent.replace("{{deviceName}}", deviceName);
+    htmlContent.replace("{{uniqueURL}}", uniqueURL);
+    htmlContent.replace("{{ringDuration}}", String(ringDuration));
+    htmlContent.replace("{{timezone}}", timeManager.getTimezone());
+    htmlContent.replace("{{ntpServer}}", ntpManager.getServer());
+    htmlContent.replace("{{syncURL}}", configSyncManager.getUrl());
+    htmlContent.replace("{{syncInterval}}", String(configSyncManager.getIntervalMinutes()));
+    htmlContent.replace("{{lanSync}}", lanSyncManager.getModeString());
+    htmlContent.replace("{{lowPower}}", powerManager.isEnabled() ? "on" : "off");
+
+    // Set Cache-Control headers
+    server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    server.sendHeader("Pragma", "no-cache");
+    server.sendHeader("Expires", "-1");
+
+    server.send(200, "text/html", htmlContent);
+}
+
+static void handleGetMacAddress() {
+    // The address never changes
+    CacheTarget cache;
+    if (sendCached(0, cache)) {
+        return;
+    }
+
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    char macStr[18] = {0}; // 17 characters for MAC address + 1 for string termination
+    sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    sendText("text/plain", macStr, cache);
+}
+
+static void handleSaveSettings() {
+    // Use ArduinoJson to parse the raw POST data
+    ArenaJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    
+    if (error) {
+        server.send(500, "text/plain", "Error parsing JSON!");
+        return;
+    }
+
+    // Extract and save the device name
+    if (doc.containsKey("deviceName")) {
+        deviceName = doc["deviceName"].as<String>();
+        eepromManager.saveDeviceName(deviceName);
+    }
+
+    // Extract and save the ring duration
+    if (doc.containsKey("ringDuration")) {
+        ringDuration = doc["ringDuration"];
+        eepromManager.saveRingDuration(ringDuration);
+    }
+
+    // Extract and apply the POSIX time zone
+    if (doc.containsKey("timezone") && doc["timezone"].as<String>() != timeManager.getTimezone()) {
+        if (!timeManager.setTimezone(doc["timezone"].as<String>())) {
+            server.send(400, "text/plain", "Invalid time zone");
             return;
         }
+    }
 
-        //No changes need to be made to the JS file, so send it as is
-        server.streamFile(file, "text/javascript");
-        file.close();
-    });
-
-    server.on("/ToggleRelay", HTTP_GET, []() {
-        String providedToken = server.header("Authorization");
-
-        if (!authManager.checkToken(providedToken)) {
-            server.send(401, "text/plain", "Unauthorized");
+    // Extract and apply the NTP server
+    if (doc.containsKey("ntpServer") && doc["ntpServer"].as<String>() != ntpManager.getServer()) {
+        if (!ntpManager.setServer(doc["ntpServer"].as<String>())) {
+            server.send(400, "text/plain", "Invalid NTP server");
             return;
         }
-
-        relayManager.activateRelay(); // Activate the relay for saved duration
-        server.send(200, "text/plain", "Relay toggle successful");
-    });
-
-    server.on("/getTodayRemainingRingTimes", HTTP_GET, []() {
-        String result = scheduleManager.getTodayRemainingRingTimes(); // Get the remaining ring times for today
-        server.send(200, "text/plain", result);
-    });
-
-    server.on("/getServerMessages", HTTP_GET, []() {
-        String output;
-        serializeJson(systemMessages, output);
-        server.send(200, "application/json", output);
-    });
-
-    server.on("/", HTTP_GET, []() {
-        File file = LittleFS.open("/index.html", "r");
-        if (!file) {
-            return;
-        }
-
-        String htmlContent;
-        htmlContent = file.readString();
-        file.close();
-
-        // Replace the placeholder with the device name
-        htmlContent.replace("{{deviceName}}", deviceName);
-        htmlContent.replace("{{dateTime}}", timeManager.getDateTime());
-
-        server.send(200, "text/html", htmlContent);
-    });
-
-    /*************************Settings Page*************************************/
-
-    server.on("/settings", HTTP_GET, []() {
-        String htmlContent;
-        File file = LittleFS.open("/settings.html", "r");
-        if (!file) {
-            return;
-        }
-
-        htmlContent = file.readString();
-        file.close();
-
-        // Replace the placeholder with the device name
-        htmlContent.replace("{{deviceName}}", deviceName);
-        htmlContent.replace("{{uniqueURL}}", uniqueURL);
-        htmlContent.replace("{{ringDuration}}", String(ringDuration));
-
-        // Set Cache-Control headers
-        server.sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-        server.sendHeader("Pragma", "no-cache");
-        server.sendHeader("Expires", "-1");
-
-        server.send(200, "text/html", htmlContent);
-    });
-
-    server.on("/getMacAddress", HTTP_GET, []() {
-        uint8_t mac[6];
-        WiFi.macAddress(mac);
-        char macStr[18] = {0}; // 17 characters for MAC address + 1 for string termination
-        sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-        server.send(200, "text/plain", macStr);
-    });
-
-
-
-    server.on("/saveSettings", HTTP_POST, []() {
-        // Assuming the token is sent in the Authorization header
-        String providedToken = server.header("Authorization");
-
-        if (!authManager.checkToken(providedToken)) {
-            // If the token check fails, respond with 401 Unauthorized
-            server.send(401, "text/plain", "Unauthorized");
-            return; // Stop further processing
-        }
-
-        // Read the raw POST data
-        String requestBody = server.arg("plain");
-        
-        // Use ArduinoJson to parse the JSON payload
-        DynamicJsonDocument doc(1024);
-        DeserializationError error = deserializeJson(doc, requestBody);
-        
-        if (error) {
-            server.send(500, "text/plain", "Error parsing JSON!");
+    }
+
+    // Extract and apply the config server URL and poll interval
+    if (doc.containsKey("syncURL") || doc.containsKey("syncInterval")) {
+        String syncURL = doc.containsKey("syncURL") ? doc["syncURL"].as<String>() : configSyncManager.getUrl();
+        int syncInterval = doc.containsKey("syncInterval") ? doc["syncInterval"].as<int>() : configSyncManager.getIntervalMinutes();
+        if ((syncURL != configSyncManager.getUrl() || syncInterval != configSyncManager.getIntervalMinutes()) &&
+            !configSyncManager.setSource(syncURL, syncInterval)) {
+            server.send(400, "text/plain", "Invalid config server URL or interval");
             return;
         }
+    }
 
-        // Extract and save the device name
-        if (doc.containsKey("deviceName")) {
-            deviceName = doc["deviceName"].as<String>();
-            eepromManager.saveDeviceName(deviceName);
-        }
-
-        // Extract and save the ring duration
-        if (doc.containsKey("ringDuration")) {
-            ringDuration = doc["ringDuration"];
-            eepromManager.saveRingDuration(ringDuration);
-        }
-
-        // Extract, compare, and potentially save the unique URL
-        if (doc.containsKey("uniqueURL")) {
-            uniqueURL = doc["uniqueURL"].as<String>();
-            if (uniqueURL != eepromManager.loadUniqueURL()) {
-                eepromManager.saveUniqueURL(uniqueURL);
-                server.send(200, "text/plain", "URL saved successfully, device will restart to apply changes");
-                delay(1000); // Short delay before restart
-                ESP.restart();
-                return;
-            }
-        }
-
-            server.send(200, "text/plain", "Settings saved successfully.");
-        });
-
-
-    server.on("/script/settings.js", HTTP_GET, []() {
-        String jsContent;
-        File file = LittleFS.open("/script/settings.js", "r");
-        if (!file) {
+    // Extract and apply the LAN sync mode
+    if (doc.containsKey("lanSync") && doc["lanSync"].as<String>() != lanSyncManager.getModeString()) {
+        if (!lanSyncManager.setMode(doc["lanSync"].as<String>())) {
+            server.send(400, "text/plain", "Invalid LAN sync mode");
             return;
         }
-
-        //No changes need to be made to the JS file, so send it as is
-        server.streamFile(file, "text/javascript");
-        file.close();
-    });
-
-    /*************************Change Password Page*************************************/
-
-    server.on("/changepassword", HTTP_GET, []() {
-        File file = LittleFS.open("/changePassword.html", "r");
-        if (!file) {
+    }
+
+    // Extract and apply the low power mode
+    if (doc.containsKey("lowPower") && doc["lowPower"].as<bool>() != powerManager.isEnabled()) {
+        powerManager.setEnabled(doc["lowPower"].as<bool>());
+    }
+
+    // Extract, compare, and potentially save the unique URL, the device is renamed without a restart
+    if (doc.containsKey("uniqueURL") && doc["uniqueURL"].as<String>() != uniqueURL) {
+        String newURL = doc["uniqueURL"].as<String>();
+        eepromManager.saveUniqueURL(newURL);
+        if (!networkManager.setHostname(newURL)) {
+            server.send(500, "text/plain", "URL saved, but MDNS failed to start with the new URL");
             return;
         }
+        server.send(200, "text/plain", "URL saved successfully, new URL is active");
+        return;
+    }
 
-        String htmlContent;
-        htmlContent = file.readString();
-        file.close();
+    server.send(200, "text/plain", "Settings saved successfully.");
+}
 
-        // Replace the placeholder with the device name
-        htmlContent.replace("{{deviceName}}", deviceName);
+/*************************Change Password Page*************************************/
 
-        server.send(200, "text/html", htmlContent);
-    });
+static void handleChangePasswordPage() {
+    String htmlContent;
+    if (!assetManager.readAsset("/changePassword.html", htmlContent)) {
+        server.send(500, "text/plain", "Page not available");
+        return;
+    }
 
-    server.on("/script/changePassword.js", HTTP_GET, []() {
-        String jsContent;
-        File file = LittleFS.open("/script/changePassword.js", "r");
-        if (!file) {
-            return;
-        }
-        
+    // Replace the placeholder with the device name
+    htmlContent.replace("{{deviceName}}", deviceName);
 
-        //No changes need to be made to the JS file, so send it as is
-        server.streamFile(file, "text/javascript");
-        file.close();
-    });
+    server.send(200, "text/html", htmlContent);
+}
 
-    server.on("/finalizePassword", HTTP_POST, []() {
-        String providedToken = server.header("Authorization");
-        if (!authManager.checkToken(providedToken)) {
-            server.send(401, "text/plain", "Unauthorized");
-            return;
-        }
-
-        if (server.hasArg("OldPassword") && server.hasArg("NewPassword")) {
-            if (authManager.checkPassword(server.arg("OldPassword"))) {
-                if (authManager.updatePassword(server.arg("NewPassword"))) {
-                    server.send(200, "text/plain", "Password changed successfully.");
-                } else {
-                    server.send(500, "text/plain", "Failed to save new password.");
-                }
+static void handleFinalizePassword() {
+    if (server.hasArg("OldPassword") && server.hasArg("NewPassword")) {
+        if (authManager.checkPassword(server.arg("OldPassword"))) {
+            if (authManager.updatePassword(server.arg("NewPassword"))) {
+                server.send(200, "text/plain", "Password changed successfully.");
             } else {
-                server.send(401, "text/plain", "Invalid old password.");
+                server.send(500, "text/plain", "Failed to save new password.");
             }
         } else {
-            server.send(400, "text/plain", "Required parameters missing.");
+            server.send(401, "text/plain", "Invalid old password.");
         }
-    });
+    } else {
+        server.send(400, "text/plain", "Required parameters missing.");
+    }
+}
+
+/**
+ * The function `handleSetCertificate` installs the certificate and ECDSA private key of the HTTPS server,
+ * both in PEM format: {"certificate": "...", "key": "..."}. Both empty remove them and stop HTTPS.
+ */
+static void handleSetCertificate() {
+    ArenaJsonDocument doc(4096);
+    if (deserializeJson(doc, server.arg("plain"))) {
+        server.send(400, "text/plain", "Error parsing JSON!");
+        return;
+    }
+
+    if (!server.setCertificate(doc["certificate"] | "", doc["key"] | "")) {
+        server.send(400, "text/plain", "Invalid certificate or key, an ECDSA key is required");
+        return;
+    }
+    server.send(200, "text/plain", server.isSecureRunning() ? "HTTPS enabled" : "HTTPS disabled");
+}
+
+/*************************Routes*************************************/
+
+// Every endpoint of the web server. Routes with AUTH_TOKEN are only called with a valid token, asset
+// routes are answered from the web archive without a handler, and GUARD_DEFER routes are answered with
+// 503 while a ring is close. Once HTTPS runs, AUTH_TOKEN and AUTH_PASSWORD routes are refused and pages
+// are redirected on plain HTTP.
+static constexpr Route routes[] = {
+    // Schedule page
+    ROUTE("/schedule", HTTP_GET, AUTH_NONE, RESPONSE_PAGE, GUARD_DEFER, handleSchedulePage, nullptr),
+    ROUTE("/script/schedule.js", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+    ROUTE("/getSchedule", HTTP_GET, AUTH_NONE, RESPONSE_NEGOTIATED, GUARD_NONE, handleGetSchedule, nullptr),
+    ROUTE("/getProfiles", HTTP_GET, AUTH_NONE, RESPONSE_TEXT, GUARD_NONE, handleGetProfiles, nullptr),
+    ROUTE("/updateSchedule", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleUpdateSchedule, nullptr),
+    ROUTE("/updateSchedule", HTTP_PUT, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleUpdateSchedule, nullptr),
+    ROUTE("/importSchedule", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleImportSchedule, handleImportScheduleBody),
+    ROUTE("/exportSchedule", HTTP_GET, AUTH_NONE, RESPONSE_TEXT, GUARD_DEFER, handleExportSchedule, nullptr),
+    ROUTE("/setActiveProfile", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleSetActiveProfile, nullptr),
+    ROUTE("/deleteProfile", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleDeleteProfile, nullptr),
+
+    // Authentication
+    ROUTE("/completeLogin", HTTP_POST, AUTH_PASSWORD, RESPONSE_TEXT, GUARD_DEFER, handleCompleteLogin, nullptr),
+    ROUTE("/auth", HTTP_GET, AUTH_TOKEN, RESPONSE_TEXT, GUARD_NONE, handleAuth, nullptr),
+    ROUTE("/script/auth.js", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+
+    // Home page
+    ROUTE("/", HTTP_GET, AUTH_NONE, RESPONSE_PAGE, GUARD_DEFER, handleIndexPage, nullptr),
+    ROUTE("/script/index.js", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+    ROUTE("/ToggleRelay", HTTP_GET, AUTH_TOKEN, RESPONSE_TEXT, GUARD_NONE, handleToggleRelay, nullptr),
+    ROUTE("/getTodayRemainingRingTimes", HTTP_GET, AUTH_NONE, RESPONSE_NEGOTIATED, GUARD_NONE, handleGetTodayRemainingRingTimes, nullptr),
+    ROUTE("/getStatus", HTTP_GET, AUTH_NONE, RESPONSE_NEGOTIATED, GUARD_NONE, handleGetStatus, nullptr),
+    ROUTE("/getServerMessages", HTTP_GET, AUTH_NONE, RESPONSE_NEGOTIATED, GUARD_NONE, handleGetServerMessages, nullptr),
+    ROUTE("/api/state", HTTP_GET, AUTH_NONE, RESPONSE_NEGOTIATED, GUARD_NONE, handleGetState, nullptr),
+    ROUTE("/favicon.ico", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+
+    // Settings page
+    ROUTE("/settings", HTTP_GET, AUTH_NONE, RESPONSE_PAGE, GUARD_DEFER, handleSettingsPage, nullptr),
+    ROUTE("/script/settings.js", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+    ROUTE("/getMacAddress", HTTP_GET, AUTH_NONE, RESPONSE_TEXT, GUARD_NONE, handleGetMacAddress, nullptr),
+    ROUTE("/saveSettings", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleSaveSettings, nullptr),
+    ROUTE("/setCertificate", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleSetCertificate, nullptr),
+
+    // Change password page
+    ROUTE("/changepassword", HTTP_GET, AUTH_NONE, RESPONSE_PAGE, GUARD_DEFER, handleChangePasswordPage, nullptr),
+    ROUTE("/script/changePassword.js", HTTP_GET, AUTH_NONE, RESPONSE_ASSET, GUARD_DEFER, nullptr, nullptr),
+    ROUTE("/finalizePassword", HTTP_POST, AUTH_TOKEN, RESPONSE_TEXT, GUARD_DEFER, handleFinalizePassword, nullptr),
+};
+
+static RouteManager routeManager(routes, sizeof(routes) / sizeof(routes[0]));
 
-    /*************************Favicon*************************************/
+void setupEndpoints() {
+    // Request headers kept by the server besides Authorization, which is always collected
+    static const char* headerKeys[] = {"If-None-Match", "If-Match", "Accept"};
+    server.collectHeaders(headerKeys, 3);
 
-    server.on("/favicon.ico", HTTP_GET, []() {
-        File file = LittleFS.open("/favicon.ico", "r");
-        if (!file) {
-            return;
-        }
+    // One handler for all routes, the server does not have to try every endpoint in turn
+    server.addRoutes(routeManager);
 
-        server.streamFile(file, "image/x-icon");
-    });
+    // A page and its scripts can be loaded over one connection instead of a new one per request
+    server.keepAlive(true);
 
     // Handle not found
     server.onNotFound([]() {
         server.send(404, "text/plain", "Not found");
     });
-}
\ No newline at end of file
+}
+
+/**
+ * The function `updateEndpoints` is called from the main loop after the server handled its client. It
+ * closes a kept alive connection that went idle, so other clients do not wait for it to time out.
+ */
+void updateEndpoints() {
+    routeManager.closeIdleConnection();
+}
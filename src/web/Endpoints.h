@@ -16,4 +16,10 @@ extern DynamicJsonDocument systemMessages; // Array to store system messages
 //Initialization function
 void setupEndpoints();
 
+// Closes idle kept alive connections, called from the main loop
+void updateEndpoints();
+
+// Sends a file of the compiled in web archive, used by the asset routes
+void sendAsset(const char* path);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the response cache of the read endpoints.
+*/
+
+#include "ResponseCacheManager.h"
+
+ResponseCacheManager::ResponseCacheManager() : hits(0), misses(0) {
+    clear();
+}
+
+/**
+ * The function `send` answers a request from the cache if it holds a body for the request that was built
+ * from the current version of its data. Headers set before the call (e.g. ETag) are sent with it.
+ *
+ * @param server The server to answer on.
+ * @param key Hash of the request's path, arguments and format.
+ * @param version Current version of the data the response is built from.
+ *
+ * @return `true` if the response was sent, `false` if the handler has to build it.
+ */
+bool ResponseCacheManager::send(WebServerManager& server, uint32_t key, uint32_t version) {
+    Entry* entry = findEntry(key);
+    if (entry == nullptr || entry->version != version) {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    entry->usedAt = millis();
+    server.send(200, entry->contentType, buffer + entry->offset, entry->length);
+    return true;
+}
+
+/**
+ * The function `store` makes room for the body of a response the handler is about to send. The handler
+ * writes the body into the returned memory while sending it.
+ *
+ * @param key Hash of the request's path, arguments and format.
+ * @param version Version of the data the body is built from.
+ * @param contentType Content type of the body, a string literal.
+ * @param length Length of the body.
+ *
+ * @return Memory for `length` bytes in the cache buffer, valid until the next call, or nullptr if the body
+ * is too large to be cached.
+ */
+uint8_t* ResponseCacheManager::store(uint32_t key, uint32_t version, const char* contentType, size_t length) {
+    if (length > MAX_BYTES) {
+        return nullptr;
+    }
+
+    // Reuse the entry of the same request, or else an empty one or the least recently used one
+    Entry* entry = findEntry(key);
+    for (uint8_t i = 0; entry == nullptr && i < MAX_ENTRIES; i++) {
+        if (entries[i].key == 0) {
+            entry = &entries[i];
+        }
+    }
+    if (entry == nullptr) {
+        entry = &entries[0];
+        for (Entry& candidate : entries) {
+            if ((long)(candidate.usedAt - entry->usedAt) < 0) {
+                entry = &candidate;
+            }
+        }
+    }
+    release(*entry);
+
+    // Drop the least recently used bodies until the new one fits after the others
+    while (getSize() + length > MAX_BYTES) {
+        Entry* oldest = nullptr;
+        for (Entry& candidate : entries) {
+            if (candidate.length > 0 && (oldest == nullptr || (long)(candidate.usedAt - oldest->usedAt) < 0)) {
+                oldest = &candidate;
+            }
+        }
+        release(*oldest);
+    }
+
+    entry->key = key;
+    entry->version = version;
+    entry->contentType = contentType;
+    entry->usedAt = millis();
+    entry->offset = getSize();
+    entry->length = length;
+    return buffer + entry->offset;
+}
+
+/**
+ * The function `clear` drops every cached body.
+ */
+void ResponseCacheManager::clear() {
+    for (Entry& entry : entries) {
+        entry.key = 0;
+        entry.usedAt = 0;
+        entry.offset = 0;
+        entry.length = 0;
+    }
+}
+
+uint32_t ResponseCacheManager::getHitCount() {
+    return hits;
+}
+
+uint32_t ResponseCacheManager::getMissCount() {
+    return misses;
+}
+
+/**
+ * The function `getSize` returns the bytes of the buffer taken by the cached bodies.
+ */
+size_t ResponseCacheManager::getSize() {
+    size_t size = 0;
+    for (Entry& entry : entries) {
+        size += entry.length;
+    }
+    return size;
+}
+
+/**
+ * The function `combine` mixes a second version counter into a version, for responses built from more
+ * than one kind of data.
+ */
+uint32_t ResponseCacheManager::combine(uint32_t version, uint32_t other) {
+    return (version * 16777619UL) ^ other;
+}
+
+/****************PRIVATE******************/
+
+ResponseCacheManager::Entry* ResponseCacheManager::findEntry(uint32_t key) {
+    for (Entry& entry : entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * The function `release` empties an entry and moves the bodies after it down over its body, so the
+ * bodies stay packed and the free space is always at the end of the buffer.
+ */
+void ResponseCacheManager::release(Entry& entry) {
+    if (entry.length > 0) {
+        size_t end = entry.offset + entry.length;
+        memmove(buffer + entry.offset, buffer + end, getSize() - end);
+        for (Entry& other : entries) {
+            if (other.length > 0 && other.offset > entry.offset) {
+                other.offset -= entry.length;
+            }
+        }
+    }
+    entry.key = 0;
+    entry.usedAt = 0;
+    entry.offset = 0;
+    entry.length = 0;
+}
@@ -0,0 +1,52 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the response cache. Read endpoints whose output only changes on a schedule update, a
+new system message or a minute tick keep their last serialized body together with the version of the
+data it was built from, and send it again without building it while the version is unchanged. The
+bodies live in one fixed buffer, packed one after the other, so caching never touches the heap.
+*/
+
+#ifndef ResponseCacheManager_h
+#define ResponseCacheManager_h
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+#include "web/WebServerManager.h"
+
+class ResponseCacheManager {
+public:
+    static constexpr uint8_t MAX_ENTRIES = 6;
+    static constexpr size_t MAX_BYTES = 6144; // Size of the body buffer, the least recently used bodies are dropped
+
+    ResponseCacheManager();
+    bool send(WebServerManager& server, uint32_t key, uint32_t version);
+    uint8_t* store(uint32_t key, uint32_t version, const char* contentType, size_t length);
+    void clear();
+    uint32_t getHitCount();
+    uint32_t getMissCount();
+    size_t getSize();
+
+    static uint32_t combine(uint32_t version, uint32_t other);
+
+private:
+    struct Entry {
+        uint32_t key; // Hash of the path, arguments and format of the request, 0 if the entry is empty
+        uint32_t version; // Version of the data the body was built from
+        const char* contentType; // String literal
+        size_t offset; // Start of the body in `buffer`
+        size_t length; // Length of the body
+        unsigned long usedAt; // millis() of the last use
+    };
+
+    Entry* findEntry(uint32_t key);
+    void release(Entry& entry);
+
+    Entry entries[MAX_ENTRIES];
+    uint8_t buffer[MAX_BYTES]; // Bodies packed from the start, `getSize()` bytes are in use
+    uint32_t hits;
+    uint32_t misses;
+};
+
+#endif
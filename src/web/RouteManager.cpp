@@ -0,0 +1,188 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the dispatch of HTTP requests through the route table in Endpoints.cpp.
+*/
+
+#include "RouteManager.h"
+
+#include <algorithm>
+
+#include "web/Endpoints.h"
+
+/**
+ * The constructor indexes a route table. The hashes in the table were computed by the compiler, here they
+ * are only sorted so a request is found by binary search.
+ *
+ * @param routes The route table, it must stay valid for the lifetime of the object.
+ * @param count Number of routes in the table.
+ */
+RouteManager::RouteManager(const Route* routes, uint8_t count) : routes(routes), current(nullptr), bodyAuthorized(false),
+                                                                currentDeferred(false),
+                                                                respondedAt(0), respondedPort(0), respondedSecure(false) {
+    slots.reserve(count);
+    for (uint8_t route = 0; route < count; route++) {
+        slots.push_back({routes[route].hash, route});
+    }
+
+    std::sort(slots.begin(), slots.end(), [](const Slot& a, const Slot& b) {
+        return a.hash < b.hash;
+    });
+}
+
+/**
+ * The function `canHandle` is called by either server for every request, it looks the route up and keeps it
+ * for the calls that follow. The request arena is emptied here, before a request body arrives. Whether
+ * the request is put off for a ring is decided here too, so its body and its answer agree.
+ *
+ * @return `true` if the table has a route for the method and path.
+ */
+bool RouteManager::canHandle(HTTPMethod method, const String& uri) {
+    current = findRoute(method, uri);
+    if (current != nullptr) {
+        arenaManager.beginRequest();
+        currentDeferred = current->guard == GUARD_DEFER && ringGuardManager.isOpen();
+    }
+    return current != nullptr;
+}
+
+/**
+ * The function `canRaw` tells the server whether the route wants the request body handed over while it
+ * arrives instead of collected in the "plain" argument.
+ */
+bool RouteManager::canRaw(const String& uri) {
+    return current != nullptr && current->body != nullptr && uri == current->path;
+}
+
+/**
+ * The function `handle` answers a request. A route that would block the CPU close to a ring is answered
+ * with 503 and the time to retry after. Once HTTPS runs, a token or password sent over plain HTTP is
+ * refused with 403 and a page requested over plain HTTP is redirected, so the browser only sends them
+ * encrypted. The authorization check is done here once for all routes that need it, then the response
+ * headers of the route's response type are set and the handler runs. When the response is sent,
+ * everything the request allocated in the arena is given back.
+ *
+ * @return `true`, the request was answered.
+ */
+bool RouteManager::handle(HTTPMethod method, const String& uri) {
+    const Route* route = current != nullptr && uri == current->path ? current : findRoute(method, uri);
+    bool deferred = route == current ? currentDeferred : route != nullptr && route->guard == GUARD_DEFER && ringGuardManager.isOpen();
+    current = nullptr;
+    if (route == nullptr) {
+        return false;
+    }
+
+    if (deferred) {
+        ringGuardManager.countRejected();
+        server.sendHeader("Retry-After", String(max<uint32_t>(ringGuardManager.getRetryAfter(), 1)));
+        server.send(503, "text/plain", "Ringing, please retry shortly");
+    } else if (needsHttps(route) && route->response == RESPONSE_PAGE) {
+        redirectToHttps(uri);
+    } else if (needsHttps(route)) {
+        server.send(403, "text/plain", "HTTPS required");
+    } else if (route->auth == AUTH_TOKEN && !authManager.checkToken(server.header("Authorization"))) {
+        server.send(401, "text/plain", "Unauthorized");
+    } else if (route->response == RESPONSE_ASSET) {
+        sendAsset(route->path);
+    } else {
+        if (route->response == RESPONSE_NEGOTIATED) {
+            server.sendHeader("Vary", "Accept");
+        }
+        route->handler();
+    }
+
+    arenaManager.endRequest();
+    respondedAt = millis();
+    respondedPort = server.client().remotePort();
+    respondedSecure = server.isSecureRequest();
+    return true;
+}
+
+/**
+ * The function `raw` hands the request body to the route piece by piece. The headers have arrived before
+ * the body, so the authorization is checked at the start and the body of a request that will be rejected,
+ * refused over plain HTTP or put off for a ring, is dropped.
+ */
+void RouteManager::raw(const String& uri, HTTPRaw& raw) {
+    if (current == nullptr || current->body == nullptr) {
+        return;
+    }
+
+    if (raw.status == RAW_START) {
+        bodyAuthorized = !currentDeferred && !needsHttps(current) &&
+                         (current->auth != AUTH_TOKEN || authManager.checkToken(server.header("Authorization")));
+    }
+    if (bodyAuthorized || raw.status == RAW_ABORTED) {
+        current->body();
+    }
+}
+
+/**
+ * The function `closeIdleConnection` closes a kept alive connection that has been answered and sent no
+ * new request for a short while. The server handles one connection at a time and would otherwise wait
+ * seconds for the next request on it, while a browser sends the page's other requests on new connections.
+ * A connection that has not been answered yet is left alone.
+ */
+void RouteManager::closeIdleConnection() {
+    WiFiClient& client = server.connection(respondedSecure);
+    if (!client.connected() || client.available() > 0 || client.remotePort() != respondedPort) {
+        return;
+    }
+
+    if (millis() - respondedAt >= KEEP_ALIVE_IDLE) {
+        client.stop();
+        respondedPort = 0;
+    }
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `findRoute` looks a request up in the table.
+ *
+ * @return The route, or nullptr if no route has the path and method.
+ */
+const Route* RouteManager::findRoute(HTTPMethod method, const String& uri) const {
+    uint32_t hash = routeHash(uri.c_str());
+    auto slot = std::lower_bound(slots.begin(), slots.end(), hash, [](const Slot& a, uint32_t value) {
+        return a.hash < value;
+    });
+
+    for (; slot != slots.end() && slot->hash == hash; ++slot) {
+        const Route& route = routes[slot->route];
+        if ((route.method == HTTP_ANY || route.method == method) && uri == route.path) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * The function `needsHttps` tells if a request has to be sent again over HTTPS: HTTPS runs, the request
+ * arrived over plain HTTP, and the route takes a token or password or is a page whose scripts send them.
+ */
+bool RouteManager::needsHttps(const Route* route) {
+    if (!server.isSecureRunning() || server.isSecureRequest()) {
+        return false;
+    }
+    return route->auth != AUTH_NONE || route->response == RESPONSE_PAGE;
+}
+
+/**
+ * The function `redirectToHttps` sends a temporary redirect (307) to the same path on the HTTPS server.
+ * Browsers do not cache it, so the HTTP pages work again once the certificate is removed, and the method
+ * and body of a POST are kept. The host the client asked for is kept, without its port.
+ */
+void RouteManager::redirectToHttps(const String& uri) {
+    String host = server.hostHeader();
+    int colon = host.indexOf(':');
+    if (colon >= 0) {
+        host = host.substring(0, colon);
+    }
+    if (host.length() == 0) {
+        host = WiFi.localIP().toString();
+    }
+
+    server.sendHeader("Location", "https://" + host + uri);
+    server.send(307, "text/plain", "Moved to HTTPS");
+}
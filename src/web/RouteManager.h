@@ -0,0 +1,106 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the dispatch of HTTP requests. All endpoints are listed in one table with their method,
+path, authorization and response type, and a single request handler finds the route of a request by the
+hash of its path, so the cost of a lookup does not grow with the number of endpoints. The HTTP and HTTPS
+servers share the table.
+*/
+
+#ifndef RouteManager_h
+#define RouteManager_h
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <vector>
+
+#include "board/ArenaManager.h"
+#include "web/AuthManager.h"
+#include "web/WebServerManager.h"
+#include "schedule/RingGuardManager.h"
+
+extern AuthManager authManager;
+extern WebServerManager server;
+
+/**
+ * The function `routeHash` computes the FNV-1a hash of a path. It is evaluated by the compiler for the
+ * paths in the route table and at run time for the path of a request.
+ */
+constexpr uint32_t routeHash(const char* path) {
+    uint32_t result = 2166136261UL;
+    for (; *path != 0; path++) {
+        result = (result ^ (uint8_t)*path) * 16777619UL;
+    }
+    return result;
+}
+
+// Who may call a route
+enum RouteAuth : uint8_t {
+    AUTH_NONE, // Anyone
+    AUTH_TOKEN, // A valid token in the Authorization header, checked before the handler runs
+    AUTH_PASSWORD // Anyone, the request carries a password (login)
+};
+
+// What a route answers with
+enum RouteResponse : uint8_t {
+    RESPONSE_TEXT, // Plain text or JSON built by the handler
+    RESPONSE_PAGE, // HTML page built by the handler, redirected to HTTPS once it runs
+    RESPONSE_NEGOTIATED, // JSON or MessagePack depending on the Accept header, sent with Vary: Accept
+    RESPONSE_ASSET // The file with the route's path in the compiled in web archive, there is no handler
+};
+
+// What a route does close to a ring
+enum RouteGuard : uint8_t {
+    GUARD_NONE, // Answered any time
+    GUARD_DEFER // Blocks the CPU (flash writes, password hashing, large files), answered with 503 in the ring guard window
+};
+
+struct Route {
+    uint32_t hash; // routeHash(path)
+    const char* path;
+    HTTPMethod method; // HTTP_ANY matches every method
+    RouteAuth auth;
+    RouteResponse response;
+    RouteGuard guard;
+    void (*handler)(); // Sends the response
+    void (*body)(); // Receives the raw request body while it arrives (server.raw()), or nullptr
+};
+
+// Route table entry, the hash of the path is computed at compile time
+#define ROUTE(path, method, auth, response, guard, handler, body) \
+    Route{routeHash(path), path, method, auth, response, guard, handler, body}
+
+class RouteManager {
+public:
+    RouteManager(const Route* routes, uint8_t count);
+
+    bool canHandle(HTTPMethod method, const String& uri);
+    bool canRaw(const String& uri);
+    bool handle(HTTPMethod method, const String& uri);
+    void raw(const String& uri, HTTPRaw& raw);
+    void closeIdleConnection();
+
+private:
+    static constexpr uint32_t KEEP_ALIVE_IDLE = 300; // A kept alive connection without a new request is closed after this (ms)
+
+    // Index slot sorted by hash, routes with the same path (e.g. POST and PUT) are next to each other
+    struct Slot {
+        uint32_t hash;
+        uint8_t route;
+    };
+
+    const Route* findRoute(HTTPMethod method, const String& uri) const;
+    static bool needsHttps(const Route* route);
+    static void redirectToHttps(const String& uri);
+
+    const Route* routes;
+    std::vector<Slot> slots;
+    const Route* current; // Route of the request being received
+    bool bodyAuthorized; // The request whose body is being received passed the authorization check
+    bool currentDeferred; // The request of `current` arrived in the ring guard window and is answered with 503
+    unsigned long respondedAt; // millis() when the last response was sent
+    uint16_t respondedPort; // Remote port of the connection the last response was sent on
+    bool respondedSecure; // The last response was sent by the HTTPS server
+};
+
+#endif
@@ -0,0 +1,297 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the HTTP and HTTPS servers and the TLS certificate, session cache and handshake metrics.
+*/
+
+#include "WebServerManager.h"
+
+#include "web/RouteManager.h"
+
+TlsServer::TlsServer(uint16_t port) : BearSSL::WiFiServerSecure(port), handshakeCount(0), fastHandshakeCount(0),
+                                      failedHandshakeCount(0), lastHandshakeMillis(0), maxHandshakeMillis(0),
+                                      totalHandshakeMillis(0) {}
+
+/**
+ * The function `accept` is called by the server when it is ready for a new connection. A waiting
+ * connection is accepted and its TLS handshake runs to completion here, so the time spent is the cost of
+ * the handshake.
+ *
+ * @return The connection, not connected if there was none or the handshake failed.
+ */
+BearSSL::WiFiClientSecure TlsServer::accept() {
+    if (!hasClient()) {
+        return BearSSL::WiFiClientSecure();
+    }
+
+    unsigned long start = millis();
+    BearSSL::WiFiClientSecure client = BearSSL::WiFiServerSecure::accept();
+    uint32_t elapsed = millis() - start;
+
+    if (!client.connected()) {
+        failedHandshakeCount++;
+        return client;
+    }
+
+    handshakeCount++;
+    if (elapsed < FAST_HANDSHAKE) {
+        fastHandshakeCount++;
+    }
+    lastHandshakeMillis = elapsed;
+    maxHandshakeMillis = max(maxHandshakeMillis, elapsed);
+    totalHandshakeMillis += elapsed;
+    return client;
+}
+
+/**
+ * The handshake metrics count the completed and failed handshakes and how long they took, and the
+ * handshakes faster than FAST_HANDSHAKE. BearSSL does not tell if a handshake resumed a session, so the
+ * fast count is a timing figure, not a count of resumptions.
+ */
+uint32_t TlsServer::getHandshakeCount() {
+    return handshakeCount;
+}
+
+uint32_t TlsServer::getFastHandshakeCount() {
+    return fastHandshakeCount;
+}
+
+uint32_t TlsServer::getFailedHandshakeCount() {
+    return failedHandshakeCount;
+}
+
+uint32_t TlsServer::getLastHandshakeMillis() {
+    return lastHandshakeMillis;
+}
+
+uint32_t TlsServer::getMaxHandshakeMillis() {
+    return maxHandshakeMillis;
+}
+
+uint32_t TlsServer::getAverageHandshakeMillis() {
+    return handshakeCount == 0 ? 0 : totalHandshakeMillis / handshakeCount;
+}
+
+WebServerManager::WebServerManager() : http(HTTP_PORT), https(HTTPS_PORT), sessions(SESSION_CACHE_SIZE), started(false),
+                                       secureRunning(false), secureRequest(false) {}
+
+/**
+ * The `begin` function starts the HTTP server, and the HTTPS server if a certificate was installed. It is
+ * called once the network is up, LittleFS must be mounted.
+ */
+void WebServerManager::begin() {
+    http.begin();
+    started = true;
+
+    String certificate = readFile(CERTIFICATE_PATH);
+    String key = readFile(KEY_PATH);
+    if (certificate.length() == 0 || key.length() == 0) {
+        return;
+    }
+
+    if (startSecure(certificate, key)) {
+        eepromManager.addSystemMessage("HTTPS server started.");
+    } else {
+        eepromManager.addSystemMessage("HTTPS certificate is not valid, HTTPS disabled.");
+    }
+}
+
+/**
+ * The `handleClient` function serves both servers, one after the other. Each handles at most one request
+ * per call, and the handlers are told which server it arrived on.
+ *
+ * @param secure `false` to leave the HTTPS server alone, its connections wait in the backlog. Accepting a
+ * new connection runs the TLS handshake, which blocks for up to a second.
+ */
+void WebServerManager::handleClient(bool secure) {
+    if (!started) {
+        return;
+    }
+
+    secureRequest = false;
+    http.handleClient();
+
+    if (secureRunning && secure) {
+        secureRequest = true;
+        https.handleClient();
+        secureRequest = false;
+    }
+}
+
+/**
+ * The function `addRoutes` lets both servers answer from the route table.
+ */
+void WebServerManager::addRoutes(RouteManager& routes) {
+    http.addHandler(new RouteHandler<WiFiServer>(routes));
+    https.addHandler(new RouteHandler<TlsServer>(routes));
+}
+
+void WebServerManager::collectHeaders(const char* headerKeys[], size_t count) {
+    http.collectHeaders(headerKeys, count);
+    https.collectHeaders(headerKeys, count);
+}
+
+void WebServerManager::keepAlive(bool keepAlive) {
+    http.keepAlive(keepAlive);
+    https.keepAlive(keepAlive);
+}
+
+void WebServerManager::onNotFound(const ESP8266WebServer::THandlerFunction& handler) {
+    http.onNotFound(handler);
+    https.onNotFound(handler);
+}
+
+/**
+ * The function `setCertificate` installs the certificate and private key of the HTTPS server and saves
+ * them on LittleFS. The key must be an ECDSA key: the handshake then costs an ECDHE key exchange and an
+ * ECDSA signature on the P-256 curve, which is much faster on the ESP8266 than RSA. The certificate must be
+ * self signed or issued by an ECDSA key. Connections already open keep the old certificate.
+ *
+ * @param certificate The certificate chain in PEM format, or empty to remove the certificate and stop HTTPS.
+ * @param key The private key in PEM format, or empty.
+ *
+ * @return `false` if the certificate or key is not valid or could not be saved.
+ */
+bool WebServerManager::setCertificate(const String& certificate, const String& key) {
+    if (certificate.length() == 0 && key.length() == 0) {
+        LittleFS.remove(CERTIFICATE_PATH);
+        LittleFS.remove(KEY_PATH);
+        if (secureRunning) {
+            https.close();
+            secureRunning = false;
+        }
+        return true;
+    }
+
+    if (!startSecure(certificate, key)) {
+        return false;
+    }
+    return writeFile(CERTIFICATE_PATH, certificate) && writeFile(KEY_PATH, key);
+}
+
+bool WebServerManager::isSecureRunning() {
+    return secureRunning;
+}
+
+bool WebServerManager::isSecureRequest() {
+    return secureRequest;
+}
+
+/**
+ * The function `connection` returns the connection one of the servers is serving, or would serve next.
+ *
+ * @param secure `true` for the HTTPS server.
+ */
+WiFiClient& WebServerManager::connection(bool secure) {
+    if (secure) {
+        return https.client();
+    }
+    return http.client();
+}
+
+/**
+ * The function `hasPendingClient` tells if a new connection waits to be accepted by one of the servers.
+ */
+bool WebServerManager::hasPendingClient() {
+    if (!started) {
+        return false;
+    }
+    return http.getServer().hasClient() || (secureRunning && https.getServer().hasClient());
+}
+
+/**
+ * The function `isClientConnected` tells if a client keeps a connection to one of the servers open, e.g.
+ * a browser between the requests of a page.
+ */
+bool WebServerManager::isClientConnected() {
+    return http.client().connected() || (secureRunning && https.client().connected());
+}
+
+TlsServer& WebServerManager::getTlsServer() {
+    return https.getServer();
+}
+
+/****************PRIVATE******************/
+
+/**
+ * The function `startSecure` parses the certificate and key and hands them to the TLS listener, which
+ * starts listening the first time. The previous certificate and key are kept until the next change, a
+ * connection that was accepted with them may still be open.
+ *
+ * @return `false` if the certificate or key could not be parsed, or the key is not an ECDSA key.
+ */
+bool WebServerManager::startSecure(const String& certificate, const String& key) {
+    std::unique_ptr<BearSSL::X509List> chain(new BearSSL::X509List(certificate.c_str()));
+    std::unique_ptr<BearSSL::PrivateKey> newKey(new BearSSL::PrivateKey(key.c_str()));
+    if (chain->getCount() == 0 || !newKey->isEC()) {
+        return false;
+    }
+
+    previousChain = std::move(certificateChain);
+    previousKey = std::move(privateKey);
+    certificateChain = std::move(chain);
+    privateKey = std::move(newKey);
+
+    TlsServer& listener = https.getServer();
+    listener.setECCert(certificateChain.get(), BR_KEYTYPE_EC, privateKey.get());
+    listener.setCache(&sessions); // Returning clients resume their session and skip the key exchange
+
+    if (!secureRunning) {
+        https.begin();
+        secureRunning = true;
+    }
+    return true;
+}
+
+/**
+ * The function `readFile` reads a small file from LittleFS.
+ *
+ * @return The content, or an empty string if the file does not exist.
+ */
+String WebServerManager::readFile(const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return "";
+    }
+    String content = file.readString();
+    file.close();
+    return content;
+}
+
+/**
+ * The function `writeFile` replaces a small file on LittleFS.
+ *
+ * @return `false` if the file could not be written completely.
+ */
+bool WebServerManager::writeFile(const char* path, const String& content) {
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        return false;
+    }
+    bool written = file.write((const uint8_t*)content.c_str(), content.length()) == content.length();
+    file.close();
+    return written;
+}
+
+template <typename ServerType>
+bool RouteHandler<ServerType>::canHandle(HTTPMethod method, const String& uri) {
+    return routes.canHandle(method, uri);
+}
+
+template <typename ServerType>
+bool RouteHandler<ServerType>::canRaw(const String& uri) {
+    return routes.canRaw(uri);
+}
+
+template <typename ServerType>
+bool RouteHandler<ServerType>::handle(WebServerType& server, HTTPMethod method, const String& uri) {
+    return routes.handle(method, uri);
+}
+
+template <typename ServerType>
+void RouteHandler<ServerType>::raw(WebServerType& server, const String& uri, HTTPRaw& raw) {
+    routes.raw(uri, raw);
+}
+
+template class RouteHandler<WiFiServer>;
+template class RouteHandler<TlsServer>;
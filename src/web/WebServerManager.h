@@ -0,0 +1,159 @@
+/*
+Quinton Nelson
+10/19/2026
+This file handles the web servers. Requests arrive over plain HTTP on port 80 and, once a certificate is
+installed, over HTTPS on port 443, so passwords and tokens need not cross the network in cleartext. Both
+servers answer from the same route table, the handlers talk to whichever server received the request.
+*/
+
+#ifndef WebServerManager_h
+#define WebServerManager_h
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266WebServer.h>
+#include <LittleFS.h>
+#include <memory>
+#include <utility>
+
+#include "board/EEPROMLayoutManager.h"
+
+class RouteManager;
+
+extern EEPROMLayoutManager eepromManager;
+
+/*
+The TLS listener of the HTTPS server. It times the handshake of every connection it accepts, the handshake
+runs while the connection is accepted. A full handshake costs an ECDHE key exchange and an ECDSA signature,
+a client that resumes a session from the session cache skips both.
+*/
+class TlsServer : public BearSSL::WiFiServerSecure {
+public:
+    using ClientType = BearSSL::WiFiClientSecure;
+
+    explicit TlsServer(uint16_t port);
+    BearSSL::WiFiClientSecure accept();
+
+    uint32_t getHandshakeCount();
+    uint32_t getFastHandshakeCount();
+    uint32_t getFailedHandshakeCount();
+    uint32_t getLastHandshakeMillis();
+    uint32_t getMaxHandshakeMillis();
+    uint32_t getAverageHandshakeMillis();
+
+    static constexpr uint32_t FAST_HANDSHAKE = 100; // Handshakes faster than this (ms) are counted as fast
+
+private:
+    uint32_t handshakeCount;
+    uint32_t fastHandshakeCount; // Handshakes faster than FAST_HANDSHAKE
+    uint32_t failedHandshakeCount;
+    uint32_t lastHandshakeMillis;
+    uint32_t maxHandshakeMillis;
+    uint64_t totalHandshakeMillis;
+};
+
+class WebServerManager {
+public:
+    static constexpr uint16_t HTTP_PORT = 80;
+    static constexpr uint16_t HTTPS_PORT = 443;
+    static constexpr uint8_t SESSION_CACHE_SIZE = 8; // TLS sessions kept for resumption, about 100 bytes each
+
+    WebServerManager();
+    void begin();
+    void handleClient(bool secure = true);
+    void addRoutes(RouteManager& routes);
+    void collectHeaders(const char* headerKeys[], size_t count);
+    void keepAlive(bool keepAlive);
+    void onNotFound(const ESP8266WebServer::THandlerFunction& handler);
+
+    bool setCertificate(const String& certificate, const String& key);
+    bool isSecureRunning();
+    bool isSecureRequest();
+    WiFiClient& connection(bool secure);
+    bool hasPendingClient();
+    bool isClientConnected();
+    TlsServer& getTlsServer();
+
+    // The request being handled, forwarded to the server that received it
+    decltype(auto) uri() { return secureRequest ? https.uri() : http.uri(); }
+    decltype(auto) hostHeader() { return secureRequest ? https.hostHeader() : http.hostHeader(); }
+    HTTPMethod method() { return secureRequest ? https.method() : http.method(); }
+    int args() { return secureRequest ? https.args() : http.args(); }
+    WiFiClient& client() { return secureRequest ? https.client() : http.client(); }
+    HTTPRaw& raw() { return secureRequest ? https.raw() : http.raw(); }
+
+    template <typename... Args> decltype(auto) arg(Args&&... args) {
+        return secureRequest ? https.arg(std::forward<Args>(args)...) : http.arg(std::forward<Args>(args)...);
+    }
+    template <typename... Args> decltype(auto) argName(Args&&... args) {
+        return secureRequest ? https.argName(std::forward<Args>(args)...) : http.argName(std::forward<Args>(args)...);
+    }
+    template <typename... Args> bool hasArg(Args&&... args) {
+        return secureRequest ? https.hasArg(std::forward<Args>(args)...) : http.hasArg(std::forward<Args>(args)...);
+    }
+    template <typename... Args> decltype(auto) header(Args&&... args) {
+        return secureRequest ? https.header(std::forward<Args>(args)...) : http.header(std::forward<Args>(args)...);
+    }
+
+    // The response, sent by the server that received the request
+    template <typename... Args> void send(Args&&... args) {
+        secureRequest ? https.send(std::forward<Args>(args)...) : http.send(std::forward<Args>(args)...);
+    }
+    template <typename... Args> void send_P(Args&&... args) {
+        secureRequest ? https.send_P(std::forward<Args>(args)...) : http.send_P(std::forward<Args>(args)...);
+    }
+    template <typename... Args> void sendHeader(Args&&... args) {
+        secureRequest ? https.sendHeader(std::forward<Args>(args)...) : http.sendHeader(std::forward<Args>(args)...);
+    }
+    template <typename... Args> void sendContent(Args&&... args) {
+        secureRequest ? https.sendContent(std::forward<Args>(args)...) : http.sendContent(std::forward<Args>(args)...);
+    }
+    void setContentLength(size_t length) { secureRequest ? https.setContentLength(length) : http.setContentLength(length); }
+    bool chunkedResponseModeStart(int code, const char* contentType) {
+        return secureRequest ? https.chunkedResponseModeStart(code, contentType) : http.chunkedResponseModeStart(code, contentType);
+    }
+    void chunkedResponseFinalize() { secureRequest ? https.chunkedResponseFinalize() : http.chunkedResponseFinalize(); }
+
+private:
+    typedef esp8266webserver::ESP8266WebServerTemplate<TlsServer> SecureServer;
+
+    static constexpr const char* CERTIFICATE_PATH = "/tls/cert.pem";
+    static constexpr const char* KEY_PATH = "/tls/key.pem";
+
+    bool startSecure(const String& certificate, const String& key);
+    static String readFile(const char* path);
+    static bool writeFile(const char* path, const String& content);
+
+    ESP8266WebServer http;
+    SecureServer https;
+    BearSSL::ServerSessions sessions;
+    std::unique_ptr<BearSSL::X509List> certificateChain;
+    std::unique_ptr<BearSSL::PrivateKey> privateKey;
+    std::unique_ptr<BearSSL::X509List> previousChain; // Kept while a connection accepted with it may be open
+    std::unique_ptr<BearSSL::PrivateKey> previousKey;
+    bool started; // begin was called, the network is up
+    bool secureRunning; // The HTTPS server listens
+    bool secureRequest; // The request being handled arrived over HTTPS
+};
+
+/*
+Hands the requests of one of the servers to the route table. The server is not passed on, the handlers
+answer through `WebServerManager`, which knows which server received the request.
+*/
+template <typename ServerType>
+class RouteHandler : public esp8266webserver::RequestHandler<ServerType> {
+public:
+    typedef esp8266webserver::ESP8266WebServerTemplate<ServerType> WebServerType;
+
+    explicit RouteHandler(RouteManager& routes) : routes(routes) {}
+
+    bool canHandle(HTTPMethod method, const String& uri) override;
+    bool canRaw(const String& uri) override;
+    bool handle(WebServerType& server, HTTPMethod method, const String& uri) override;
+    void raw(WebServerType& server, const String& uri, HTTPRaw& raw) override;
+
+private:
+    RouteManager& routes;
+};
+
+#endif
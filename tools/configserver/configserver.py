@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Minimal config server for the bell system pull sync. Serves one JSON document of the form
+{"schedule": {...}, "settings": {...}} with an ETag equal to the FNV-1a hash the firmware uses,
+and answers 304 when the device already has it.
+
+Usage: python3 configserver.py bells.json [port]
+"""
+
+import http.server
+import sys
+
+
+def fnv1a(data):
+    result = 2166136261
+    for byte in data:
+        result = ((result ^ byte) * 16777619) & 0xFFFFFFFF
+    return result
+
+
+class ConfigHandler(http.server.BaseHTTPRequestHandler):
+    path_to_document = None
+
+    def do_GET(self):
+        try:
+            with open(self.path_to_document, "rb") as document:
+                body = document.read()
+        except OSError:
+            self.send_error(404)
+            return
+
+        etag = '"%08x"' % fnv1a(body)
+        if self.headers.get("If-None-Match") == etag:
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.end_headers()
+            return
+
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(2)
+    ConfigHandler.path_to_document = sys.argv[1]
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 8080
+    http.server.ThreadingHTTPServer(("", port), ConfigHandler).serve_forever()
@@ -0,0 +1,618 @@
+/*
+Quinton Nelson
+10/19/2026
+This file is a Linux command line tool that pushes schedules and settings to many bell systems at once.
+Devices are found through the mDNS "_http._tcp" service the firmware advertises (or listed by hand),
+logged in to and updated by a bounded pool of worker threads, with retries and a result per device.
+
+Build:  g++ -std=c++17 -O2 -pthread -o fleetpush tools/fleetpush/fleetpush.cpp
+Usage:  fleetpush [options] [host[:port] ...]
+*/
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/****************OPTIONS******************/
+
+struct Options {
+    std::vector<std::string> hosts; // host[:port] given on the command line or in --hosts
+    bool discover = false; // Find devices with an mDNS query
+    int discoverSeconds = 3; // Time to collect mDNS answers
+    std::string password;
+    std::string scheduleFile; // JSON body for /updateSchedule
+    std::string profile, start, end; // Optional profile arguments for /updateSchedule
+    std::string settingsFile; // JSON body for /saveSettings
+    std::string activeProfile; // Name or "auto" for /setActiveProfile
+    int jobs = 16; // Worker threads
+    int retries = 2; // Extra attempts per request after a network error or a 5xx
+    int timeoutSeconds = 5; // Connect, send and receive timeout per request
+    bool dryRun = false; // Only list the devices
+};
+
+struct Device {
+    std::string name; // Host name or mDNS instance name
+    std::string address; // IPv4 address or host name to connect to
+    int port = 80;
+    std::map<std::string, std::string> txt; // mDNS TXT records, empty for listed hosts
+};
+
+struct Result {
+    bool ok = false;
+    std::string message;
+    long elapsedMillis = 0;
+    int attempts = 0;
+};
+
+struct HttpResponse {
+    int status = 0; // 0 if the request failed before a status line was read
+    std::string body;
+    std::string error;
+};
+
+static void printUsage() {
+    std::cerr <<
+        "Usage: fleetpush [options] [host[:port] ...]\n"
+        "  --discover [seconds]     find devices through mDNS (_http._tcp with a \"ver\" TXT record)\n"
+        "  --hosts FILE             read host[:port] lines from FILE (# starts a comment)\n"
+        "  --password PASS          device password (or FLEETPUSH_PASSWORD)\n"
+        "  --schedule FILE          push FILE to /updateSchedule\n"
+        "  --profile NAME           with --schedule, add or replace the profile NAME\n"
+        "  --start YYYY-MM-DD       with --profile, first day the profile is active\n"
+        "  --end YYYY-MM-DD         with --profile, last day the profile is active\n"
+        "  --settings FILE          push FILE to /saveSettings\n"
+        "  --active-profile NAME    select the active profile (or \"auto\")\n"
+        "  --jobs N                 devices updated at the same time (default 16)\n"
+        "  --retries N              retries after network errors and 5xx (default 2)\n"
+        "  --timeout SECONDS        timeout per request (default 5)\n"
+        "  --dry-run                only list the devices that would be updated\n";
+}
+
+/**
+ * The function `readFile` reads a whole file into a string.
+ *
+ * @return `false` if the file could not be opened.
+ */
+static bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+/**
+ * The function `parseHost` splits "host[:port]" into a device.
+ */
+static Device parseHost(const std::string& text) {
+    Device device;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos && colon + 1 < text.size()) {
+        device.address = text.substr(0, colon);
+        device.port = std::atoi(text.c_str() + colon + 1);
+    } else {
+        device.address = text;
+    }
+    device.name = device.address;
+    return device;
+}
+
+/**
+ * The function `parseOptions` reads the command line.
+ *
+ * @return `false` if an option is unknown or missing its value.
+ */
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](std::string& out) {
+            if (i + 1 >= argc) return false;
+            out = argv[++i];
+            return true;
+        };
+        std::string number;
+
+        if (arg == "--discover") {
+            options.discover = true;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) {
+                options.discoverSeconds = std::atoi(argv[++i]);
+            }
+        } else if (arg == "--hosts") {
+            std::string path, content;
+            if (!value(path) || !readFile(path, content)) {
+                std::cerr << "Cannot read host list\n";
+                return false;
+            }
+            std::istringstream lines(content);
+            std::string line;
+            while (std::getline(lines, line)) {
+                line = line.substr(0, line.find('#'));
+                line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+                if (!line.empty()) options.hosts.push_back(line);
+            }
+        } else if (arg == "--password") {
+            if (!value(options.password)) return false;
+        } else if (arg == "--schedule") {
+            if (!value(options.scheduleFile)) return false;
+        } else if (arg == "--profile") {
+            if (!value(options.profile)) return false;
+        } else if (arg == "--start") {
+            if (!value(options.start)) return false;
+        } else if (arg == "--end") {
+            if (!value(options.end)) return false;
+        } else if (arg == "--settings") {
+            if (!value(options.settingsFile)) return false;
+        } else if (arg == "--active-profile") {
+            if (!value(options.activeProfile)) return false;
+        } else if (arg == "--jobs") {
+            if (!value(number)) return false;
+            options.jobs = std::max(1, std::atoi(number.c_str()));
+        } else if (arg == "--retries") {
+            if (!value(number)) return false;
+            options.retries = std::max(0, std::atoi(number.c_str()));
+        } else if (arg == "--timeout") {
+            if (!value(number)) return false;
+            options.timeoutSeconds = std::max(1, std::atoi(number.c_str()));
+        } else if (arg == "--dry-run") {
+            options.dryRun = true;
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown option " << arg << "\n";
+            return false;
+        } else {
+            options.hosts.push_back(arg);
+        }
+    }
+
+    if (options.password.empty() && std::getenv("FLEETPUSH_PASSWORD") != nullptr) {
+        options.password = std::getenv("FLEETPUSH_PASSWORD");
+    }
+    return true;
+}
+
+/****************HTTP******************/
+
+/**
+ * The function `urlEncode` percent-encodes a query or form value.
+ */
+static std::string urlEncode(const std::string& value) {
+    std::string result;
+    char hex[4];
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            result += c;
+        } else {
+            std::snprintf(hex, sizeof(hex), "%%%02X", c);
+            result += hex;
+        }
+    }
+    return result;
+}
+
+/**
+ * The function `waitFor` waits until the socket is readable or writable.
+ *
+ * @return `false` on timeout or error.
+ */
+static bool waitFor(int fd, short events, int timeoutMillis) {
+    pollfd entry = {fd, events, 0};
+    return poll(&entry, 1, timeoutMillis) == 1 && !(entry.revents & (POLLERR | POLLNVAL));
+}
+
+/**
+ * The function `httpRequest` sends one HTTP/1.0 style request (the connection is closed after the
+ * response) and reads the whole response. The device web server handles one client at a time, so a
+ * short timeout keeps a busy device from holding up a worker.
+ *
+ * @param device The device to connect to.
+ * @param method "GET" or "POST".
+ * @param path Path including the query string.
+ * @param headers Extra header lines, each ending with "\r\n".
+ * @param body Request body, sent with a Content-Length.
+ * @param timeoutMillis Timeout for connecting and for each read or write.
+ *
+ * @return The status and body, or an error message with status 0.
+ */
+static HttpResponse httpRequest(const Device& device, const std::string& method, const std::string& path,
+                                const std::string& headers, const std::string& body, int timeoutMillis) {
+    HttpResponse response;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(device.address.c_str(), std::to_string(device.port).c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        response.error = "cannot resolve " + device.address;
+        return response;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        freeaddrinfo(addresses);
+        response.error = "socket failed";
+        return response;
+    }
+    int connected = connect(fd, addresses->ai_addr, addresses->ai_addrlen);
+    freeaddrinfo(addresses);
+    if (connected != 0 && errno != EINPROGRESS) {
+        response.error = std::string("connect failed: ") + std::strerror(errno);
+        close(fd);
+        return response;
+    }
+    pollfd pending = {fd, POLLOUT, 0};
+    int socketError = 0;
+    socklen_t length = sizeof(socketError);
+    if (poll(&pending, 1, timeoutMillis) != 1 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &socketError, &length) != 0 || socketError != 0) {
+        response.error = socketError != 0 ? std::string("connect failed: ") + std::strerror(socketError) : "connect timed out";
+        close(fd);
+        return response;
+    }
+
+    std::string request = method + " " + path + " HTTP/1.1\r\n"
+                          "Host: " + device.address + "\r\n"
+                          "Connection: close\r\n" + headers +
+                          "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < request.size()) {
+        if (!waitFor(fd, POLLOUT, timeoutMillis)) {
+            response.error = "send timed out";
+            close(fd);
+            return response;
+        }
+        ssize_t count = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (count < 0 && errno != EAGAIN) {
+            response.error = std::string("send failed: ") + std::strerror(errno);
+            close(fd);
+            return response;
+        }
+        sent += count > 0 ? count : 0;
+    }
+
+    std::string raw;
+    char buffer[2048];
+    while (true) {
+        if (!waitFor(fd, POLLIN, timeoutMillis)) {
+            response.error = "receive timed out";
+            close(fd);
+            return response;
+        }
+        ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+        if (count == 0) break;
+        if (count < 0) {
+            if (errno == EAGAIN) continue;
+            response.error = std::string("receive failed: ") + std::strerror(errno);
+            close(fd);
+            return response;
+        }
+        raw.append(buffer, count);
+    }
+    close(fd);
+
+    size_t headerEnd = raw.find("\r\n\r\n");
+    if (raw.compare(0, 5, "HTTP/") != 0 || headerEnd == std::string::npos) {
+        response.error = "malformed response";
+        return response;
+    }
+    response.status = std::atoi(raw.c_str() + raw.find(' ') + 1);
+    response.body = raw.substr(headerEnd + 4);
+    return response;
+}
+
+/****************MDNS DISCOVERY******************/
+
+/**
+ * The function `readName` decodes a (possibly compressed) DNS name starting at `offset`.
+ *
+ * @return `false` if the name runs past the packet or loops.
+ */
+static bool readName(const uint8_t* packet, size_t length, size_t& offset, std::string& name) {
+    name.clear();
+    size_t position = offset;
+    bool jumped = false;
+    for (int labels = 0; labels < 128; labels++) {
+        if (position >= length) return false;
+        uint8_t size = packet[position];
+        if (size == 0) {
+            if (!jumped) offset = position + 1;
+            return true;
+        }
+        if ((size & 0xC0) == 0xC0) {
+            if (position + 1 >= length) return false;
+            if (!jumped) offset = position + 2;
+            position = ((size & 0x3F) << 8) | packet[position + 1];
+            jumped = true;
+            continue;
+        }
+        if (position + 1 + size > length) return false;
+        if (!name.empty()) name += '.';
+        name.append((const char*)packet + position + 1, size);
+        position += 1 + size;
+    }
+    return false;
+}
+
+static uint16_t readWord(const uint8_t* data) {
+    return (data[0] << 8) | data[1];
+}
+
+/**
+ * The function `discoverDevices` sends an mDNS PTR query for "_http._tcp.local" and collects the
+ * answers for a few seconds. Only services with a "ver" TXT record (the firmware status beacon) are
+ * returned, other web servers on the network are ignored.
+ */
+static std::vector<Device> discoverDevices(int seconds) {
+    std::vector<Device> devices;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return devices;
+    }
+
+    // Query: one question, PTR, QU bit set so devices answer by unicast to our port
+    static const char service[] = "_http._tcp.local";
+    std::vector<uint8_t> query = {0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0};
+    std::string label;
+    std::istringstream labels(service);
+    while (std::getline(labels, label, '.')) {
+        query.push_back(label.size());
+        query.insert(query.end(), label.begin(), label.end());
+    }
+    query.insert(query.end(), {0, 0, 12, 0x80, 1});
+
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(5353);
+    inet_pton(AF_INET, "224.0.0.251", &group.sin_addr);
+    sendto(fd, query.data(), query.size(), 0, (sockaddr*)&group, sizeof(group));
+
+    std::map<std::string, std::string> targets; // instance -> host name (SRV)
+    std::map<std::string, int> ports; // instance -> port (SRV)
+    std::map<std::string, std::string> addresses; // host name -> IPv4 (A)
+    std::map<std::string, std::map<std::string, std::string>> txts; // instance -> TXT records
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (true) {
+        long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0 || !waitFor(fd, POLLIN, remaining)) break;
+
+        uint8_t packet[1500];
+        ssize_t length = recv(fd, packet, sizeof(packet), 0);
+        if (length < 12) continue;
+
+        size_t offset = 12;
+        uint16_t questions = readWord(packet + 4);
+        uint16_t records = readWord(packet + 6) + readWord(packet + 8) + readWord(packet + 10);
+        std::string name;
+        bool valid = true;
+        for (uint16_t i = 0; i < questions && valid; i++) {
+            valid = readName(packet, length, offset, name) && offset + 4 <= (size_t)length;
+            offset += 4;
+        }
+        for (uint16_t i = 0; i < records && valid; i++) {
+            if (!readName(packet, length, offset, name) || offset + 10 > (size_t)length) break;
+            uint16_t type = readWord(packet + offset);
+            uint16_t dataLength = readWord(packet + offset + 8);
+            size_t data = offset + 10;
+            if (data + dataLength > (size_t)length) break;
+
+            if (type == 1 && dataLength == 4) { // A
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, packet + data, ip, sizeof(ip));
+                addresses[name] = ip;
+            } else if (type == 33 && dataLength > 6) { // SRV
+                size_t target = data + 6;
+                std::string host;
+                if (readName(packet, length, target, host)) {
+                    ports[name] = readWord(packet + data + 4);
+                    targets[name] = host;
+                }
+            } else if (type == 16) { // TXT
+                for (size_t position = data; position < data + dataLength;) {
+                    uint8_t size = packet[position];
+                    std::string entry((const char*)packet + position + 1, std::min<size_t>(size, data + dataLength - position - 1));
+                    size_t equals = entry.find('=');
+                    if (equals != std::string::npos) {
+                        txts[name][entry.substr(0, equals)] = entry.substr(equals + 1);
+                    }
+                    position += 1 + size;
+                }
+            }
+            offset = data + dataLength;
+        }
+    }
+    close(fd);
+
+    for (const auto& target : targets) {
+        auto txt = txts.find(target.first);
+        auto address = addresses.find(target.second);
+        if (txt == txts.end() || txt->second.count("ver") == 0 || address == addresses.end()) {
+            continue;
+        }
+        Device device;
+        device.name = target.second;
+        device.address = address->second;
+        device.port = ports[target.first];
+        device.txt = txt->second;
+        devices.push_back(device);
+    }
+    return devices;
+}
+
+/****************PUSH******************/
+
+/**
+ * The function `requestWithRetry` sends a request, retrying network errors and 5xx responses with a
+ * growing delay. 4xx responses are final.
+ */
+static HttpResponse requestWithRetry(const Options& options, const Device& device, const std::string& method, const std::string& path,
+                                     const std::string& headers, const std::string& body, Result& result) {
+    HttpResponse response;
+    for (int attempt = 0; attempt <= options.retries; attempt++) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500 << (attempt - 1)));
+        }
+        result.attempts++;
+        response = httpRequest(device, method, path, headers, body, options.timeoutSeconds * 1000);
+        if (response.status != 0 && response.status < 500) {
+            break;
+        }
+    }
+    return response;
+}
+
+/**
+ * The function `pushDevice` logs in to one device and sends every requested update in order: the
+ * schedule, the active profile and then the settings (which may rename the device).
+ */
+static Result pushDevice(const Options& options, const Device& device, const std::string& schedule, const std::string& settings) {
+    Result result;
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&](bool ok, const std::string& message) {
+        result.ok = ok;
+        result.message = message;
+        result.elapsedMillis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+        return result;
+    };
+    auto failed = [](const std::string& step, const HttpResponse& response) {
+        return step + ": " + (response.status == 0 ? response.error : std::to_string(response.status) + " " + response.body);
+    };
+
+    // Log in, the token is sent back as {"token":"..."}
+    HttpResponse login = requestWithRetry(options, device, "POST", "/completeLogin",
+                                          "Content-Type: application/x-www-form-urlencoded\r\n",
+                                          "password=" + urlEncode(options.password), result);
+    size_t key = login.body.find("\"token\":\"");
+    if (login.status != 200 || key == std::string::npos) {
+        return finish(false, failed("login", login));
+    }
+    size_t tokenStart = key + 9;
+    std::string token = login.body.substr(tokenStart, login.body.find('"', tokenStart) - tokenStart);
+    std::string authorization = "Authorization: " + token + "\r\n";
+
+    if (!schedule.empty()) {
+        std::string path = "/updateSchedule";
+        if (!options.profile.empty()) {
+            path += "?profile=" + urlEncode(options.profile);
+            if (!options.start.empty()) path += "&start=" + urlEncode(options.start);
+            if (!options.end.empty()) path += "&end=" + urlEncode(options.end);
+        }
+        HttpResponse response = requestWithRetry(options, device, "POST", path, authorization + "Content-Type: application/json\r\n", schedule, result);
+        if (response.status != 200) {
+            return finish(false, failed("schedule", response));
+        }
+    }
+
+    if (!options.activeProfile.empty()) {
+        HttpResponse response = requestWithRetry(options, device, "POST", "/setActiveProfile",
+                                                 authorization + "Content-Type: application/x-www-form-urlencoded\r\n",
+                                                 "name=" + urlEncode(options.activeProfile), result);
+        if (response.status != 200) {
+            return finish(false, failed("active profile", response));
+        }
+    }
+
+    if (!settings.empty()) {
+        HttpResponse response = requestWithRetry(options, device, "POST", "/saveSettings", authorization + "Content-Type: application/json\r\n", settings, result);
+        if (response.status != 200) {
+            return finish(false, failed("settings", response));
+        }
+    }
+
+    return finish(true, "updated");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::string schedule, settings;
+    if (!options.scheduleFile.empty() && !readFile(options.scheduleFile, schedule)) {
+        std::cerr << "Cannot read " << options.scheduleFile << "\n";
+        return 2;
+    }
+    if (!options.settingsFile.empty() && !readFile(options.settingsFile, settings)) {
+        std::cerr << "Cannot read " << options.settingsFile << "\n";
+        return 2;
+    }
+
+    std::vector<Device> devices;
+    for (const std::string& host : options.hosts) {
+        devices.push_back(parseHost(host));
+    }
+    if (options.discover) {
+        std::vector<Device> found = discoverDevices(options.discoverSeconds);
+        devices.insert(devices.end(), found.begin(), found.end());
+    }
+    if (devices.empty()) {
+        std::cerr << "No devices, list hosts or use --discover\n";
+        printUsage();
+        return 2;
+    }
+
+    if (options.dryRun) {
+        for (const Device& device : devices) {
+            std::printf("%-30s %s:%d", device.name.c_str(), device.address.c_str(), device.port);
+            for (const auto& entry : device.txt) {
+                std::printf(" %s=%s", entry.first.c_str(), entry.second.c_str());
+            }
+            std::printf("\n");
+        }
+        return 0;
+    }
+    if (options.password.empty() || (schedule.empty() && settings.empty() && options.activeProfile.empty())) {
+        std::cerr << "Nothing to push, give --password and --schedule, --settings or --active-profile\n";
+        printUsage();
+        return 2;
+    }
+
+    // Bounded worker pool, each worker takes the next device until all are done
+    std::vector<Result> results(devices.size());
+    std::atomic<size_t> next(0);
+    std::mutex outputMutex;
+    std::vector<std::thread> workers;
+    int workerCount = std::min<int>(options.jobs, devices.size());
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back([&]() {
+            for (size_t index = next++; index < devices.size(); index = next++) {
+                results[index] = pushDevice(options, devices[index], schedule, settings);
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::printf("%-4s %-30s %-21s %5ld ms  %d tries  %s\n", results[index].ok ? "OK" : "FAIL", devices[index].name.c_str(),
+                            (devices[index].address + ":" + std::to_string(devices[index].port)).c_str(),
+                            results[index].elapsedMillis, results[index].attempts, results[index].message.c_str());
+                std::fflush(stdout);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    size_t failures = std::count_if(results.begin(), results.end(), [](const Result& result) { return !result.ok; });
+    std::printf("%zu of %zu devices updated\n", devices.size() - failures, devices.size());
+    return failures == 0 ? 0 : 1;
+}
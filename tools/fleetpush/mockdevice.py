@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Mock bell systems for testing fleetpush without hardware. Starts several devices on consecutive local
+ports, each answering /completeLogin, /updateSchedule, /setActiveProfile and /saveSettings like the
+firmware does: the login answers {"token":"..."}, the other routes need that token in the
+Authorization header. Faults can be injected per device and route: a status code (e.g. 503) or
+"timeout", which holds the request for --hang seconds and closes it unanswered.
+
+Usage: python3 mockdevice.py [--devices N] [--port first-port] [--password PASS] [--hang seconds]
+                             [--delay seconds] [--fault port:path:status|timeout:count ...]
+"""
+
+import argparse
+import http.server
+import threading
+import time
+import urllib.parse
+
+ROUTES = ("/completeLogin", "/updateSchedule", "/setActiveProfile", "/saveSettings")
+
+
+class Device:
+    """State of one mock device: its faults, and the requests it received."""
+
+    def __init__(self, port, password):
+        self.port = port
+        self.password = password
+        self.token = "token-%d" % port
+        self.faults = {}  # path -> [status or "timeout", requests left to fail]
+        self.requests = {route: 0 for route in ROUTES}  # Requests received per route
+        self.bodies = {}  # path -> body of the last request that was answered 200
+
+    def add_fault(self, path, kind, count):
+        self.faults[path] = [kind, count]
+
+    def take_fault(self, path):
+        """Returns the fault for the next request to path, or None, and uses it up."""
+        fault = self.faults.get(path)
+        if fault is None or fault[1] == 0:
+            return None
+        fault[1] -= 1
+        return fault[0]
+
+
+class Fleet:
+    """All mock devices, with a count of the requests being handled at the same time."""
+
+    def __init__(self, count, first_port, password, hang, delay=0.0):
+        self.devices = [Device(first_port + i, password) for i in range(count)]
+        self.hang = hang
+        self.delay = delay  # Seconds every request takes, like a device writing flash
+        self.lock = threading.Lock()
+        self.in_flight = 0
+        self.max_in_flight = 0
+        self.servers = []
+
+    def start(self):
+        for device in self.devices:
+            handler = type("Handler", (DeviceHandler,), {"fleet": self, "device": device})
+            server = http.server.ThreadingHTTPServer(("127.0.0.1", device.port), handler)
+            server.daemon_threads = True
+            threading.Thread(target=server.serve_forever, daemon=True).start()
+            self.servers.append(server)
+
+    def stop(self):
+        for server in self.servers:
+            server.shutdown()
+            server.server_close()
+
+    def enter(self):
+        with self.lock:
+            self.in_flight += 1
+            self.max_in_flight = max(self.max_in_flight, self.in_flight)
+
+    def leave(self):
+        with self.lock:
+            self.in_flight -= 1
+
+
+class DeviceHandler(http.server.BaseHTTPRequestHandler):
+    fleet = None
+    device = None
+
+    def log_message(self, format, *args):
+        pass
+
+    def do_POST(self):
+        self.fleet.enter()
+        try:
+            self.handle_route()
+        finally:
+            self.fleet.leave()
+
+    def handle_route(self):
+        path = urllib.parse.urlsplit(self.path).path
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0))).decode()
+        if path not in ROUTES:
+            self.answer(404, "Not found")
+            return
+
+        with self.fleet.lock:
+            self.device.requests[path] += 1
+            fault = self.device.take_fault(path)
+        if fault == "timeout":
+            # The client has given up long before, so the held request does not count as in flight
+            self.fleet.leave()
+            time.sleep(self.fleet.hang)
+            self.fleet.enter()
+            self.close_connection = True
+            return
+        time.sleep(self.fleet.delay)
+        if fault is not None:
+            self.answer(fault, "Injected fault")
+            return
+
+        if path == "/completeLogin":
+            password = urllib.parse.parse_qs(body).get("password", [""])[0]
+            if password != self.device.password:
+                self.answer(401, "Wrong password")
+                return
+            self.answer(200, '{"token":"%s"}' % self.device.token, "application/json")
+        elif self.headers.get("Authorization") != self.device.token:
+            self.answer(401, "Unauthorized")
+            return
+        else:
+            self.answer(200, "OK")
+
+        with self.fleet.lock:
+            self.device.bodies[path] = body
+
+    def answer(self, status, body, content_type="text/plain"):
+        data = body.encode()
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(data)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(data)
+
+
+def parse_fault(text):
+    """Splits "port:path:status|timeout:count" into its parts."""
+    port, path, kind, count = text.split(":")
+    return int(port), path, kind if kind == "timeout" else int(kind), int(count)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mock bell systems for fleetpush")
+    parser.add_argument("--devices", type=int, default=4)
+    parser.add_argument("--port", type=int, default=18080, help="port of the first device")
+    parser.add_argument("--password", default="secret")
+    parser.add_argument("--hang", type=float, default=10.0, help="seconds a timeout fault holds a request")
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds every request takes")
+    parser.add_argument("--fault", action="append", default=[], type=parse_fault,
+                        help="port:path:status|timeout:count, e.g. 18081:/updateSchedule:503:2")
+    options = parser.parse_args()
+
+    fleet = Fleet(options.devices, options.port, options.password, options.hang, options.delay)
+    for port, path, kind, count in options.fault:
+        fleet.devices[port - options.port].add_fault(path, kind, count)
+    fleet.start()
+    print("%d mock devices on ports %d to %d" % (options.devices, options.port, options.port + options.devices - 1))
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        fleet.stop()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Test of fleetpush against mock devices. Builds fleetpush, starts more mock devices than worker threads
+with injected 5xx answers, timeouts and a wrong password, pushes a schedule and settings to all of them
+and checks each device's result and number of tries, the exit code, the bodies the devices received
+and that no more than --jobs devices were busy at once. A second push to healthy devices only must
+exit with 0. Exits with 1 if any check fails.
+
+Usage: python3 tools/fleetpush/run.py [first-port]
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import mockdevice  # noqa: E402
+
+ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+BINARY = os.path.join(ROOT, "tools", "fleetpush", "fleetpush")
+DEVICES = 10
+JOBS = 3
+RETRIES = 2
+TIMEOUT = 1  # Seconds fleetpush waits per request
+HANG = 3  # Seconds a timeout fault holds a request, longer than TIMEOUT
+DELAY = 0.1  # Seconds every request takes, so the workers overlap
+SCHEDULE = '{"monday":["08:00","08:45"],"friday":["08:00"]}'
+SETTINGS = '{"ringDuration":3}'
+LINE = re.compile(r"^(OK|FAIL)\s+\S+\s+(\S+)\s+\d+ ms\s+(\d+) tries\s+(.*)$")
+
+# Device number -> (faults, wrong password, expected result, expected tries). Every push logs in and
+# sends the schedule and the settings, so a healthy device takes 3 tries.
+CASES = {
+    1: ([("/completeLogin", 503, 1)], False, "OK", 4),
+    2: ([("/updateSchedule", "timeout", 1)], False, "OK", 4),
+    3: ([("/saveSettings", 503, 5)], False, "FAIL", 1 + 1 + (1 + RETRIES)),
+    4: ([], True, "FAIL", 1),  # 401 is final, it is not retried
+    5: ([("/updateSchedule", 500, 2)], False, "OK", 5),
+    6: ([("/saveSettings", "timeout", 1 + RETRIES)], False, "FAIL", 1 + 1 + (1 + RETRIES)),
+}
+
+
+def build():
+    subprocess.run(["g++", "-std=c++17", "-O2", "-pthread", "-o", BINARY,
+                    os.path.join(ROOT, "tools", "fleetpush", "fleetpush.cpp")], check=True)
+
+
+def push(ports, directory):
+    """Runs fleetpush against the given ports and returns its exit code and results by port."""
+    schedule = os.path.join(directory, "schedule.json")
+    settings = os.path.join(directory, "settings.json")
+    with open(schedule, "w") as file:
+        file.write(SCHEDULE)
+    with open(settings, "w") as file:
+        file.write(SETTINGS)
+
+    command = [BINARY, "--password", "secret", "--schedule", schedule, "--settings", settings,
+               "--jobs", str(JOBS), "--retries", str(RETRIES), "--timeout", str(TIMEOUT)]
+    command += ["127.0.0.1:%d" % port for port in ports]
+    process = subprocess.run(command, stdout=subprocess.PIPE, text=True)
+    print(process.stdout, end="")
+
+    results = {}
+    for line in process.stdout.splitlines():
+        match = LINE.match(line)
+        if match:
+            results[int(match.group(2).rsplit(":", 1)[1])] = (match.group(1), int(match.group(3)))
+    return process.returncode, results
+
+
+def main():
+    first_port = int(sys.argv[1]) if len(sys.argv) > 1 else 18180
+    build()
+
+    fleet = mockdevice.Fleet(DEVICES, first_port, "secret", HANG, DELAY)
+    for number, (faults, wrong_password, _, _) in CASES.items():
+        for path, kind, count in faults:
+            fleet.devices[number].add_fault(path, kind, count)
+        if wrong_password:
+            fleet.devices[number].password = "other"
+    fleet.start()
+
+    failures = []
+    with tempfile.TemporaryDirectory() as directory:
+        code, results = push([device.port for device in fleet.devices], directory)
+        if code != 1:
+            failures.append("exit code %d with failed devices, expected 1" % code)
+
+        for number, device in enumerate(fleet.devices):
+            expected = CASES.get(number, ([], False, "OK", 3))[2:]
+            got = results.get(device.port)
+            if got != expected:
+                failures.append("device %d: %s, expected %s" % (number, got, expected))
+            if got and got[0] == "OK" and (device.bodies.get("/updateSchedule") != SCHEDULE or
+                                           device.bodies.get("/saveSettings") != SETTINGS):
+                failures.append("device %d: received other bodies than were pushed" % number)
+            if got and sum(device.requests.values()) != got[1]:
+                failures.append("device %d: %d requests received, fleetpush counted %d" %
+                                (number, sum(device.requests.values()), got[1]))
+
+        if fleet.max_in_flight > JOBS:
+            failures.append("%d requests at once, more than %d jobs" % (fleet.max_in_flight, JOBS))
+        print("at most %d requests at once with %d jobs" % (fleet.max_in_flight, JOBS))
+
+        healthy = [device.port for number, device in enumerate(fleet.devices) if number not in CASES]
+        code, _ = push(healthy, directory)
+        if code != 0:
+            failures.append("exit code %d with only healthy devices, expected 0" % code)
+    fleet.stop()
+
+    for failure in failures:
+        print(failure)
+    print("FAILED" if failures else "OK")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,252 @@
+/*
+Quinton Nelson
+10/19/2026
+This file runs one simulated unit of LAN ring sync on a Linux host. The firmware's LanSyncManager is
+compiled unchanged against the stand-ins in shim/, the units talk over the loopback broadcast address.
+The unit prints the host time its relay would close for the first ring it arms, and exits.
+
+Build:  g++ -std=c++17 -O2 -Itools/lansim/shim -o lansim tools/lansim/lansim.cpp src/network/LanSyncManager.cpp
+Usage:  lansim leader|follower [--offset ms] [--hold-back chance max-ms] [--timeout s]
+*/
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <ctime>
+#include <netinet/in.h>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../src/network/LanSyncManager.h"
+#include "board/RelayManager.h"
+#include "schedule/NTPManager.h"
+#include "schedule/scheduleManager.h"
+
+EEPROMLayoutManager eepromManager;
+RelayManager relayManager;
+TimeManager timeManager;
+NTPManager ntpManager;
+ScheduleManager scheduleManager;
+WiFiClass WiFi;
+
+static double holdBackChance = 0;
+static uint32_t holdBackMillis = 0;
+static std::mt19937 randomEngine(std::random_device{}());
+
+/****************ARDUINO******************/
+
+unsigned long millis() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+String IPAddress::toString() const {
+    in_addr address = {raw()};
+    return String(inet_ntoa(address));
+}
+
+IPAddress WiFiClass::broadcastIP() {
+    return IPAddress(htonl(INADDR_LOOPBACK | 0x00FFFFFF));
+}
+
+void EEPROMLayoutManager::addSystemMessage(const char* message) {
+    fprintf(stderr, "%s\n", message);
+}
+
+bool RelayManager::armRelay(uint32_t delayMillis, uint32_t) {
+    if (armed) {
+        return false;
+    }
+    armed = true;
+    closesAt = TimeManager::hostMillis() + delayMillis;
+    return true;
+}
+
+/****************CLOCK******************/
+
+int64_t TimeManager::hostMillis() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+int64_t TimeManager::getEpochMillis() {
+    tickClock();
+    return hostMillis() + offsetMillis;
+}
+
+void TimeManager::stepClock(int64_t offset) {
+    tickClock();
+    offsetMillis += offset;
+    slewRemaining = 0;
+}
+
+void TimeManager::slewClock(int32_t offset, uint32_t intervalMillis) {
+    tickClock();
+    slewRemaining = offset;
+}
+
+/**
+ * The function `tickClock` applies the pending slew, at most SLEW_RATE ms per elapsed second. Whole
+ * milliseconds are applied once enough time has passed, like the firmware clock.
+ */
+void TimeManager::tickClock() {
+    unsigned long now = millis();
+    int32_t maxSlew = (now - tickedAt) * SLEW_RATE / 1000;
+    if (maxSlew == 0) {
+        return;
+    }
+    int32_t slew = constrain(slewRemaining, -maxSlew, maxSlew);
+    slewRemaining -= slew;
+    offsetMillis += slew;
+    tickedAt = now;
+}
+
+/****************UDP******************/
+
+WiFiUDP::WiFiUDP() : socketFd(-1), targetPort(0) {}
+
+WiFiUDP::~WiFiUDP() {
+    stop();
+}
+
+void WiFiUDP::setHoldBack(double chance, uint32_t maxMillis) {
+    holdBackChance = chance;
+    holdBackMillis = maxMillis;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1;
+    setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)); // Every unit listens on the same port
+    setsockopt(socketFd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(socketFd, (sockaddr*)&address, sizeof(address)) != 0) {
+        perror("bind");
+        exit(2);
+    }
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (socketFd >= 0) {
+        close(socketFd);
+        socketFd = -1;
+    }
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+    target = ip;
+    targetPort = port;
+    outgoing.clear();
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* data, size_t length) {
+    outgoing.insert(outgoing.end(), data, data + length);
+    return length;
+}
+
+int WiFiUDP::endPacket() {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(targetPort);
+    address.sin_addr.s_addr = target.raw();
+    return sendto(socketFd, outgoing.data(), outgoing.size(), 0, (sockaddr*)&address, sizeof(address)) >= 0;
+}
+
+/**
+ * The function `parsePacket` returns the next packet whose hold back time is over.
+ */
+int WiFiUDP::parsePacket() {
+    receive();
+    if (held.empty() || (long)(millis() - held.front().releaseAt) < 0) {
+        return 0;
+    }
+    current = held.front();
+    held.pop_front();
+    return current.data.size();
+}
+
+int WiFiUDP::read(uint8_t* data, size_t length) {
+    size_t count = min(length, current.data.size());
+    memcpy(data, current.data.data(), count);
+    return count;
+}
+
+IPAddress WiFiUDP::remoteIP() {
+    return current.sender;
+}
+
+/**
+ * The function `receive` moves the packets waiting in the socket to the hold back queue.
+ */
+void WiFiUDP::receive() {
+    uint8_t buffer[512];
+    sockaddr_in sender;
+    socklen_t senderLength = sizeof(sender);
+    ssize_t length;
+    while ((length = recvfrom(socketFd, buffer, sizeof(buffer), MSG_DONTWAIT, (sockaddr*)&sender, &senderLength)) > 0) {
+        Held packet;
+        packet.releaseAt = millis();
+        if (std::uniform_real_distribution<double>(0, 1)(randomEngine) < holdBackChance) {
+            packet.releaseAt += std::uniform_int_distribution<uint32_t>(1, holdBackMillis)(randomEngine);
+        }
+        if (!held.empty() && (long)(held.back().releaseAt - packet.releaseAt) > 0) {
+            packet.releaseAt = held.back().releaseAt;
+        }
+        packet.sender = IPAddress(sender.sin_addr.s_addr);
+        packet.data.assign(buffer, buffer + length);
+        held.push_back(packet);
+        senderLength = sizeof(sender);
+    }
+}
+
+/****************MAIN******************/
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: lansim leader|follower [--offset ms] [--hold-back chance max-ms] [--timeout s]\n");
+        return 2;
+    }
+    String mode = argv[1];
+    int timeout = 120;
+    for (int i = 2; i < argc; i++) {
+        String option = argv[i];
+        if (option == "--offset" && i + 1 < argc) {
+            timeManager.setOffset(atoll(argv[++i]));
+        } else if (option == "--hold-back" && i + 2 < argc) {
+            double chance = atof(argv[++i]);
+            WiFiUDP::setHoldBack(chance, atoi(argv[++i]));
+        } else if (option == "--timeout" && i + 1 < argc) {
+            timeout = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 2;
+        }
+    }
+
+    LanSyncManager lanSync;
+    if (!lanSync.setMode(mode)) {
+        fprintf(stderr, "Unknown mode %s\n", mode.c_str());
+        return 2;
+    }
+
+    unsigned long start = millis();
+    while (!relayManager.isArmed()) {
+        if (millis() - start >= (unsigned long)timeout * 1000) {
+            fprintf(stderr, "No ring armed after %d s\n", timeout);
+            return 1;
+        }
+        lanSync.update();
+        usleep(200);
+    }
+
+    printf("%s %lld %d\n", mode.c_str(), (long long)relayManager.getClosesAt(), lanSync.getLastCorrectionMillis());
+    return 0;
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Loopback simulation of LAN ring sync. Builds lansim, starts one leader and several followers on this
+host and checks that they arm their relays for the same instant. Every follower starts with a random
+clock offset of a few seconds, and its broadcasts are randomly held back like an access point does.
+The leader's clock is set so the first ring comes about 55 s after the start, when the followers have
+stepped to the leader and slewed out the rest. Exits with 1 if the relays are further apart than the
+tolerance.
+
+Usage: python3 tools/lansim/run.py [followers] [tolerance-ms]
+"""
+
+import os
+import random
+import subprocess
+import sys
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+BINARY = os.path.join(ROOT, "tools", "lansim", "lansim")
+HOLD_BACK_CHANCE = 0.5  # Share of the broadcasts a follower receives late
+HOLD_BACK_MAX = 40  # Longest hold back (ms)
+FIRST_RING = 55  # Seconds from the start until the leader's clock reaches the next minute
+
+
+def build():
+    subprocess.run(["g++", "-std=c++17", "-O2", "-I" + os.path.join(ROOT, "tools", "lansim", "shim"), "-o", BINARY,
+                    os.path.join(ROOT, "tools", "lansim", "lansim.cpp"),
+                    os.path.join(ROOT, "src", "network", "LanSyncManager.cpp")], check=True)
+
+
+def main():
+    followers = int(sys.argv[1]) if len(sys.argv) > 1 else 4
+    tolerance = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+    build()
+
+    # The leader's clock reads 60 - FIRST_RING seconds past a minute now
+    host = int(time.time() * 1000)
+    leader_offset = ((60 - FIRST_RING) * 1000 - host % 60000) % 60000
+
+    units = []
+    for number in range(followers):
+        offset = leader_offset + random.randint(-3000, 3000)
+        command = [BINARY, "follower", "--offset", str(offset),
+                   "--hold-back", str(HOLD_BACK_CHANCE), str(HOLD_BACK_MAX), "--timeout", "120"]
+        units.append(("follower %d" % (number + 1), subprocess.Popen(command, stdout=subprocess.PIPE, text=True)))
+    units.append(("leader", subprocess.Popen([BINARY, "leader", "--offset", str(leader_offset), "--timeout", "120"],
+                                             stdout=subprocess.PIPE, text=True)))
+
+    instants = {}
+    failed = False
+    for name, process in units:
+        output, _ = process.communicate()
+        if process.returncode != 0 or not output.strip():
+            print("%-11s  no ring armed" % name)
+            failed = True
+            continue
+        _, closes_at, correction = output.split()
+        instants[name] = int(closes_at)
+        print("%-11s  closes at %d  last correction %s ms" % (name, int(closes_at), correction))
+
+    if "leader" in instants:
+        leader = instants["leader"]
+        for name, closes_at in instants.items():
+            if abs(closes_at - leader) > tolerance:
+                failed = True
+        spread = max(instants.values()) - min(instants.values())
+        print("spread %d ms, tolerance %d ms" % (spread, tolerance))
+    else:
+        failed = True
+
+    print("FAILED" if failed else "OK")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
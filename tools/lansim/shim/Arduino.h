@@ -0,0 +1,33 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the Arduino core when the LAN sync code is compiled for the host. Only what
+LanSyncManager uses is provided.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using std::max;
+using std::min;
+
+template <typename T> T constrain(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+unsigned long millis();
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char* text) : std::string(text) {}
+    String(const std::string& text) : std::string(text) {}
+};
+
+#endif
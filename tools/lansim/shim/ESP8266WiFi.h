@@ -0,0 +1,38 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the ESP8266 Wi-Fi library on the host. The station is always connected, and the
+subnet broadcast address is the loopback broadcast address, so every simulated unit on the host hears it.
+*/
+
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include <Arduino.h>
+
+enum wl_status_t { WL_IDLE_STATUS, WL_CONNECTED };
+enum WiFiSleepType_t { WIFI_NONE_SLEEP, WIFI_LIGHT_SLEEP, WIFI_MODEM_SLEEP };
+
+class IPAddress {
+public:
+    IPAddress() : address(0) {}
+    explicit IPAddress(uint32_t address) : address(address) {}
+    bool operator==(const IPAddress& other) const { return address == other.address; }
+    bool operator!=(const IPAddress& other) const { return address != other.address; }
+    uint32_t raw() const { return address; }
+    String toString() const;
+
+private:
+    uint32_t address; // Network byte order
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() { return WL_CONNECTED; }
+    bool setSleepMode(WiFiSleepType_t) { return true; }
+    IPAddress broadcastIP();
+};
+
+extern WiFiClass WiFi;
+
+#endif
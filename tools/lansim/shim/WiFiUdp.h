@@ -0,0 +1,50 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the ESP8266 UDP class on the host, over a POSIX socket. Received packets can be
+held back for a random time before `parsePacket` sees them, like an access point holding broadcasts
+until its next DTIM beacon. Packets are never delivered early.
+*/
+
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include <deque>
+#include <vector>
+
+#include <ESP8266WiFi.h>
+
+class WiFiUDP {
+public:
+    WiFiUDP();
+    ~WiFiUDP();
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t* data, size_t length);
+    int endPacket();
+    int parsePacket();
+    int read(uint8_t* data, size_t length);
+    IPAddress remoteIP();
+
+    // Simulated delay: each packet is held back by `maxMillis` at most, with the given chance (0 to 1)
+    static void setHoldBack(double chance, uint32_t maxMillis);
+
+private:
+    struct Held {
+        unsigned long releaseAt; // millis() when the packet may be read
+        IPAddress sender;
+        std::vector<uint8_t> data;
+    };
+
+    void receive();
+
+    int socketFd;
+    IPAddress target;
+    uint16_t targetPort;
+    std::vector<uint8_t> outgoing;
+    std::deque<Held> held; // In arrival order, a packet never overtakes an earlier one
+    Held current;
+};
+
+#endif
@@ -0,0 +1,19 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the EEPROM layout on the host. Nothing is saved, system messages are printed.
+*/
+
+#ifndef EEPROMLayoutManager_h
+#define EEPROMLayoutManager_h
+
+#include <Arduino.h>
+
+class EEPROMLayoutManager {
+public:
+    void addSystemMessage(const char* message);
+    bool saveLanSyncMode(uint8_t mode) { return true; }
+    uint8_t loadLanSyncMode() { return 0; }
+};
+
+#endif
@@ -0,0 +1,24 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the relay on the host. Arming it records the host time the relay would close.
+*/
+
+#ifndef RelayManager_h
+#define RelayManager_h
+
+#include <Arduino.h>
+
+class RelayManager {
+public:
+    RelayManager() : armed(false), closesAt(0) {}
+    bool armRelay(uint32_t delayMillis, uint32_t ringMinute);
+    bool isArmed() { return armed; }
+    int64_t getClosesAt() { return closesAt; }
+
+private:
+    bool armed;
+    int64_t closesAt; // Host clock (ms since 1970) the relay would close at
+};
+
+#endif
@@ -0,0 +1,17 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for NTP on the host, the simulated units only follow the leader.
+*/
+
+#ifndef NTPManager_h
+#define NTPManager_h
+
+#include "TimeManager.h"
+
+class NTPManager {
+public:
+    void setPaused(bool paused) {}
+};
+
+#endif
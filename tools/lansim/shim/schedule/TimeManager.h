@@ -0,0 +1,38 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the clock on the host. The local clock is the host clock plus a chosen offset,
+and is stepped and slewed like the firmware clock, by at most SLEW_RATE ms per second.
+*/
+
+#ifndef TimeManager_h
+#define TimeManager_h
+
+#include <Arduino.h>
+
+class TimeManager {
+public:
+    static constexpr uint32_t SLEW_RATE = 5; // Same as the firmware
+
+    TimeManager() : offsetMillis(0), slewRemaining(0), tickedAt(0) {}
+    void setOffset(int64_t offset) { offsetMillis = offset; }
+    bool isTimeValid() { return true; }
+    int64_t getEpochMillis();
+    int64_t getMinuteStartMillis() { return getEpochMillis() / 60000 * 60000; }
+    uint16_t getMinuteOfDay() { return getEpochMillis() / 60000 % 1440; }
+    void stepClock(int64_t offset);
+    void slewClock(int32_t offset, uint32_t intervalMillis);
+
+    static int64_t hostMillis();
+
+private:
+    void tickClock();
+
+    int64_t offsetMillis; // Local clock - host clock
+    int32_t slewRemaining;
+    unsigned long tickedAt; // millis() of the last tick
+};
+
+extern TimeManager timeManager;
+
+#endif
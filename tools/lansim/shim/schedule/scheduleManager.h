@@ -0,0 +1,17 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the schedule on the host: the bell rings at the start of every minute.
+*/
+
+#ifndef scheduleManager_h
+#define scheduleManager_h
+
+#include "TimeManager.h"
+
+class ScheduleManager {
+public:
+    uint16_t getNextRingMinute() { return (timeManager.getMinuteOfDay() + 1) % 1440; }
+};
+
+#endif
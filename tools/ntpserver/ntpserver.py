@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Minimal NTP responder for testing the bell system on a network without internet access. Answers every
+client request (mode 3) with a server reply (mode 4, stratum 2) from this computer's clock, shifted by
+--offset seconds, so slewing (small offsets) and stepping (above 30 s) can be tried on a device. The
+device always asks port 123, binding it usually needs root.
+
+Usage: python3 ntpserver.py [--offset seconds] [--port port]
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_UNIX_OFFSET = 2208988800  # Seconds between 1900-01-01 and 1970-01-01
+
+
+def to_ntp(seconds):
+    """Converts Unix time in seconds to a 64 bit NTP timestamp."""
+    seconds += NTP_UNIX_OFFSET
+    whole = int(seconds)
+    return struct.pack("!II", whole & 0xFFFFFFFF, int((seconds - whole) * (1 << 32)) & 0xFFFFFFFF)
+
+
+def reply(request, received, offset):
+    """Builds the reply to a client request, or None if the packet is not one."""
+    if len(request) < 48 or request[0] & 0x07 != 3:
+        return None
+    version = (request[0] >> 3) & 0x07
+    header = struct.pack("!BBbb", (version << 3) | 4, 2, 6, -20)  # LI 0, mode 4, stratum 2, poll 64 s, precision 1 us
+    root = struct.pack("!II", 0, 0) + b"LOCL"  # Root delay, dispersion and reference ID
+    reference = to_ntp(received + offset)
+    originate = request[40:48]  # The client's transmit timestamp, it matches the reply to its request
+    return header + root + reference + originate + to_ntp(received + offset) + to_ntp(time.time() + offset)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Minimal NTP responder")
+    parser.add_argument("--offset", type=float, default=0.0, help="seconds added to this computer's clock")
+    parser.add_argument("--port", type=int, default=123)
+    options = parser.parse_args()
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    server.bind(("", options.port))
+    print("NTP responder on port %d, offset %+.3f s" % (options.port, options.offset))
+
+    while True:
+        request, client = server.recvfrom(512)
+        received = time.time()
+        packet = reply(request, received, options.offset)
+        if packet is not None:
+            server.sendto(packet, client)
+            print("%s  answered %s:%d" % (time.strftime("%H:%M:%S"), client[0], client[1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Packs the web files in data/ into one read-only archive that is compiled into the firmware, so static
+requests are answered straight from flash without LittleFS. Writes src/web/AssetArchive.h with the file
+contents, and a table of paths, offsets, lengths, MIME types and ETags sorted by path.
+
+Runs before every PlatformIO build (extra_scripts in platformio.ini), or by hand:
+    python3 tools/packassets/packassets.py
+The header is only rewritten when its contents change, so unchanged assets do not cause a rebuild.
+"""
+
+import os
+import sys
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".js": "text/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+    ".txt": "text/plain",
+}
+
+
+def fnv1a(data):
+    result = 2166136261
+    for byte in data:
+        result = ((result ^ byte) * 16777619) & 0xFFFFFFFF
+    return result
+
+
+def collect_assets(data_dir):
+    assets = []
+    for root, _, files in os.walk(data_dir):
+        for name in files:
+            full_path = os.path.join(root, name)
+            path = "/" + os.path.relpath(full_path, data_dir).replace(os.sep, "/")
+            with open(full_path, "rb") as asset:
+                assets.append((path, asset.read()))
+    # The firmware looks paths up by binary search, so they are sorted by their bytes
+    assets.sort(key=lambda asset: asset[0].encode())
+    return assets
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def render_header(assets):
+    lines = [
+        "// Generated by tools/packassets/packassets.py from data/, do not edit.",
+        "",
+        "#define ASSET_COUNT %d" % len(assets),
+        "",
+    ]
+
+    # Every file starts on a 4 byte boundary so it can be handed to send_P as it is
+    offsets = []
+    data = bytearray()
+    for _, content in assets:
+        offsets.append(len(data))
+        data += content
+        data += bytes(-len(data) % 4)
+
+    lines.append("static const uint8_t assetData[] PROGMEM __attribute__((aligned(4))) = {")
+    for start in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % byte for byte in data[start:start + 16]) + ",")
+    lines.append("};")
+    lines.append("")
+
+    mime_names = {}
+    for mime in sorted(set(MIME_TYPES.values())) + ["application/octet-stream"]:
+        mime_names[mime] = "assetMime%d" % len(mime_names)
+        lines.append("static const char %s[] PROGMEM = %s;" % (mime_names[mime], c_string(mime)))
+    lines.append("")
+
+    for number, (path, _) in enumerate(assets):
+        lines.append("static const char assetPath%d[] PROGMEM = %s;" % (number, c_string(path)))
+    lines.append("")
+
+    lines.append("static const AssetEntry assetEntries[ASSET_COUNT] PROGMEM = {")
+    for number, (path, content) in enumerate(assets):
+        mime = MIME_TYPES.get(os.path.splitext(path)[1].lower(), "application/octet-stream")
+        lines.append("    {assetPath%d, %s, %d, %d, 0x%08xUL}," % (number, mime_names[mime], offsets[number], len(content), fnv1a(content)))
+    lines.append("};")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def pack(project_dir):
+    data_dir = os.path.join(project_dir, "data")
+    header_path = os.path.join(project_dir, "src", "web", "AssetArchive.h")
+
+    header = render_header(collect_assets(data_dir))
+    try:
+        with open(header_path, "r") as existing:
+            if existing.read() == header:
+                return
+    except OSError:
+        pass
+
+    with open(header_path, "w") as output:
+        output.write(header)
+    print("packassets: wrote %s" % header_path)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    pack(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        pack(sys.argv[1] if len(sys.argv) > 1 else os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")))
@@ -0,0 +1,161 @@
+/*
+Quinton Nelson
+10/19/2026
+This file checks the ring checks of ScheduleManager on a Linux host. The firmware's scheduleManager.cpp
+is compiled unchanged against the stand-ins in shim/, with a simulated clock and a schedule store in
+RAM. The clock is stepped the way the ring task sees it, once per minute change, and the rings, the
+prefetch of tomorrow's rings, the time to the next ring and the CSV import limits are checked. Exits
+with 1 if a check fails.
+
+Build:  g++ -std=c++17 -O2 -Itools/ringsim/shim -Isrc -o ringsim tools/ringsim/ringsim.cpp src/schedule/scheduleManager.cpp src/schedule/CompactSchedule.cpp
+Usage:  ringsim
+*/
+
+// The checks look at the day tables, which are private
+#define private public
+#include "schedule/scheduleManager.h"
+#undef private
+
+EEPROMLayoutManager eepromManager;
+RelayManager relayManager(0);
+TimeManager timeManager;
+ScheduleManager scheduleManager;
+
+static constexpr uint16_t START_DAY = 20000; // 2024-10-04
+static int64_t clockMillis = 0; // Simulated local time, the simulation has no time zone
+static uint32_t loadCount = 0; // Profile reads from "flash"
+static std::vector<uint16_t> rings; // Minutes of the day the relay closed in
+static int failures = 0;
+
+// Rings of the only profile, every day
+static const uint16_t SCHEDULE[] = {0, 8 * 60, 23 * 60 + 30};
+
+/****************ARDUINO******************/
+
+unsigned long millis() {
+    return (unsigned long)clockMillis;
+}
+
+EEPROMLayoutManager::EEPROMLayoutManager() : messageCount(0) {}
+void EEPROMLayoutManager::addSystemMessage(const char*) {}
+uint8_t EEPROMLayoutManager::loadActiveProfile() { return CompactSchedule::NO_PROFILE; }
+size_t EEPROMLayoutManager::loadCompactSchedule(uint8_t*, size_t) { return 0; }
+String EEPROMLayoutManager::loadRingSchedule() { return ""; }
+bool EEPROMLayoutManager::saveActiveProfile(uint8_t) { return true; }
+
+RelayManager::RelayManager(int pin) : relayPin(pin) {}
+
+void RelayManager::activateScheduledRelay(uint32_t) {
+    rings.push_back(timeManager.getMinuteOfDay());
+}
+
+/****************CLOCK******************/
+
+TimeManager::TimeManager() {}
+bool TimeManager::isTimeValid() { return clockMillis > 0; }
+time_t TimeManager::getEpoch() { return clockMillis / 1000; }
+int64_t TimeManager::getEpochMillis() { return clockMillis; }
+uint16_t TimeManager::getDayNumber() { return clockMillis / 86400000; }
+uint16_t TimeManager::getMinuteOfDay() { return clockMillis / 60000 % 1440; }
+int64_t TimeManager::getMinuteStartMillis() { return clockMillis - clockMillis % 60000; }
+
+/****************STORE******************/
+
+// One profile named "default" without a date range, holding SCHEDULE on every day
+ScheduleStoreManager::ScheduleStoreManager() : indexHash(0) {}
+bool ScheduleStoreManager::begin() { return true; }
+uint32_t ScheduleStoreManager::hash() const { return 1; }
+uint32_t ScheduleStoreManager::profileHash(uint8_t) const { return 1; }
+uint8_t ScheduleStoreManager::profileCount() const { return 1; }
+uint8_t ScheduleStoreManager::findProfile(const String& name) const { return name == "default" ? 0 : CompactSchedule::NO_PROFILE; }
+String ScheduleStoreManager::profileName(uint8_t) const { return "default"; }
+uint16_t ScheduleStoreManager::profileStartDay(uint8_t) const { return CompactSchedule::NO_DATE; }
+uint16_t ScheduleStoreManager::profileEndDay(uint8_t) const { return CompactSchedule::NO_DATE; }
+uint8_t ScheduleStoreManager::resolveProfile(uint16_t) const { return 0; }
+bool ScheduleStoreManager::setProfile(const String&, uint16_t, uint16_t, const std::vector<uint8_t>&) { return false; }
+bool ScheduleStoreManager::setProfile(const String&, uint16_t, uint16_t, const CodeWriter&) { return false; }
+bool ScheduleStoreManager::replaceProfiles(const CompactSchedule&) { return false; }
+bool ScheduleStoreManager::replaceProfiles(const std::vector<NewProfile>&) { return false; }
+bool ScheduleStoreManager::removeProfile(uint8_t) { return false; }
+bool ScheduleStoreManager::getRules(uint8_t, std::vector<RingRule>&) { return true; }
+
+bool ScheduleStoreManager::loadDay(uint8_t, uint8_t, uint8_t* bitmap, bool) {
+    loadCount++;
+    memset(bitmap, 0, CompactSchedule::DAY_BYTES);
+    for (uint16_t minute : SCHEDULE) {
+        bitmap[minute / 8] |= 1 << (minute % 8);
+    }
+    return true;
+}
+
+/****************CHECKS******************/
+
+static void check(bool passed, const char* what) {
+    printf("%-4s %s\n", passed ? "OK" : "FAIL", what);
+    if (!passed) failures++;
+}
+
+/**
+ * The function `setClock` sets the simulated clock and runs the ring check the way the ring task does,
+ * once when the minute changed.
+ */
+static void setClock(uint16_t day, uint16_t minute, uint8_t second = 0) {
+    int64_t previousMinute = clockMillis / 60000;
+    clockMillis = ((int64_t)day * 1440 + minute) * 60000 + second * 1000;
+    if (clockMillis / 60000 != previousMinute) {
+        scheduleManager.handleRing();
+    }
+}
+
+int main() {
+    const uint16_t prefetchMinute = ScheduleManager::PREFETCH_MINUTE;
+
+    // Minute by minute up to the prefetch minute, tomorrow's rings are read there and not before
+    setClock(START_DAY, prefetchMinute - 5);
+    for (uint16_t minute = prefetchMinute - 4; minute < prefetchMinute; minute++) {
+        setClock(START_DAY, minute);
+    }
+    check(scheduleManager.tomorrowRings.day != START_DAY + 1, "tomorrow's rings are not read before the prefetch minute");
+    uint32_t loadsBefore = loadCount;
+    setClock(START_DAY, prefetchMinute);
+    check(scheduleManager.tomorrowRings.day == START_DAY + 1, "tomorrow's rings are read at the prefetch minute");
+    check(loadCount == loadsBefore + 1, "tomorrow's rings are read once");
+
+    // After today's last ring the next ring is tomorrow's first
+    setClock(START_DAY, 23 * 60 + 30);
+    setClock(START_DAY, 23 * 60 + 31, 20);
+    check(scheduleManager.getSecondsToNextRing() == 29 * 60 - 20, "the next ring after today's last is tomorrow's at 00:00");
+
+    // Midnight uses the prefetched table, the 00:00 ring needs no flash access
+    loadsBefore = loadCount;
+    for (uint16_t minute = 23 * 60 + 32; minute < 1440; minute++) {
+        setClock(START_DAY, minute);
+    }
+    setClock(START_DAY + 1, 0);
+    check(loadCount == loadsBefore, "midnight reads nothing from flash");
+    check(rings.size() == 2 && rings[0] == 23 * 60 + 30 && rings[1] == 0, "23:30 and 00:00 ring once each");
+
+    // A step forward over 08:00 rings once, a step back does not ring it again
+    setClock(START_DAY + 1, 7 * 60 + 58);
+    setClock(START_DAY + 1, 8 * 60 + 3);
+    check(rings.size() == 3 && rings[2] == 8 * 60 + 3, "a step over 08:00 rings once");
+    setClock(START_DAY + 1, 7 * 60 + 59);
+    setClock(START_DAY + 1, 8 * 60);
+    check(rings.size() == 3, "a step back does not ring 08:00 again");
+
+    // A CSV import keeps one week bitmap per profile and refuses more profiles than it has room for
+    String csv;
+    for (uint8_t profile = 0; profile <= CsvImport::MAX_PROFILES; profile++) {
+        for (int copy = 0; copy < 100; copy++) {
+            csv += "p" + String(profile) + ",monday,08:00\n";
+        }
+    }
+    String result;
+    scheduleManager.beginCsvImport();
+    scheduleManager.importCsvChunk((const uint8_t*)csv.c_str(), csv.length());
+    check(scheduleManager.csvImport->ringCount == CsvImport::MAX_PROFILES, "duplicate CSV rows are counted once");
+    check(!scheduleManager.finishCsvImport(result) && result.indexOf("more than") >= 0, "a CSV file with too many profiles is refused");
+
+    printf(failures == 0 ? "OK\n" : "FAILED\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the Arduino core when the ring checks are compiled for the host. Only what
+scheduleManager.cpp and the headers it includes use is provided.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+using std::max;
+using std::min;
+
+template <typename T> T constrain(T value, T low, T high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+unsigned long millis();
+
+class String : public std::string {
+public:
+    String() {}
+    String(const char* text) : std::string(text) {}
+    String(const std::string& text) : std::string(text) {}
+    String(char c) : std::string(1, c) {}
+    String(int value) : std::string(std::to_string(value)) {}
+    String(unsigned int value) : std::string(std::to_string(value)) {}
+    String(long value) : std::string(std::to_string(value)) {}
+    String(unsigned long value) : std::string(std::to_string(value)) {}
+    String(long long value) : std::string(std::to_string(value)) {}
+    String(unsigned long long value) : std::string(std::to_string(value)) {}
+
+    unsigned int length() const { return size(); }
+    bool isEmpty() const { return empty(); }
+    long toInt() const { return atol(c_str()); }
+    String substring(unsigned int from) const { return from < size() ? substr(from) : ""; }
+    String substring(unsigned int from, unsigned int to) const { return from < size() ? substr(from, to - from) : ""; }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t at = find(c, from);
+        return at == npos ? -1 : (int)at;
+    }
+    int indexOf(const char* text, unsigned int from = 0) const {
+        size_t at = find(text, from);
+        return at == npos ? -1 : (int)at;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) write(data[i]);
+        return length;
+    }
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.size()); }
+    size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(char c) { return write((uint8_t)c); }
+};
+
+#endif
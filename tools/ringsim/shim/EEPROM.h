@@ -0,0 +1,12 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the ESP8266 EEPROM library on the host, the simulation keeps no settings.
+*/
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <Arduino.h>
+
+#endif
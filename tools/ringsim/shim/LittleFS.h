@@ -0,0 +1,13 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for LittleFS on the host. The simulation replaces the schedule store, so no file
+is ever opened.
+*/
+
+#ifndef LittleFS_h
+#define LittleFS_h
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,14 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the ESP8266 Ticker on the host, the simulated relay never uses it.
+*/
+
+#ifndef Ticker_h
+#define Ticker_h
+
+#include <Arduino.h>
+
+class Ticker {};
+
+#endif
@@ -0,0 +1,12 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for the ESP8266 UDP class on the host, the simulated clock never uses it.
+*/
+
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include <Arduino.h>
+
+#endif
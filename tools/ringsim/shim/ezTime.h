@@ -0,0 +1,14 @@
+/*
+Quinton Nelson
+10/19/2026
+This file stands in for ezTime on the host. The simulated clock does not use time zones.
+*/
+
+#ifndef ezTime_h
+#define ezTime_h
+
+#include <Arduino.h>
+
+class Timezone {};
+
+#endif
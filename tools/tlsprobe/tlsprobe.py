@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Quinton Nelson
+10/19/2026
+Measures the TLS handshake cost of the bell system's HTTPS server from a host on the LAN. The first
+connection makes a full handshake, every following one offers the session of the one before, so the
+device can resume it from its session cache. Prints the time of each handshake, whether the session
+was resumed, the hit rate, and the device's own handshake metrics from /getStatus.
+
+Usage: python3 tlsprobe.py host [connections] [port]
+"""
+
+import json
+import socket
+import ssl
+import sys
+import time
+
+
+def connect(host, port, context, session):
+    """Opens one TLS connection and returns it with the handshake time in ms (TCP connect excluded)."""
+    raw = socket.create_connection((host, port), timeout=10)
+    start = time.perf_counter()
+    tls = context.wrap_socket(raw, server_hostname=host, session=session)
+    return tls, (time.perf_counter() - start) * 1000
+
+
+def get_status(tls, host):
+    """Sends GET /getStatus on an open connection and returns the parsed JSON document."""
+    tls.sendall(("GET /getStatus HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n" % host).encode())
+    response = b""
+    while True:
+        chunk = tls.recv(4096)
+        if not chunk:
+            break
+        response += chunk
+    _, _, body = response.partition(b"\r\n\r\n")
+    return json.loads(body)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__.strip().splitlines()[-1])
+        sys.exit(2)
+    host = sys.argv[1]
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+    port = int(sys.argv[3]) if len(sys.argv) > 3 else 443
+
+    # The device certificate is usually self signed, only the handshake is measured here
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.maximum_version = ssl.TLSVersion.TLSv1_2  # BearSSL resumes TLS 1.2 sessions by session ID
+
+    full, resumed = [], []
+    session = None
+    status = None
+    for number in range(count):
+        tls, elapsed = connect(host, port, context, session)
+        reused = tls.session_reused
+        (resumed if reused else full).append(elapsed)
+        print("%3d  %8.1f ms  %s  %s" % (number + 1, elapsed, "resumed" if reused else "full   ", tls.cipher()[0]))
+
+        session = tls.session
+        if number == count - 1:
+            status = get_status(tls, host)
+        tls.close()
+
+    print()
+    if full:
+        print("full handshakes:    %d, average %.1f ms" % (len(full), sum(full) / len(full)))
+    if resumed:
+        print("resumed handshakes: %d, average %.1f ms" % (len(resumed), sum(resumed) / len(resumed)))
+    if count > 1:
+        print("session cache hit rate: %.0f%%" % (100.0 * len(resumed) / (count - 1)))
+
+    device = (status or {}).get("https")
+    if device:
+        print("device: %d handshakes, %d fast, %d failed, last %d ms, average %d ms, max %d ms" % (
+            device["handshakes"], device["fastHandshakes"], device["failedHandshakes"],
+            device["lastHandshakeMs"], device["averageHandshakeMs"], device["maxHandshakeMs"]))
+
+
+if __name__ == "__main__":
+    main()